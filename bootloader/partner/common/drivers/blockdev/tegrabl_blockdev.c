@@ -297,6 +297,431 @@ static tegrabl_error_t tegrabl_blockdev_default_write_block(tegrabl_bdev_t *dev,
 
 	return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 2);
 }
+
+/**
+ * @brief Returns the device holding the request queue of the given one.
+ * Devices on the same controller share a queue, so that only one transfer
+ * is in flight at the controller.
+ */
+static inline tegrabl_bdev_t *blockdev_xfer_queue_dev(tegrabl_bdev_t *dev)
+{
+	return (dev->xfer_queue_dev != NULL) ? dev->xfer_queue_dev : dev;
+}
+
+static tegrabl_error_t blockdev_xfer_alloc_queue(tegrabl_bdev_t *dev)
+{
+	dev = blockdev_xfer_queue_dev(dev);
+
+	if (dev->xfer_queue != NULL) {
+		return TEGRABL_NO_ERROR;
+	}
+
+	dev->xfer_queue = tegrabl_calloc(TEGRABL_BLOCKDEV_AIO_QUEUE_DEPTH,
+									 sizeof(tegrabl_aio_t));
+	if (dev->xfer_queue == NULL) {
+		return TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 3);
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+static void blockdev_xfer_done(tegrabl_bdev_t *dev, tegrabl_aio_t *aio,
+	tegrabl_error_t status)
+{
+	aio->status = status;
+	aio->state = TEGRABL_AIO_STATE_DONE;
+
+#if defined(CONFIG_ENABLE_BLOCKDEV_KPI)
+	profile_xfer_end(dev, aio);
+#else
+	TEGRABL_UNUSED(dev);
+#endif
+}
+
+static void blockdev_xfer_start(tegrabl_bdev_t *dev, tegrabl_aio_t *aio)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	bool is_write = (aio->flags & TEGRABL_AIO_FLAG_WRITE) != 0U;
+
+	pr_debug("start xfer %u: block %u, count %u, %s\n", aio->xfer_id,
+			 aio->block, (uint32_t)aio->count, is_write ? "write" : "read");
+
+	aio->state = TEGRABL_AIO_STATE_IN_PROGRESS;
+
+	if ((dev->xfer_poll != NULL) && is_write &&
+		(dev->async_write_block != NULL)) {
+		error = dev->async_write_block(dev, aio);
+	} else if ((dev->xfer_poll != NULL) && !is_write &&
+			   (dev->async_read_block != NULL)) {
+		error = dev->async_read_block(dev, aio);
+	} else {
+		/* No asynchronous backend, complete the request right here */
+		if (is_write) {
+			error = dev->write_block(dev, aio->buf, aio->block,
+									 (bnum_t)aio->count);
+		} else {
+			error = dev->read_block(dev, aio->buf, aio->block,
+									(bnum_t)aio->count);
+		}
+		blockdev_xfer_done(dev, aio, error);
+		return;
+	}
+
+	if (error != TEGRABL_NO_ERROR) {
+		blockdev_xfer_done(dev, aio, error);
+	}
+}
+
+/**
+ * @brief Moves the request queue of the device forward. Only one request is
+ * kept in flight at the hardware, remaining ones are started in submission
+ * order once the active one is completed.
+ *
+ * @param dev Block device handle
+ *
+ * @return true if there are still requests which are not completed.
+ */
+static bool blockdev_xfer_progress(tegrabl_bdev_t *dev)
+{
+	tegrabl_aio_t *active;
+	tegrabl_aio_t *next;
+	tegrabl_error_t error;
+	uint32_t i;
+
+	dev = blockdev_xfer_queue_dev(dev);
+	if (dev->xfer_queue == NULL) {
+		return false;
+	}
+
+	do {
+		active = NULL;
+		next = NULL;
+
+		for (i = 0; i < TEGRABL_BLOCKDEV_AIO_QUEUE_DEPTH; i++) {
+			tegrabl_aio_t *aio = &dev->xfer_queue[i];
+
+			if (aio->state == TEGRABL_AIO_STATE_IN_PROGRESS) {
+				active = aio;
+			} else if ((aio->state == TEGRABL_AIO_STATE_QUEUED) &&
+					   ((next == NULL) ||
+					   ((int32_t)(aio->xfer_id - next->xfer_id) < 0))) {
+				next = aio;
+			} else {
+				/* No action required */
+			}
+		}
+
+		/* Request may belong to any device sharing the queue */
+		if (active != NULL) {
+			error = active->dev->xfer_poll(active->dev, active);
+			if (TEGRABL_ERROR_REASON(error) == TEGRABL_ERR_BUSY) {
+				return true;
+			}
+			blockdev_xfer_done(active->dev, active, error);
+		}
+
+		if (next != NULL) {
+			blockdev_xfer_start(next->dev, next);
+		}
+	} while (next != NULL);
+
+	return false;
+}
+
+/**
+ * @brief Completes all the outstanding requests of the device. Synchronous
+ * requests have to wait for the queue to drain before they can use the
+ * controller.
+ */
+static void blockdev_xfer_drain(tegrabl_bdev_t *dev)
+{
+	while (blockdev_xfer_progress(dev)) {
+		;
+	}
+}
+#endif
+
+#if defined(CONFIG_ENABLE_BLOCKDEV_CACHE)
+/* Size of one cache line, has to be a multiple of the block size. */
+#define BLOCKDEV_CACHE_LINE_SIZE	(16U * 1024U)
+/* Lines filled by one read once the reads turn out to be sequential. */
+#define BLOCKDEV_CACHE_READ_AHEAD_LINES	4U
+/* Reads larger than this go straight to the device. */
+#define BLOCKDEV_CACHE_MAX_READ_SIZE	(64U * 1024U)
+
+struct blockdev_cache_line {
+	/* Position in the lru list, most recently used at head */
+	struct list_node node;
+	/* Device whose blocks are cached, NULL if line is free */
+	tegrabl_bdev_t *dev;
+	/* First block held by the line */
+	bnum_t block;
+};
+
+struct blockdev_cache {
+	struct blockdev_cache_line *lines;
+	uint8_t *data;
+	uint32_t num_lines;
+	struct list_node lru;
+	bool is_initialized;
+};
+
+static struct blockdev_cache cache;
+
+static tegrabl_error_t blockdev_cache_init(void)
+{
+	uint32_t i;
+
+	if (cache.is_initialized) {
+		return (cache.num_lines != 0U) ? TEGRABL_NO_ERROR :
+			TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 4);
+	}
+
+	cache.is_initialized = true;
+	cache.num_lines = CONFIG_BLOCKDEV_CACHE_SIZE / BLOCKDEV_CACHE_LINE_SIZE;
+	if (cache.num_lines == 0U) {
+		return TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 4);
+	}
+
+	cache.lines = tegrabl_calloc(cache.num_lines, sizeof(*cache.lines));
+	cache.data = tegrabl_alloc_align(TEGRABL_HEAP_DMA, 64,
+		(size_t)cache.num_lines * BLOCKDEV_CACHE_LINE_SIZE);
+	if ((cache.lines == NULL) || (cache.data == NULL)) {
+		pr_warn("Failed to allocate block device cache\n");
+		if (cache.data != NULL) {
+			tegrabl_dealloc(TEGRABL_HEAP_DMA, cache.data);
+		}
+		tegrabl_free(cache.lines);
+		cache.lines = NULL;
+		cache.data = NULL;
+		cache.num_lines = 0;
+		return TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 4);
+	}
+
+	list_initialize(&cache.lru);
+	for (i = 0; i < cache.num_lines; i++) {
+		list_add_tail(&cache.lru, &cache.lines[i].node);
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+static inline uint8_t *blockdev_cache_line_data(struct blockdev_cache_line *line)
+{
+	return cache.data + ((size_t)(line - cache.lines) *
+		BLOCKDEV_CACHE_LINE_SIZE);
+}
+
+static struct blockdev_cache_line *blockdev_cache_lookup(tegrabl_bdev_t *dev,
+	bnum_t line_block)
+{
+	uint32_t i;
+
+	for (i = 0; i < cache.num_lines; i++) {
+		if ((cache.lines[i].dev == dev) &&
+			(cache.lines[i].block == line_block)) {
+			return &cache.lines[i];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Drops the cached copies of the given blocks of device. Has to be
+ * called before the blocks are modified on the device.
+ *
+ * @param dev Block device handle
+ * @param block Start block
+ * @param count Number of blocks, or 0 to drop all blocks of device
+ */
+static void blockdev_cache_invalidate(tegrabl_bdev_t *dev, bnum_t block,
+	bnum_t count)
+{
+	struct blockdev_cache_line *line;
+	bnum_t line_blocks;
+	uint32_t i;
+
+	if (cache.num_lines == 0U) {
+		return;
+	}
+
+	line_blocks = BLOCKDEV_CACHE_LINE_SIZE >> dev->block_size_log2;
+
+	for (i = 0; i < cache.num_lines; i++) {
+		line = &cache.lines[i];
+		if (line->dev != dev) {
+			continue;
+		}
+		if ((count == 0U) || ((line->block < (block + count)) &&
+			((line->block + line_blocks) > block))) {
+			line->dev = NULL;
+			list_delete(&line->node);
+			list_add_tail(&cache.lru, &line->node);
+		}
+	}
+}
+
+/**
+ * @brief Checks if read-ahead may take over the line, that is if the line is
+ * free or one of the least recently used lines which the next misses would
+ * evict anyway.
+ *
+ * @param line Cache line
+ *
+ * @return true if line may be replaced.
+ */
+static bool blockdev_cache_line_is_expendable(struct blockdev_cache_line *line)
+{
+	struct list_node *node;
+	uint32_t i;
+
+	if (line->dev == NULL) {
+		return true;
+	}
+
+	node = list_peek_tail(&cache.lru);
+	for (i = 0; (i < BLOCKDEV_CACHE_READ_AHEAD_LINES) && (node != NULL); i++) {
+		if (node == &line->node) {
+			return true;
+		}
+		node = list_prev(&cache.lru, node);
+	}
+
+	return false;
+}
+
+/**
+ * @brief Reads the line holding given block into the cache. If the previous
+ * miss was on the line just before, following lines are read too with the
+ * same request, as long as the lines after the victim are expendable.
+ *
+ * @param dev Block device handle
+ * @param line_block First block of the line
+ * @param line Updated with the line holding the block
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error.
+ */
+static tegrabl_error_t blockdev_cache_fill(tegrabl_bdev_t *dev,
+	bnum_t line_block, struct blockdev_cache_line **line)
+{
+	struct blockdev_cache_line *victim;
+	bnum_t line_blocks = BLOCKDEV_CACHE_LINE_SIZE >> dev->block_size_log2;
+	bnum_t count;
+	uint32_t num = 1;
+	uint32_t max_num;
+	uint32_t first;
+	uint32_t i;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	/* Lines read together have to be adjacent in the cache; take the run
+	 * starting at the least recently used line, and stop at the first line
+	 * which is still in use.
+	 */
+	victim = containerof(list_peek_tail(&cache.lru),
+		struct blockdev_cache_line, node);
+	first = (uint32_t)(victim - cache.lines);
+
+	if (line_block == dev->cache_next_block) {
+		max_num = MIN(BLOCKDEV_CACHE_READ_AHEAD_LINES,
+			cache.num_lines - first);
+		while ((num < max_num) &&
+			((line_block + (num * line_blocks)) < dev->block_count) &&
+			blockdev_cache_line_is_expendable(&cache.lines[first + num]) &&
+			(blockdev_cache_lookup(dev, line_block + (num * line_blocks)) ==
+				NULL)) {
+			num++;
+		}
+	}
+
+	count = MIN(num * line_blocks, dev->block_count - line_block);
+
+	for (i = first; i < (first + num); i++) {
+		cache.lines[i].dev = NULL;
+	}
+
+	error = dev->read_block(dev, blockdev_cache_line_data(victim), line_block,
+		count);
+	if (error != TEGRABL_NO_ERROR) {
+		return error;
+	}
+
+	for (i = 0; i < num; i++) {
+		cache.lines[first + i].dev = dev;
+		cache.lines[first + i].block = line_block + (i * line_blocks);
+		list_delete(&cache.lines[first + i].node);
+		list_add_head(&cache.lru, &cache.lines[first + i].node);
+	}
+
+	dev->cache_misses++;
+	dev->cache_read_ahead += num - 1U;
+	dev->cache_next_block = line_block + (num * line_blocks);
+	*line = victim;
+
+	return TEGRABL_NO_ERROR;
+}
+
+/**
+ * @brief Reads blocks through the cache. Large reads, reads of rpmb whose
+ * frames must not be replayed, and reads of devices with blocks bigger than a
+ * cache line bypass the cache.
+ *
+ * @param dev Block device handle
+ * @param buf Destination buffer
+ * @param block Start block
+ * @param count Number of blocks
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error.
+ */
+static tegrabl_error_t blockdev_cache_read(tegrabl_bdev_t *dev, void *buf,
+	bnum_t block, bnum_t count)
+{
+	struct blockdev_cache_line *line;
+	uint8_t *dst = (uint8_t *)buf;
+	bnum_t line_blocks;
+	bnum_t line_block;
+	bnum_t offset;
+	bnum_t num;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	if ((tegrabl_blockdev_get_storage_type(dev) ==
+			TEGRABL_STORAGE_SDMMC_RPMB) ||
+		(TEGRABL_BLOCKDEV_BLOCK_SIZE(dev) > BLOCKDEV_CACHE_LINE_SIZE) ||
+		(((uint64_t)count << dev->block_size_log2) >
+			BLOCKDEV_CACHE_MAX_READ_SIZE) ||
+		(blockdev_cache_init() != TEGRABL_NO_ERROR)) {
+		return dev->read_block(dev, buf, block, count);
+	}
+
+	line_blocks = BLOCKDEV_CACHE_LINE_SIZE >> dev->block_size_log2;
+
+	while (count > 0U) {
+		line_block = block - (block % line_blocks);
+		offset = block - line_block;
+		num = MIN(count, line_blocks - offset);
+
+		line = blockdev_cache_lookup(dev, line_block);
+		if (line != NULL) {
+			dev->cache_hits++;
+			list_delete(&line->node);
+			list_add_head(&cache.lru, &line->node);
+		} else {
+			error = blockdev_cache_fill(dev, line_block, &line);
+			if (error != TEGRABL_NO_ERROR) {
+				return error;
+			}
+		}
+
+		memcpy(dst, blockdev_cache_line_data(line) +
+			(offset << dev->block_size_log2), num << dev->block_size_log2);
+
+		dst += num << dev->block_size_log2;
+		block += num;
+		count -= num;
+	}
+
+	return TEGRABL_NO_ERROR;
+}
 #endif
 
 static void bdev_inc_ref(tegrabl_bdev_t *dev)
@@ -327,6 +752,10 @@ static tegrabl_error_t bdev_dec_ref(tegrabl_bdev_t *dev)
 		if (dev->close != NULL)
 			dev->close(dev);
 
+#if defined(CONFIG_ENABLE_BLOCKDEV_CACHE)
+		blockdev_cache_invalidate(dev, 0, 0);
+#endif
+
 		tegrabl_free(dev);
 	}
 fail:
@@ -405,7 +834,29 @@ tegrabl_error_t tegrabl_blockdev_close(tegrabl_bdev_t *dev)
 
 void tegrabl_blockdev_list_kpi(void)
 {
+#if defined(CONFIG_ENABLE_BLOCKDEV_CACHE)
+	tegrabl_bdev_t *entry;
+#endif
+
+#if defined(CONFIG_ENABLE_BLOCKDEV_KPI)
 	list_kpi(bdevs);
+#endif
+
+#if defined(CONFIG_ENABLE_BLOCKDEV_CACHE)
+	list_for_every_entry(&bdevs->list, entry, tegrabl_bdev_t, node) {
+		pr_info("dev %08x: cache hits = %"PRIu64", misses = %"PRIu64
+				", read ahead lines = %"PRIu64"\n", entry->device_id,
+				entry->cache_hits, entry->cache_misses,
+				entry->cache_read_ahead);
+	}
+#endif
+}
+
+void tegrabl_blockdev_export_kpi(void)
+{
+#if defined(CONFIG_ENABLE_BLOCKDEV_KPI)
+	export_kpi();
+#endif
 }
 
 tegrabl_error_t tegrabl_blockdev_read(tegrabl_bdev_t *dev, void *buf,
@@ -473,7 +924,15 @@ tegrabl_error_t tegrabl_blockdev_read_block(tegrabl_bdev_t *dev, void *buf,
 		goto fail;
 	}
 
+#if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
+	blockdev_xfer_drain(dev);
+#endif
+
+#if defined(CONFIG_ENABLE_BLOCKDEV_CACHE)
+	error = blockdev_cache_read(dev, buf, block, count);
+#else
 	error = dev->read_block(dev, buf, block, count);
+#endif
 	if (error != TEGRABL_NO_ERROR) {
 		TEGRABL_SET_HIGHEST_MODULE(error);
 		goto fail;
@@ -555,6 +1014,12 @@ tegrabl_error_t tegrabl_blockdev_write_block(tegrabl_bdev_t *dev,
 		goto fail;
 	}
 
+	blockdev_xfer_drain(dev);
+
+#if defined(CONFIG_ENABLE_BLOCKDEV_CACHE)
+	blockdev_cache_invalidate(dev, block, count);
+#endif
+
 	error = dev->write_block(dev, buf, block, count);
 	if (error != TEGRABL_NO_ERROR) {
 		TEGRABL_SET_HIGHEST_MODULE(error);
@@ -595,6 +1060,12 @@ tegrabl_error_t tegrabl_blockdev_erase(tegrabl_bdev_t *dev, bnum_t block,
 		goto fail;
 	}
 
+	blockdev_xfer_drain(dev);
+
+#if defined(CONFIG_ENABLE_BLOCKDEV_CACHE)
+	blockdev_cache_invalidate(dev, block, count);
+#endif
+
 	error = dev->erase(dev, block, count, is_secure);
 	if (error != TEGRABL_NO_ERROR) {
 		TEGRABL_SET_HIGHEST_MODULE(error);
@@ -617,26 +1088,150 @@ tegrabl_error_t tegrabl_blockdev_erase_all(tegrabl_bdev_t *dev, bool is_secure)
 	return tegrabl_blockdev_erase(dev, 0, dev->block_count, is_secure);
 }
 
+static tegrabl_aio_t *blockdev_xfer_submit(tegrabl_bdev_t *dev, void *buf,
+	bnum_t block, bnum_t count, uint32_t flags)
+{
+	tegrabl_aio_t *aio = NULL;
+	tegrabl_bdev_t *queue_dev = NULL;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	uint32_t i;
+#if defined(CONFIG_ENABLE_BLOCKDEV_KPI)
+	uint32_t depth;
+#endif
+
+	if ((dev == NULL) || (buf == NULL) || (count == 0)) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 22);
+		goto fail;
+	}
+
+	if (dev->ref <= 0) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 23);
+		goto fail;
+	}
+
+	/* range check */
+	if ((block > dev->block_count) || ((block + count) > dev->block_count)) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 5);
+		goto fail;
+	}
+
+	error = blockdev_xfer_alloc_queue(dev);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	queue_dev = blockdev_xfer_queue_dev(dev);
+	for (i = 0; i < TEGRABL_BLOCKDEV_AIO_QUEUE_DEPTH; i++) {
+		if (queue_dev->xfer_queue[i].state == TEGRABL_AIO_STATE_FREE) {
+			aio = &queue_dev->xfer_queue[i];
+			break;
+		}
+	}
+
+	if (aio == NULL) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_RESOURCE_MAX, 0);
+		goto fail;
+	}
+
+#if defined(CONFIG_ENABLE_BLOCKDEV_CACHE)
+	if ((flags & TEGRABL_AIO_FLAG_WRITE) != 0U) {
+		blockdev_cache_invalidate(dev, block, count);
+	}
+#endif
+
+	aio->xfer_id = queue_dev->xfer_next_id++;
+	aio->status = TEGRABL_NO_ERROR;
+	aio->buf = buf;
+	aio->block = block;
+	aio->count = count;
+	aio->flags = flags;
+	aio->dev = dev;
+	aio->state = TEGRABL_AIO_STATE_QUEUED;
+
+#if defined(CONFIG_ENABLE_BLOCKDEV_KPI)
+	depth = 0;
+	for (i = 0; i < TEGRABL_BLOCKDEV_AIO_QUEUE_DEPTH; i++) {
+		if ((queue_dev->xfer_queue[i].state == TEGRABL_AIO_STATE_QUEUED) ||
+			(queue_dev->xfer_queue[i].state ==
+			 TEGRABL_AIO_STATE_IN_PROGRESS)) {
+			depth++;
+		}
+	}
+	profile_xfer_submit(dev, aio, depth);
+#endif
+
+	pr_debug("dev '%d', queued xfer %u: buf %p, block %u, count %u\n",
+			 dev->device_id, aio->xfer_id, buf, block, count);
+
+	/* Start the request immediately if the device is free */
+	blockdev_xfer_progress(dev);
+
+fail:
+	if (error != TEGRABL_NO_ERROR) {
+		pr_error("%s: exit error = %x\n", __func__, error);
+	}
+	return aio;
+}
+
 tegrabl_aio_t *tegrabl_blockdev_async_read_block(tegrabl_bdev_t *dev, void *buf,
 	bnum_t block, bnum_t count)
 {
-	/* TODO */
-	TEGRABL_UNUSED(dev);
-	TEGRABL_UNUSED(buf);
-	TEGRABL_UNUSED(block);
-	TEGRABL_UNUSED(count);
-	return NULL;
+	return blockdev_xfer_submit(dev, buf, block, count, 0);
 }
 
 tegrabl_aio_t *tegrabl_blockdev_async_write_block(tegrabl_bdev_t *dev,
 	const void *buf, bnum_t block, bnum_t count)
 {
-	/* TODO */
-	TEGRABL_UNUSED(dev);
-	TEGRABL_UNUSED(buf);
-	TEGRABL_UNUSED(block);
-	TEGRABL_UNUSED(count);
-	return NULL;
+	return blockdev_xfer_submit(dev, (void *)buf, block, count,
+								TEGRABL_AIO_FLAG_WRITE);
+}
+
+tegrabl_error_t tegrabl_blockdev_xfer_poll(tegrabl_bdev_t *dev,
+	tegrabl_aio_t *aio)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	tegrabl_aio_t *queue = NULL;
+
+	if (dev != NULL) {
+		queue = blockdev_xfer_queue_dev(dev)->xfer_queue;
+	}
+
+	if ((dev == NULL) || (aio == NULL) || (queue == NULL) ||
+		(aio < queue) || (aio >= (queue + TEGRABL_BLOCKDEV_AIO_QUEUE_DEPTH)) ||
+		(aio->dev != dev) || (aio->state == TEGRABL_AIO_STATE_FREE)) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 24);
+		goto fail;
+	}
+
+	blockdev_xfer_progress(dev);
+
+	if (aio->state != TEGRABL_AIO_STATE_DONE) {
+		return TEGRABL_ERROR(TEGRABL_ERR_BUSY, 0);
+	}
+
+	error = aio->status;
+	aio->state = TEGRABL_AIO_STATE_FREE;
+	if (error != TEGRABL_NO_ERROR) {
+		TEGRABL_SET_HIGHEST_MODULE(error);
+	}
+
+fail:
+	if (error != TEGRABL_NO_ERROR) {
+		pr_error("%s: exit error = %x\n", __func__, error);
+	}
+	return error;
+}
+
+tegrabl_error_t tegrabl_blockdev_xfer_wait(tegrabl_bdev_t *dev,
+	tegrabl_aio_t *aio)
+{
+	tegrabl_error_t error;
+
+	do {
+		error = tegrabl_blockdev_xfer_poll(dev, aio);
+	} while (TEGRABL_ERROR_REASON(error) == TEGRABL_ERR_BUSY);
+
+	return error;
 }
 #endif
 
@@ -657,6 +1252,10 @@ tegrabl_error_t tegrabl_blockdev_ioctl(tegrabl_bdev_t *dev, uint32_t ioctl,
 		bsize = (size_t *)args;
 		*bsize = TEGRABL_BLOCKDEV_BLOCK_SIZE(dev);
 	} else {
+#if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
+		/* Driver ioctls may issue commands to the controller */
+		blockdev_xfer_drain(dev);
+#endif
 		error = dev->ioctl(dev, ioctl, args);
 		if (error != TEGRABL_NO_ERROR) {
 			TEGRABL_SET_HIGHEST_MODULE(error);
@@ -8,13 +8,96 @@
  * license agreement from NVIDIA CORPORATION is strictly prohibited
  */
 
+#include <stdio.h>
 #include <tegrabl_blockdev.h>
 #include <tegrabl_blockdev_profiling.h>
 #include <tegrabl_error.h>
 #include <tegrabl_timer.h>
 #include <tegrabl_debug.h>
+#include <tegrabl_profiler.h>
+#include <tegrabl_utils.h>
 #include <inttypes.h>
 
+struct blockdev_kpi {
+	struct blockdev_kpi_stats read;
+	struct blockdev_kpi_stats write;
+	uint32_t max_queue_depth;
+	uint32_t queue_depth_hist[TEGRABL_BLOCKDEV_AIO_QUEUE_DEPTH + 1U];
+};
+
+static struct blockdev_kpi kpi[TEGRABL_STORAGE_INVALID];
+
+static const char * const storage_name[TEGRABL_STORAGE_INVALID] = {
+	[TEGRABL_STORAGE_SDMMC_BOOT] = "sdmmc_boot",
+	[TEGRABL_STORAGE_SDMMC_USER] = "sdmmc_user",
+	[TEGRABL_STORAGE_SDMMC_RPMB] = "sdmmc_rpmb",
+	[TEGRABL_STORAGE_QSPI_FLASH] = "qspi",
+	[TEGRABL_STORAGE_SATA] = "sata",
+	[TEGRABL_STORAGE_SDCARD] = "sdcard",
+	[TEGRABL_STORAGE_USB_MS] = "usb_ms",
+	[TEGRABL_STORAGE_UFS] = "ufs",
+};
+
+static struct blockdev_kpi *kpi_of(tegrabl_bdev_t *dev)
+{
+	uint16_t type = tegrabl_blockdev_get_storage_type(dev);
+
+	if (type >= TEGRABL_STORAGE_INVALID) {
+		return NULL;
+	}
+
+	return &kpi[type];
+}
+
+/**
+* @brief Returns the log2 bucket of value, clamped to the histogram size
+*/
+static uint32_t kpi_bucket(uint64_t value, uint32_t shift, uint32_t buckets)
+{
+	uint32_t bucket = 0;
+
+	value >>= shift;
+	while ((value > 1U) && (bucket < (buckets - 1U))) {
+		value = (value + 1U) >> 1;
+		bucket++;
+	}
+
+	return bucket;
+}
+
+static void kpi_add(struct blockdev_kpi_stats *stats, uint64_t size,
+	time_t latency)
+{
+	stats->requests++;
+	stats->bytes += size;
+	stats->time += latency;
+	stats->size_hist[kpi_bucket(size, BLOCKDEV_KPI_SIZE_SHIFT,
+		BLOCKDEV_KPI_SIZE_BUCKETS)]++;
+	stats->latency_hist[kpi_bucket(latency, 0,
+		BLOCKDEV_KPI_LATENCY_BUCKETS)]++;
+}
+
+/**
+* @brief Returns the upper bound in us of the latency bucket below which the
+*        given percent of requests completed
+*/
+static uint64_t kpi_latency_percentile(struct blockdev_kpi_stats *stats,
+	uint32_t percent)
+{
+	uint64_t limit = (stats->requests * percent + 99U) / 100U;
+	uint64_t seen = 0;
+	uint32_t i;
+
+	for (i = 0; i < BLOCKDEV_KPI_LATENCY_BUCKETS; i++) {
+		seen += stats->latency_hist[i];
+		if (seen >= limit) {
+			break;
+		}
+	}
+
+	return (uint64_t)1 << MIN(i, BLOCKDEV_KPI_LATENCY_BUCKETS - 1U);
+}
+
 void profile_read_start(tegrabl_bdev_t *dev)
 {
 	dev->last_read_start_time = tegrabl_get_timestamp_us();
@@ -22,12 +105,19 @@ void profile_read_start(tegrabl_bdev_t *dev)
 
 void profile_read_end(tegrabl_bdev_t *dev, uint64_t size)
 {
+	struct blockdev_kpi *dev_kpi = kpi_of(dev);
+
 	dev->last_read_end_time = tegrabl_get_timestamp_us();
 	dev->total_read_time +=
 		(dev->last_read_end_time - dev->last_read_start_time);
 	if (size > 0) {
 		dev->total_read_size += size;
 	}
+
+	if (dev_kpi != NULL) {
+		kpi_add(&dev_kpi->read, size,
+			dev->last_read_end_time - dev->last_read_start_time);
+	}
 }
 
 void profile_write_start(tegrabl_bdev_t *dev)
@@ -37,12 +127,100 @@ void profile_write_start(tegrabl_bdev_t *dev)
 
 void profile_write_end(tegrabl_bdev_t *dev, uint64_t size)
 {
+	struct blockdev_kpi *dev_kpi = kpi_of(dev);
+
 	dev->last_write_end_time = tegrabl_get_timestamp_us();
 	dev->total_write_time += (dev->last_write_end_time -
 		dev->last_write_start_time);
 	if (size > 0) {
 		dev->total_write_size += size;
 	}
+
+	if (dev_kpi != NULL) {
+		kpi_add(&dev_kpi->write, size,
+			dev->last_write_end_time - dev->last_write_start_time);
+	}
+}
+
+void profile_xfer_submit(tegrabl_bdev_t *dev, tegrabl_aio_t *aio,
+	uint32_t depth)
+{
+	struct blockdev_kpi *dev_kpi = kpi_of(dev);
+
+	aio->submit_time = tegrabl_get_timestamp_us();
+
+	if (dev_kpi == NULL) {
+		return;
+	}
+
+	depth = MIN(depth, TEGRABL_BLOCKDEV_AIO_QUEUE_DEPTH);
+	dev_kpi->queue_depth_hist[depth]++;
+	if (depth > dev_kpi->max_queue_depth) {
+		dev_kpi->max_queue_depth = depth;
+	}
+}
+
+void profile_xfer_end(tegrabl_bdev_t *dev, tegrabl_aio_t *aio)
+{
+	struct blockdev_kpi *dev_kpi = kpi_of(dev);
+	uint64_t size = (uint64_t)aio->count << dev->block_size_log2;
+	time_t latency = tegrabl_get_timestamp_us() - aio->submit_time;
+
+	if ((aio->flags & TEGRABL_AIO_FLAG_WRITE) != 0U) {
+		dev->total_write_time += latency;
+		dev->total_write_size += size;
+		if (dev_kpi != NULL) {
+			kpi_add(&dev_kpi->write, size, latency);
+		}
+	} else {
+		dev->total_read_time += latency;
+		dev->total_read_size += size;
+		if (dev_kpi != NULL) {
+			kpi_add(&dev_kpi->read, size, latency);
+		}
+	}
+}
+
+#define KPI_LINE_LEN	256U
+
+/**
+* @brief Formats the non-empty buckets of a log2 histogram into line
+*/
+static void kpi_format_hist(char *line, const char *name, uint32_t *hist,
+	uint32_t buckets, uint32_t shift)
+{
+	uint32_t len;
+	uint32_t i;
+
+	len = (uint32_t)snprintf(line, KPI_LINE_LEN, "%s:", name);
+	for (i = 0; (i < buckets) && (len < KPI_LINE_LEN); i++) {
+		if (hist[i] != 0U) {
+			len += (uint32_t)snprintf(line + len, KPI_LINE_LEN - len,
+					" <=%"PRIu64":%u", (uint64_t)1 << (i + shift), hist[i]);
+		}
+	}
+}
+
+static void list_kpi_stats(const char *dir, struct blockdev_kpi_stats *stats)
+{
+	char line[KPI_LINE_LEN];
+
+	if (stats->requests == 0U) {
+		return;
+	}
+
+	pr_info("  %s: %"PRIu64" requests, %"PRIu64" KB in %"PRIu64" us, "
+			"%"PRIu64" KB/s\n", dir, stats->requests, stats->bytes / 1024U,
+			stats->time, (stats->time != 0U) ?
+			((stats->bytes * 1000000U) / 1024U) / stats->time : 0U);
+
+	kpi_format_hist(line, "size (bytes)", stats->size_hist,
+			BLOCKDEV_KPI_SIZE_BUCKETS, BLOCKDEV_KPI_SIZE_SHIFT);
+	pr_info("    %s\n", line);
+
+	kpi_format_hist(line, "latency (us)", stats->latency_hist,
+			BLOCKDEV_KPI_LATENCY_BUCKETS, 0);
+	pr_info("    %s\n", line);
 }
 
 void list_kpi(struct tegrabl_bdev_struct *bdevs)
@@ -52,6 +230,10 @@ void list_kpi(struct tegrabl_bdev_struct *bdevs)
 	time_t write_time = 0;
 	uint64_t read_size = 0;
 	uint64_t write_size = 0;
+	char line[KPI_LINE_LEN];
+	uint32_t len;
+	uint32_t type;
+	uint32_t i;
 
 	list_for_every_entry(&bdevs->list, entry, tegrabl_bdev_t, node) {
 		read_time += entry->total_read_time;
@@ -60,9 +242,59 @@ void list_kpi(struct tegrabl_bdev_struct *bdevs)
 		write_size += entry->total_write_size;
 	}
 
-	pr_info("read time = %" PRIu64" ms, read size = %"PRIu64" KB\n",
-			read_time, read_size / 1000);
-	pr_info("write time = %" PRIu64" ms, write size = %"PRIu64" KB\n",
-			write_time, write_size / 1000);
+	pr_info("read time = %" PRIu64" us, read size = %"PRIu64" KB\n",
+			read_time, read_size / 1024);
+	pr_info("write time = %" PRIu64" us, write size = %"PRIu64" KB\n",
+			write_time, write_size / 1024);
+
+	for (type = 0; type < TEGRABL_STORAGE_INVALID; type++) {
+		if ((kpi[type].read.requests == 0U) &&
+			(kpi[type].write.requests == 0U)) {
+			continue;
+		}
+
+		pr_info("%s:\n", storage_name[type]);
+		list_kpi_stats("read", &kpi[type].read);
+		list_kpi_stats("write", &kpi[type].write);
+
+		if (kpi[type].max_queue_depth == 0U) {
+			continue;
+		}
+
+		len = (uint32_t)snprintf(line, sizeof(line), "queue depth:");
+		for (i = 1; (i <= TEGRABL_BLOCKDEV_AIO_QUEUE_DEPTH) &&
+			 (len < sizeof(line)); i++) {
+			if (kpi[type].queue_depth_hist[i] != 0U) {
+				len += (uint32_t)snprintf(line + len, sizeof(line) - len,
+						" %u:%u", i, kpi[type].queue_depth_hist[i]);
+			}
+		}
+		pr_info("  %s\n", line);
+	}
+}
+
+static void export_kpi_stats(const char *name, const char *dir,
+	struct blockdev_kpi_stats *stats)
+{
+	char str[MAX_PROFILE_STRLEN];
+
+	if (stats->requests == 0U) {
+		return;
+	}
+
+	snprintf(str, sizeof(str), "%s %s %"PRIu64"KB %"PRIu64"us n%"PRIu64
+			 " p50<%"PRIu64" p99<%"PRIu64, name, dir, stats->bytes / 1024U,
+			 stats->time, stats->requests,
+			 kpi_latency_percentile(stats, 50), kpi_latency_percentile(stats, 99));
+	tegrabl_profiler_record(str, 0, DETAILED);
 }
 
+void export_kpi(void)
+{
+	uint32_t type;
+
+	for (type = 0; type < TEGRABL_STORAGE_INVALID; type++) {
+		export_kpi_stats(storage_name[type], "rd", &kpi[type].read);
+		export_kpi_stats(storage_name[type], "wr", &kpi[type].write);
+	}
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2015, NVIDIA CORPORATION.  All rights reserved.
+ * Copyright (c) 2015-2017, NVIDIA CORPORATION.  All rights reserved.
  *
  * NVIDIA CORPORATION and its licensors retain all intellectual property
  * and proprietary rights in and to this software, related documentation
@@ -13,6 +13,30 @@
 #ifndef TEGRABL_BLOCKDEV_PROFILING_H
 #define TEGRABL_BLOCKDEV_PROFILING_H
 
+/**
+* @brief Number of log2 buckets of the request size histogram. First bucket
+*        counts requests up to 512 bytes, last one requests of 8MB and more.
+*/
+#define BLOCKDEV_KPI_SIZE_BUCKETS	15U
+#define BLOCKDEV_KPI_SIZE_SHIFT		9U
+
+/**
+* @brief Number of log2 buckets of the latency histogram. First bucket counts
+*        requests completed within 1us, last one requests taking 512ms or more.
+*/
+#define BLOCKDEV_KPI_LATENCY_BUCKETS	20U
+
+/**
+* @brief Statistics of one direction of transfers of a storage type
+*/
+struct blockdev_kpi_stats {
+	uint64_t requests;
+	uint64_t bytes;
+	time_t time;
+	uint32_t size_hist[BLOCKDEV_KPI_SIZE_BUCKETS];
+	uint32_t latency_hist[BLOCKDEV_KPI_LATENCY_BUCKETS];
+};
+
 /**
 * @brief Records the read start timestamp
 *
@@ -44,10 +68,36 @@ void profile_write_start(tegrabl_bdev_t *dev);
 void profile_write_end(tegrabl_bdev_t *dev, uint64_t size);
 
 /**
-* @brief Prints the kpi info total read and write time and speed
+* @brief Records the submission of an asynchronous request along with the
+*        number of requests outstanding on the device
+*
+* @param dev Block device handle
+* @param aio Asynchronous io handle
+* @param depth Requests queued or in progress including this one
+*/
+void profile_xfer_submit(tegrabl_bdev_t *dev, tegrabl_aio_t *aio,
+	uint32_t depth);
+
+/**
+* @brief Records the completion of an asynchronous request
+*
+* @param dev Block device handle
+* @param aio Asynchronous io handle
+*/
+void profile_xfer_end(tegrabl_bdev_t *dev, tegrabl_aio_t *aio);
+
+/**
+* @brief Prints the kpi info of each storage type: request count, size and
+*        latency histograms, queue depth and throughput
 *
 * @param bdevs Pointer to the Block device handles
 */
 void list_kpi(struct tegrabl_bdev_struct *bdevs);
 
+/**
+* @brief Adds a summary of the kpi info of each storage type to the boot
+*        profiler records
+*/
+void export_kpi(void);
+
 #endif
@@ -29,6 +29,7 @@
 #include <tegrabl_malloc.h>
 #include <tegrabl_clock.h>
 #include <tegrabl_uphy.h>
+#include <tegrabl_utils.h>
 
 /**
  * @brief Dumps ahci registers
@@ -94,23 +95,943 @@ fail:
 	return error;
 }
 
+/**
+ * @brief Read or write up to SATA_MAX_READ_WRITE_SECTORS sectors with
+ * a single non-queued DMA command issued from slot 0.
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error.
+ */
+static tegrabl_error_t tegrabl_sata_ahci_dma_io(
+		struct tegrabl_sata_context *context, void *buf, bnum_t block,
+		bnum_t count, bool is_write, time_t timeout)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	uint32_t reg = 0;
+	struct tegrabl_ahci_cmd_table *cmd_table;
+	struct tegrabl_ahci_prdt_entry *prdt_entry;
+	struct tegrabl_ahci_fis_h2d *fis;
+	dma_addr_t address = 0;
+	bool mapped_buf = false;
+	bool mapped_cmd_list = false;
+	bool mapped_cmd_table = false;
+	uint32_t block_size_log2 = context->block_size_log2;
+
+	pr_debug("Sata I/O block %d, count %d, ", block, count);
+	pr_debug("%s\n", is_write ? "writingg" : "reading");
+
+	cmd_table = (struct tegrabl_ahci_cmd_table *)&context->command_table[0];
+	prdt_entry = (struct tegrabl_ahci_prdt_entry *)&cmd_table->prdt_entry[0];
+	fis = (struct tegrabl_ahci_fis_h2d *)(&cmd_table->command_fis[0]);
+
+	memset(cmd_table, 0x0, sizeof(*cmd_table));
+
+	/* Fill Command FIS */
+	fis->fis_type = TEGRABL_AHCI_FIS_TYPE_REG_H2D;
+	fis->prc = (1 << 7);
+	fis->device = 0x40;
+
+	/* Use commands for 48 bit address if drive supports */
+	if (context->support_extended_cmd) {
+		fis->command = is_write ? SATA_COMMAND_DMA_WRITE_EXTENDED :
+								 SATA_COMMAND_DMA_READ_EXTENDED;
+	} else {
+		fis->command = is_write ? SATA_COMMAND_DMA_WRITE :
+								 SATA_COMMAND_DMA_READ;
+	}
+
+	/* Fill start sector information */
+	fis->lba0 = (uint8_t)(block & 0xFF);
+	fis->lba1 = (uint8_t)((block >> 8) & 0xFF);
+	fis->lba2 = (uint8_t)((block >> 16) & 0xFF);
+	fis->lba3 = (uint8_t)((block >> 24) & 0xFF);
+	block = block >> 24;
+	fis->lba4 = (uint8_t)((block >> 8) & 0xFF);
+	fis->lba5 = (uint8_t)((block >> 16) & 0xFF);
+
+	/* Fill number of sectors to be read */
+	fis->countl = (uint8_t)(count & 0xFF);
+	fis->counth = (uint8_t)((count >> 8) & 0xFF);
+
+	/* Map input buffer as per read/write and get physical address */
+	address = tegrabl_dma_map_buffer(TEGRABL_MODULE_SATA, context->instance,
+				buf, count << block_size_log2,
+				is_write ? TEGRABL_DMA_TO_DEVICE : TEGRABL_DMA_FROM_DEVICE);
+
+	mapped_buf = true;
+
+	pr_debug("Buffer addresss is %p\n", buf);
+	pr_debug("Dma address of buffer is %"PRIx64"\n", address);
+
+	if (!address) {
+		pr_debug("dma map returned zero address for buf.\n");
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+		goto fail;
+	}
+
+	/* Fill the prdt entry */
+	prdt_entry->address_low = (address & 0xFFFFFFFF);
+	prdt_entry->address_high = (((address >> 32) & 0xFFFFFFFF));
+	prdt_entry->irc = (1 << 31);
+	prdt_entry->irc |= ((count << block_size_log2) - 1);
+
+	/* Fill the command list. Use only one prdt entry. */
+	context->command_list_buf[0] = AHCI_CMD_HEADER_CFL | AHCI_CMD_HEADER_PRDTL;
+	if (is_write) {
+		context->command_list_buf[0] |= CMD_HEADER_WRITE;
+	}
+
+	context->command_list_buf[1] = count << block_size_log2;
+
+	/* Flush the updated command table and get its physical address */
+	address = tegrabl_dma_map_buffer(TEGRABL_MODULE_SATA, context->instance,
+			&context->command_table[0], TEGRABL_SATA_AHCI_COMMAND_TABLE_SIZE,
+			TEGRABL_DMA_TO_DEVICE);
+
+	mapped_cmd_table = true;
+
+	pr_debug("Dma address of command table is %"PRIx64"\n", address);
+
+	if (!address) {
+		pr_debug("dma map returned zero address for command table.\n");
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+		goto fail;
+	}
+
+	context->command_list_buf[2] = (address & 0xFFFFFFFF);
+	context->command_list_buf[3] = (((address >> 32) & 0xFFFFFFFF));
+
+	/* Flush command list buffer */
+	address = tegrabl_dma_map_buffer(TEGRABL_MODULE_SATA, context->instance,
+				&context->command_list_buf[0],
+				TEGRABL_SATA_AHCI_COMMAND_LIST_BUF_SIZE, TEGRABL_DMA_TO_DEVICE);
+	mapped_cmd_list = true;
+
+	pr_debug("Dma address of command list buffer is %"PRIx64"\n", address);
+
+	if (!address) {
+		pr_debug("dma map returned zero address for command list buf.\n");
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+		goto fail;
+	}
+
+	/* Enable appropriate interrupts */
+	reg = 0;
+	reg = NV_FLD_SET_DRF_NUM(AHCI, PORT_PXIE, DPE, 1, reg);
+
+	if (is_write) {
+		reg = NV_FLD_SET_DRF_NUM(AHCI, PORT_PXIE, DHRE, 1, reg);
+	}
+
+	NV_WRITE32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXIE_0, reg);
+
+	/* Initiate transaction and wait for completion or timeout */
+	error = tegrabl_sata_start_command(timeout);
+
+fail:
+	if (mapped_cmd_list) {
+		tegrabl_dma_unmap_buffer(TEGRABL_MODULE_SATA, context->instance,
+			&context->command_list_buf[0],
+			TEGRABL_SATA_AHCI_COMMAND_LIST_BUF_SIZE, TEGRABL_DMA_TO_DEVICE);
+	}
+
+	if (mapped_buf) {
+		tegrabl_dma_unmap_buffer(TEGRABL_MODULE_SATA, context->instance,
+			buf, count << block_size_log2,
+			is_write ? TEGRABL_DMA_TO_DEVICE : TEGRABL_DMA_FROM_DEVICE);
+	}
+
+	if (mapped_cmd_table) {
+		tegrabl_dma_unmap_buffer(TEGRABL_MODULE_SATA, context->instance,
+			&context->command_table[0], TEGRABL_SATA_AHCI_COMMAND_TABLE_SIZE,
+			TEGRABL_DMA_TO_DEVICE);
+	}
+
+	return error;
+}
+
+#if defined(CONFIG_ENABLE_SATA_NCQ)
+/**
+ * @brief Fills prdt entries of command table for a buffer which is
+ * contiguous in dma address space. Buffer is split at the maximum byte
+ * count a single prdt entry can describe.
+ *
+ * @param cmd_table Command table to be filled
+ * @param address Dma address of the buffer
+ * @param bytes Size of the buffer
+ *
+ * @return Number of prdt entries used.
+ */
+static uint32_t tegrabl_sata_ahci_fill_prdt(
+		struct tegrabl_ahci_cmd_table *cmd_table, dma_addr_t address,
+		uint32_t bytes)
+{
+	struct tegrabl_ahci_prdt_entry *prdt_entry = &cmd_table->prdt_entry[0];
+	uint32_t chunk = 0;
+	uint32_t num_prdt = 0;
+
+	while (bytes != 0U) {
+		chunk = MIN(bytes, (uint32_t)SATA_AHCI_PRDT_MAX_BYTES);
+		prdt_entry[num_prdt].address_low = (address & 0xFFFFFFFF);
+		prdt_entry[num_prdt].address_high = ((address >> 32) & 0xFFFFFFFF);
+		prdt_entry[num_prdt].irc = chunk - 1;
+		address += chunk;
+		bytes -= chunk;
+		num_prdt++;
+	}
+
+	/* Interrupt once the last entry is transferred */
+	prdt_entry[num_prdt - 1].irc |= (1U << 31);
+
+	return num_prdt;
+}
+
+/**
+ * @brief Fills command table and command header of specified slot with
+ * a READ/WRITE FPDMA QUEUED command. Command table address in the
+ * header is filled once the tables are mapped.
+ *
+ * @param context SATA context
+ * @param slot Command slot, also used as the NCQ tag
+ * @param address Dma address of the data
+ * @param block Start sector
+ * @param count Number of sectors, at most SATA_NCQ_MAX_SECTORS
+ * @param is_write True if write operation
+ */
+static void tegrabl_sata_ahci_ncq_fill_slot(
+		struct tegrabl_sata_context *context, uint32_t slot,
+		dma_addr_t address, bnum_t block, uint32_t count, bool is_write)
+{
+	struct tegrabl_ahci_cmd_table *cmd_table;
+	struct tegrabl_ahci_fis_h2d *fis;
+	uint32_t *cmd_header;
+	uint32_t num_prdt = 0;
+
+	cmd_table = (struct tegrabl_ahci_cmd_table *)
+		((uint8_t *)context->ncq_tables +
+		 (slot * TEGRABL_SATA_AHCI_NCQ_CMD_TABLE_SIZE));
+	fis = (struct tegrabl_ahci_fis_h2d *)(&cmd_table->command_fis[0]);
+
+	memset(cmd_table, 0x0, TEGRABL_SATA_AHCI_NCQ_CMD_TABLE_SIZE);
+
+	fis->fis_type = TEGRABL_AHCI_FIS_TYPE_REG_H2D;
+	fis->prc = (1 << 7);
+	fis->command = is_write ? SATA_COMMAND_FPDMA_WRITE :
+							 SATA_COMMAND_FPDMA_READ;
+	fis->device = 0x40;
+
+	/* Queued commands carry sector count in feature fields and tag in
+	 * bits 7:3 of count field.
+	 */
+	fis->featurel = (uint8_t)(count & 0xFF);
+	fis->featureh = (uint8_t)((count >> 8) & 0xFF);
+	fis->countl = (uint8_t)(slot << 3);
+
+	fis->lba0 = (uint8_t)(block & 0xFF);
+	fis->lba1 = (uint8_t)((block >> 8) & 0xFF);
+	fis->lba2 = (uint8_t)((block >> 16) & 0xFF);
+	fis->lba3 = (uint8_t)((block >> 24) & 0xFF);
+
+	num_prdt = tegrabl_sata_ahci_fill_prdt(cmd_table, address,
+			count << context->block_size_log2);
+
+	cmd_header = &context->command_list_buf[slot * AHCI_CMD_HEADER_WORDS];
+	cmd_header[0] = AHCI_CMD_HEADER_CFL |
+		(num_prdt << AHCI_CMD_HEADER_PRDTL_SHIFT);
+	if (is_write) {
+		cmd_header[0] |= CMD_HEADER_WRITE;
+	}
+	cmd_header[1] = 0;
+}
+
+/**
+ * @brief Unmaps command tables and command list of the queued commands.
+ *
+ * @param context SATA context
+ */
+static void tegrabl_sata_ahci_ncq_unmap_tables(
+		struct tegrabl_sata_context *context)
+{
+	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_SATA, context->instance,
+			&context->command_list_buf[0],
+			TEGRABL_SATA_AHCI_COMMAND_LIST_BUF_SIZE, TEGRABL_DMA_TO_DEVICE);
+	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_SATA, context->instance,
+			context->ncq_tables,
+			context->ncq_slots * TEGRABL_SATA_AHCI_NCQ_CMD_TABLE_SIZE,
+			TEGRABL_DMA_TO_DEVICE);
+}
+
+/**
+ * @brief Fills and issues the next batch of queued commands of the transfer,
+ * one command of up to SATA_NCQ_MAX_SECTORS from each slot.
+ *
+ * @param context SATA context
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error.
+ */
+static tegrabl_error_t tegrabl_sata_ahci_ncq_issue(
+		struct tegrabl_sata_context *context)
+{
+	struct tegrabl_sata_xfer *xfer = &context->xfer;
+	size_t tables_size = 0;
+	dma_addr_t table_address = 0;
+	dma_addr_t address = 0;
+	bnum_t bulk_count = 0;
+	uint32_t slot = 0;
+	uint32_t mask = 0;
+	uint32_t reg = 0;
+
+	tables_size = context->ncq_slots * TEGRABL_SATA_AHCI_NCQ_CMD_TABLE_SIZE;
+
+	for (slot = 0; (slot < context->ncq_slots) && (xfer->remaining != 0U);
+		 slot++) {
+		bulk_count = MIN(xfer->remaining, (bnum_t)SATA_NCQ_MAX_SECTORS);
+		tegrabl_sata_ahci_ncq_fill_slot(context, slot, xfer->buf_address,
+				xfer->next_block, bulk_count, xfer->is_write);
+		mask |= (1U << slot);
+		xfer->buf_address += ((dma_addr_t)bulk_count <<
+				context->block_size_log2);
+		xfer->next_block += bulk_count;
+		xfer->remaining -= bulk_count;
+	}
+
+	/* Flush the command tables and get their physical address */
+	table_address = tegrabl_dma_map_buffer(TEGRABL_MODULE_SATA,
+			context->instance, context->ncq_tables, tables_size,
+			TEGRABL_DMA_TO_DEVICE);
+
+	for (slot = 0; slot < context->ncq_slots; slot++) {
+		if ((mask & (1U << slot)) == 0U) {
+			break;
+		}
+		address = table_address +
+			(slot * TEGRABL_SATA_AHCI_NCQ_CMD_TABLE_SIZE);
+		context->command_list_buf[(slot * AHCI_CMD_HEADER_WORDS) + 2] =
+			(address & 0xFFFFFFFF);
+		context->command_list_buf[(slot * AHCI_CMD_HEADER_WORDS) + 3] =
+			((address >> 32) & 0xFFFFFFFF);
+	}
+
+	/* Flush command list buffer */
+	address = tegrabl_dma_map_buffer(TEGRABL_MODULE_SATA,
+			context->instance, &context->command_list_buf[0],
+			TEGRABL_SATA_AHCI_COMMAND_LIST_BUF_SIZE, TEGRABL_DMA_TO_DEVICE);
+
+	if (!table_address || !address) {
+		pr_debug("dma map returned zero address for command list.\n");
+		tegrabl_sata_ahci_ncq_unmap_tables(context);
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 2);
+	}
+
+	/* Clear stale status before issuing */
+	reg = NV_READ32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXIS_0);
+	NV_WRITE32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXIS_0, reg);
+
+	pr_debug("Issuing queued commands 0x%08x\n", mask);
+	NV_WRITE32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXSACT_0, mask);
+	NV_WRITE32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXCI_0, mask);
+
+	xfer->mask = mask;
+	xfer->pending = mask;
+	xfer->start_time = tegrabl_get_timestamp_us();
+
+	return TEGRABL_NO_ERROR;
+}
+
+/**
+ * @brief Checks the batch of queued commands in flight without waiting.
+ * Timeout is restarted whenever any command completes.
+ *
+ * @param context SATA context
+ *
+ * @return TEGRABL_ERR_BUSY if commands are outstanding, TEGRABL_NO_ERROR
+ * if all of them are completed else appropriate error.
+ */
+static tegrabl_error_t tegrabl_sata_ahci_ncq_check(
+		struct tegrabl_sata_context *context)
+{
+	struct tegrabl_sata_xfer *xfer = &context->xfer;
+	time_t now = 0;
+	uint32_t reg = 0;
+
+	reg = NV_READ32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXIS_0);
+	if (NV_DRF_VAL(AHCI, PORT_PXIS, TFES, reg) != 0U) {
+		pr_error("SATA queued command failed, PXTFD: 0x%08x\n",
+				NV_READ32(NV_ADDRESS_MAP_SATA_AHCI_BASE +
+					AHCI_PORT_PXTFD_0));
+		tegrabl_sata_ahci_dump_registers();
+		return TEGRABL_ERROR(TEGRABL_ERR_COMMAND_FAILED, 1);
+	}
+
+	reg = NV_READ32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXSACT_0) |
+		  NV_READ32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXCI_0);
+	reg &= xfer->mask;
+	if (reg == 0U) {
+		return TEGRABL_NO_ERROR;
+	}
+
+	now = tegrabl_get_timestamp_us();
+	if (reg != xfer->pending) {
+		xfer->pending = reg;
+		xfer->start_time = now;
+	} else if ((now - xfer->start_time) >= xfer->timeout) {
+		pr_error("Queued commands 0x%08x did not complete\n", reg);
+		tegrabl_sata_ahci_dump_registers();
+		return TEGRABL_ERROR(TEGRABL_ERR_TIMEOUT, 1);
+	} else {
+		/* No action required */
+	}
+
+	return TEGRABL_ERROR(TEGRABL_ERR_BUSY, 0);
+}
+
+/**
+ * @brief Stops the command engine of the port so that outstanding slots
+ * are dropped, and clears the error status.
+ */
+static void tegrabl_sata_ahci_port_stop(void)
+{
+	uint32_t reg = 0;
+	uint32_t timeout = 0;
+
+	reg = NV_READ32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXCMD_0);
+	reg = NV_FLD_SET_DRF_NUM(AHCI, PORT_PXCMD, ST, 0, reg);
+	NV_WRITE32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXCMD_0, reg);
+
+	timeout = SATA_D2H_FIS_TIMEOUT;
+	while (timeout != 0U) {
+		tegrabl_udelay(1);
+		timeout--;
+		reg = NV_READ32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXCMD_0);
+		if (NV_DRF_VAL(AHCI, PORT_PXCMD, CR, reg) == 0U) {
+			break;
+		}
+	}
+
+	/* Clear any error bit set */
+	reg = NV_READ32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXSERR_0);
+	NV_WRITE32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXSERR_0, reg);
+	reg = NV_READ32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXIS_0);
+	NV_WRITE32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXIS_0, reg);
+}
+
+/**
+ * @brief Starts the command engine of the port.
+ */
+static void tegrabl_sata_ahci_port_start(void)
+{
+	uint32_t reg = 0;
+
+	reg = NV_READ32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXCMD_0);
+	reg = NV_FLD_SET_DRF_NUM(AHCI, PORT_PXCMD, ST, 1, reg);
+	NV_WRITE32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXCMD_0, reg);
+}
+
+/**
+ * @brief Checks if device is busy or reports an error in task file.
+ *
+ * @return true if any of BSY, DRQ or ERR is set.
+ */
+static bool tegrabl_sata_ahci_device_busy(void)
+{
+	uint32_t reg = 0;
+
+	reg = NV_READ32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXTFD_0);
+	return (NV_DRF_VAL(AHCI, PORT_PXTFD, STS_ERR, reg) != 0U) ||
+		   (NV_DRF_VAL(AHCI, PORT_PXTFD, STS_DRQ, reg) != 0U) ||
+		   (NV_DRF_VAL(AHCI, PORT_PXTFD, STS_BSY, reg) != 0U);
+}
+
+/**
+ * @brief Resets the link with COMRESET and waits for device to be ready.
+ * Command engine of the port must be stopped.
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error.
+ */
+static tegrabl_error_t tegrabl_sata_ahci_comreset(void)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	uint32_t reg = 0;
+	uint32_t timeout = 0;
+
+	pr_warn("SATA: resetting link\n");
+
+	/* DET goes 0 -> 1 -> 0, which also gives the posedge of PxSCTL.DET
+	 * needed by Bug 200139714.
+	 */
+	reg = NV_READ32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXSCTL_0);
+	reg = NV_FLD_SET_DRF_NUM(AHCI, PORT_PXSCTL, DET, 1, reg);
+	NV_WRITE32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXSCTL_0, reg);
+	tegrabl_udelay(SATA_COMRESET_DELAY);
+	reg = NV_FLD_SET_DRF_NUM(AHCI, PORT_PXSCTL, DET, 0, reg);
+	NV_WRITE32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXSCTL_0, reg);
+
+	timeout = SATA_COMINIT_TIMEOUT;
+	while (timeout != 0U) {
+		tegrabl_udelay(1);
+		timeout--;
+		reg = NV_READ32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXSSTS_0);
+		if (NV_DRF_VAL(AHCI, PORT_PXSSTS, DET, reg) ==
+				SATA_PXSSTS_DET_PHY_READY) {
+			break;
+		}
+	}
+
+	if (timeout == 0U) {
+		pr_error("SATA link did not come up after COMRESET\n");
+		error = TEGRABL_ERROR(TEGRABL_ERR_TIMEOUT, 2);
+		tegrabl_sata_ahci_dump_registers();
+		goto fail;
+	}
+
+	/* Clear errors raised by the link going down */
+	reg = NV_READ32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXSERR_0);
+	NV_WRITE32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXSERR_0, reg);
+
+	timeout = SATA_D2H_FIS_TIMEOUT;
+	while (tegrabl_sata_ahci_device_busy()) {
+		tegrabl_udelay(1);
+		timeout--;
+		if (timeout == 0U) {
+			pr_error("SATA device not ready after COMRESET\n");
+			error = TEGRABL_ERROR(TEGRABL_ERR_TIMEOUT, 3);
+			goto fail;
+		}
+	}
+
+	reg = NV_READ32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXIS_0);
+	NV_WRITE32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXIS_0, reg);
+
+fail:
+	return error;
+}
+
+/**
+ * @brief Reads NCQ Command Error log page with READ LOG EXT. After a queued
+ * command fails, device aborts every command until this page is read.
+ *
+ * @param context SATA context
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error.
+ */
+static tegrabl_error_t tegrabl_sata_ahci_read_ncq_error_log(
+		struct tegrabl_sata_context *context)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	uint32_t reg = 0;
+	dma_addr_t address = 0;
+	struct tegrabl_ahci_cmd_table *cmd_table;
+	struct tegrabl_ahci_prdt_entry *prdt_entry;
+	struct tegrabl_ahci_fis_h2d *fis;
+	uint8_t *log = context->indentity_buf;
+	bool mapped_log = false;
+	bool mapped_cmd_list = false;
+	bool mapped_cmd_table = false;
+
+	cmd_table = (struct tegrabl_ahci_cmd_table *)&context->command_table[0];
+	prdt_entry = (struct tegrabl_ahci_prdt_entry *)&cmd_table->prdt_entry[0];
+	fis = (struct tegrabl_ahci_fis_h2d *)(&cmd_table->command_fis[0]);
+
+	memset(cmd_table, 0x0, sizeof(*cmd_table));
+
+	/* Fill command fis, log address goes in lba0 and page count in count */
+	fis->fis_type = TEGRABL_AHCI_FIS_TYPE_REG_H2D;
+	fis->prc = (1 << 7);
+	fis->command = SATA_COMMAND_READ_LOG_EXT;
+	fis->device = 0x40;
+	fis->lba0 = SATA_LOG_NCQ_COMMAND_ERROR;
+	fis->countl = 1;
+
+	address = tegrabl_dma_map_buffer(TEGRABL_MODULE_SATA, context->instance,
+			log, TEGRABL_SATA_AHCI_DEVICE_IDENTITY_BUF_SIZE,
+			TEGRABL_DMA_FROM_DEVICE);
+
+	mapped_log = true;
+
+	if (!address) {
+		pr_debug("dma map returned zero address for log buf.\n");
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 6);
+		goto fail;
+	}
+
+	/* Fill the prdt entry */
+	prdt_entry->address_low = (address & 0xFFFFFFFF);
+	prdt_entry->address_high = (((address >> 32) & 0xFFFFFFFF));
+	prdt_entry->irc = (1 << 31) |
+		(TEGRABL_SATA_AHCI_DEVICE_IDENTITY_BUF_SIZE - 1);
+
+	/* Fill the command list. Use only one prdt entry. */
+	context->command_list_buf[0] = AHCI_CMD_HEADER_CFL | AHCI_CMD_HEADER_PRDTL;
+	context->command_list_buf[1] = TEGRABL_SATA_AHCI_DEVICE_IDENTITY_BUF_SIZE;
+
+	/* Flush the updated command table and get its physical address */
+	address = tegrabl_dma_map_buffer(TEGRABL_MODULE_SATA, context->instance,
+			&context->command_table[0], TEGRABL_SATA_AHCI_COMMAND_TABLE_SIZE,
+			TEGRABL_DMA_TO_DEVICE);
+
+	mapped_cmd_table = true;
+
+	if (!address) {
+		pr_debug("dma map returned zero address for command table.\n");
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 7);
+		goto fail;
+	}
+
+	context->command_list_buf[2] = (address & 0xFFFFFFFF);
+	context->command_list_buf[3] = (((address >> 32) & 0xFFFFFFFF));
+
+	/* Flush command list buffer */
+	address = tegrabl_dma_map_buffer(TEGRABL_MODULE_SATA, context->instance,
+				&context->command_list_buf[0],
+				TEGRABL_SATA_AHCI_COMMAND_LIST_BUF_SIZE, TEGRABL_DMA_TO_DEVICE);
+
+	mapped_cmd_list = true;
+
+	if (!address) {
+		pr_debug("dma map returned zero address for command list buf.\n");
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 8);
+		goto fail;
+	}
+
+	/* Enable appropriate interrupts */
+	reg = 0;
+	reg = NV_FLD_SET_DRF_NUM(AHCI, PORT_PXIE, DPE, 1, reg);
+	reg = NV_FLD_SET_DRF_NUM(AHCI, PORT_PXIE, PSE, 1, reg);
+	NV_WRITE32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXIE_0, reg);
+
+	/* Initiate transaction and wait for completion or timeout */
+	error = tegrabl_sata_start_command(TEGRABL_SATA_READ_TIMEOUT);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	if (tegrabl_sata_ahci_device_busy()) {
+		pr_error("READ LOG EXT failed, PXTFD: 0x%08x\n",
+				NV_READ32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXTFD_0));
+		error = TEGRABL_ERROR(TEGRABL_ERR_COMMAND_FAILED, 2);
+		goto fail;
+	}
+
+	/* Unmap log buffer before accessing */
+	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_SATA, context->instance,
+			log, TEGRABL_SATA_AHCI_DEVICE_IDENTITY_BUF_SIZE,
+			TEGRABL_DMA_FROM_DEVICE);
+	mapped_log = false;
+
+	if ((log[0] & SATA_NCQ_ERROR_LOG_NQ) == 0U) {
+		pr_error("NCQ error log: tag %u, status 0x%02x, error 0x%02x\n",
+				log[0] & SATA_NCQ_ERROR_LOG_TAG_MASK, log[2], log[3]);
+	}
+
+fail:
+	if (mapped_cmd_list) {
+		tegrabl_dma_unmap_buffer(TEGRABL_MODULE_SATA, context->instance,
+			&context->command_list_buf[0],
+			TEGRABL_SATA_AHCI_COMMAND_LIST_BUF_SIZE, TEGRABL_DMA_TO_DEVICE);
+	}
+
+	if (mapped_log) {
+		tegrabl_dma_unmap_buffer(TEGRABL_MODULE_SATA, context->instance,
+			log, TEGRABL_SATA_AHCI_DEVICE_IDENTITY_BUF_SIZE,
+			TEGRABL_DMA_FROM_DEVICE);
+	}
+
+	if (mapped_cmd_table) {
+		tegrabl_dma_unmap_buffer(TEGRABL_MODULE_SATA, context->instance,
+			&context->command_table[0], TEGRABL_SATA_AHCI_COMMAND_TABLE_SIZE,
+			TEGRABL_DMA_TO_DEVICE);
+	}
+
+	return error;
+}
+
+/**
+ * @brief Recovers the port and device after a failed queued command so that
+ * non-queued commands can be issued again. Outstanding slots are dropped
+ * and NCQ Command Error log is read to take device out of its error state.
+ * Link is reset with COMRESET if device is stuck busy or the log cannot be
+ * read.
+ *
+ * @param context SATA context
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error.
+ */
+static tegrabl_error_t tegrabl_sata_ahci_ncq_recover(
+		struct tegrabl_sata_context *context)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	uint32_t reg = 0;
+
+	tegrabl_sata_ahci_port_stop();
+
+	reg = NV_READ32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXTFD_0);
+	if ((NV_DRF_VAL(AHCI, PORT_PXTFD, STS_BSY, reg) == 0U) &&
+		(NV_DRF_VAL(AHCI, PORT_PXTFD, STS_DRQ, reg) == 0U)) {
+		tegrabl_sata_ahci_port_start();
+		error = tegrabl_sata_ahci_read_ncq_error_log(context);
+		if (error == TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+		pr_error("Failed to read NCQ error log\n");
+		tegrabl_sata_ahci_port_stop();
+	}
+
+	error = tegrabl_sata_ahci_comreset();
+	tegrabl_sata_ahci_port_start();
+
+fail:
+	return error;
+}
+
+/**
+ * @brief Starts read or write of sectors using READ/WRITE FPDMA QUEUED
+ * commands. Request is split into commands of up to SATA_NCQ_MAX_SECTORS,
+ * and up to ncq_slots commands are kept outstanding at a time.
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error.
+ */
+static tegrabl_error_t tegrabl_sata_ahci_ncq_io_start(
+		struct tegrabl_sata_context *context)
+{
+	struct tegrabl_sata_xfer *xfer = &context->xfer;
+	size_t size = (size_t)xfer->count << context->block_size_log2;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	uint32_t reg = 0;
+
+	pr_debug("Sata NCQ I/O block %d, count %d, %s\n", xfer->block,
+			xfer->count, xfer->is_write ? "writing" : "reading");
+
+	xfer->buf_address = tegrabl_dma_map_buffer(TEGRABL_MODULE_SATA,
+			context->instance, xfer->buf, size,
+			xfer->is_write ? TEGRABL_DMA_TO_DEVICE : TEGRABL_DMA_FROM_DEVICE);
+
+	if (!xfer->buf_address) {
+		pr_debug("dma map returned zero address for buf.\n");
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 1);
+		goto fail;
+	}
+
+	/* Enable appropriate interrupts */
+	reg = 0;
+	reg = NV_FLD_SET_DRF_NUM(AHCI, PORT_PXIE, DPE, 1, reg);
+	reg = NV_FLD_SET_DRF_NUM(AHCI, PORT_PXIE, SDBE, 1, reg);
+	reg = NV_FLD_SET_DRF_NUM(AHCI, PORT_PXIE, TFEE, 1, reg);
+	NV_WRITE32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXIE_0, reg);
+
+	xfer->next_block = xfer->block;
+	xfer->remaining = xfer->count;
+
+	error = tegrabl_sata_ahci_ncq_issue(context);
+
+fail:
+	if (error != TEGRABL_NO_ERROR) {
+		tegrabl_dma_unmap_buffer(TEGRABL_MODULE_SATA, context->instance,
+				xfer->buf, size, xfer->is_write ? TEGRABL_DMA_TO_DEVICE :
+				TEGRABL_DMA_FROM_DEVICE);
+	}
+
+	return error;
+}
+
+/**
+ * @brief Completes the batch of queued commands in flight once it is over
+ * and issues the next one.
+ *
+ * @return TEGRABL_ERR_BUSY while commands are outstanding, else the status
+ * of the request.
+ */
+static tegrabl_error_t tegrabl_sata_ahci_ncq_io_poll(
+		struct tegrabl_sata_context *context)
+{
+	struct tegrabl_sata_xfer *xfer = &context->xfer;
+	size_t size = (size_t)xfer->count << context->block_size_log2;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	error = tegrabl_sata_ahci_ncq_check(context);
+	if (TEGRABL_ERROR_REASON(error) == TEGRABL_ERR_BUSY) {
+		return error;
+	}
+
+	tegrabl_sata_ahci_ncq_unmap_tables(context);
+
+	if ((error == TEGRABL_NO_ERROR) && (xfer->remaining != 0U)) {
+		error = tegrabl_sata_ahci_ncq_issue(context);
+		if (error == TEGRABL_NO_ERROR) {
+			return TEGRABL_ERROR(TEGRABL_ERR_BUSY, 1);
+		}
+	}
+
+	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_SATA, context->instance,
+			xfer->buf, size, xfer->is_write ? TEGRABL_DMA_TO_DEVICE :
+			TEGRABL_DMA_FROM_DEVICE);
+
+	return error;
+}
+#endif
+
+/**
+ * @brief Read or write sectors of the request with non-queued DMA commands
+ * of up to SATA_MAX_READ_WRITE_SECTORS each.
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error.
+ */
+static tegrabl_error_t tegrabl_sata_ahci_dma_io_all(
+		struct tegrabl_sata_context *context)
+{
+	struct tegrabl_sata_xfer *xfer = &context->xfer;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	uint8_t *buffer = xfer->buf;
+	bnum_t block = xfer->block;
+	bnum_t count = xfer->count;
+	bnum_t bulk_count = 0;
+
+	while (count != 0U) {
+		bulk_count = MIN(count, (bnum_t)SATA_MAX_READ_WRITE_SECTORS);
+		error = tegrabl_sata_ahci_dma_io(context, buffer, block, bulk_count,
+				xfer->is_write, xfer->timeout);
+		if (error != TEGRABL_NO_ERROR) {
+			break;
+		}
+
+		count -= bulk_count;
+		buffer += (bulk_count << context->block_size_log2);
+		block += bulk_count;
+	}
+
+	return error;
+}
+
+#if defined(CONFIG_ENABLE_SATA_NCQ)
+/**
+ * @brief Drops outstanding commands after a failed queued request and
+ * retries the whole request with non-queued commands.
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error.
+ */
+static tegrabl_error_t tegrabl_sata_ahci_ncq_fallback(
+		struct tegrabl_sata_context *context)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	pr_error("SATA queued %s failed, disabling NCQ\n",
+			context->xfer.is_write ? "write" : "read");
+	context->supports_ncq = false;
+	error = tegrabl_sata_ahci_ncq_recover(context);
+	if (error != TEGRABL_NO_ERROR) {
+		pr_error("SATA recovery after queued command failed\n");
+		return error;
+	}
+
+	return tegrabl_sata_ahci_dma_io_all(context);
+}
+#endif
+
+tegrabl_error_t tegrabl_sata_ahci_io_start(
+		struct tegrabl_sata_context *context, void *buf, bnum_t block,
+		bnum_t count, bool is_write, time_t timeout)
+{
+	struct tegrabl_sata_xfer *xfer = &context->xfer;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	if (xfer->active) {
+		return TEGRABL_ERROR(TEGRABL_ERR_BUSY, 2);
+	}
+
+	xfer->buf = buf;
+	xfer->block = block;
+	xfer->count = count;
+	xfer->is_write = is_write;
+	xfer->timeout = timeout;
+
+#if defined(CONFIG_ENABLE_SATA_NCQ)
+	if (context->supports_ncq && (count != 0U)) {
+		error = tegrabl_sata_ahci_ncq_io_start(context);
+		if (error == TEGRABL_NO_ERROR) {
+			xfer->active = true;
+			goto fail;
+		}
+
+		error = tegrabl_sata_ahci_ncq_fallback(context);
+		goto fail;
+	}
+#endif
+
+	/* Non-queued commands are completed right here */
+	error = tegrabl_sata_ahci_dma_io_all(context);
+
+#if defined(CONFIG_ENABLE_SATA_NCQ)
+fail:
+#endif
+	xfer->error = error;
+	return error;
+}
+
+tegrabl_error_t tegrabl_sata_ahci_io_poll(struct tegrabl_sata_context *context)
+{
+	struct tegrabl_sata_xfer *xfer = &context->xfer;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	/* Transfer is over, report how it ended */
+	if (!xfer->active) {
+		return xfer->error;
+	}
+
+#if defined(CONFIG_ENABLE_SATA_NCQ)
+	error = tegrabl_sata_ahci_ncq_io_poll(context);
+	if (TEGRABL_ERROR_REASON(error) == TEGRABL_ERR_BUSY) {
+		return error;
+	}
+
+	if (error != TEGRABL_NO_ERROR) {
+		error = tegrabl_sata_ahci_ncq_fallback(context);
+	}
+#endif
+
+	xfer->active = false;
+	xfer->error = error;
+	return error;
+}
+
 tegrabl_error_t tegrabl_sata_ahci_io(
 		struct tegrabl_sata_context *context, void *buf, bnum_t block,
 		bnum_t count, bool is_write, time_t timeout)
 {
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	error = tegrabl_sata_ahci_io_start(context, buf, block, count, is_write,
+			timeout);
+	if (error != TEGRABL_NO_ERROR) {
+		return error;
+	}
+
+	do {
+		error = tegrabl_sata_ahci_io_poll(context);
+	} while (TEGRABL_ERROR_REASON(error) == TEGRABL_ERR_BUSY);
+
+	return error;
+}
+
+/**
+ * @brief Sends DATA SET MANAGEMENT TRIM command with the LBA range entries
+ * already filled in dsm buffer.
+ *
+ * @param context SATA context
+ * @param num_blocks Number of 512 byte blocks of range entries to send
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error.
+ */
+static tegrabl_error_t tegrabl_sata_ahci_dsm_trim(
+		struct tegrabl_sata_context *context, uint32_t num_blocks)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
 	uint32_t reg = 0;
 	struct tegrabl_ahci_cmd_table *cmd_table;
 	struct tegrabl_ahci_prdt_entry *prdt_entry;
 	struct tegrabl_ahci_fis_h2d *fis;
 	dma_addr_t address = 0;
+	uint32_t size = num_blocks << TEGRABL_SATA_SECTOR_SIZE_LOG2;
 	bool mapped_buf = false;
 	bool mapped_cmd_list = false;
 	bool mapped_cmd_table = false;
-	uint32_t block_size_log2 = context->block_size_log2;
-
-	pr_debug("Sata I/O block %d, count %d, ", block, count);
-	pr_debug("%s\n", is_write ? "writingg" : "reading");
 
 	cmd_table = (struct tegrabl_ahci_cmd_table *)&context->command_table[0];
 	prdt_entry = (struct tegrabl_ahci_prdt_entry *)&cmd_table->prdt_entry[0];
@@ -118,62 +1039,36 @@ tegrabl_error_t tegrabl_sata_ahci_io(
 
 	memset(cmd_table, 0x0, sizeof(*cmd_table));
 
-	/* Fill Command FIS */
+	/* Fill command fis, payload size goes in count field */
 	fis->fis_type = TEGRABL_AHCI_FIS_TYPE_REG_H2D;
 	fis->prc = (1 << 7);
+	fis->command = SATA_COMMAND_DATA_SET_MANAGEMENT;
+	fis->featurel = SATA_DSM_FEATURE_TRIM;
 	fis->device = 0x40;
+	fis->countl = (uint8_t)(num_blocks & 0xFF);
+	fis->counth = (uint8_t)((num_blocks >> 8) & 0xFF);
 
-	/* Use commands for 48 bit address if drive supports */
-	if (context->support_extended_cmd) {
-		fis->command = is_write ? SATA_COMMAND_DMA_WRITE_EXTENDED :
-								 SATA_COMMAND_DMA_READ_EXTENDED;
-	} else {
-		fis->command = is_write ? SATA_COMMAND_DMA_WRITE :
-								 SATA_COMMAND_DMA_READ;
-	}
-
-	/* Fill start sector information */
-	fis->lba0 = (uint8_t)(block & 0xFF);
-	fis->lba1 = (uint8_t)((block >> 8) & 0xFF);
-	fis->lba2 = (uint8_t)((block >> 16) & 0xFF);
-	fis->lba3 = (uint8_t)((block >> 24) & 0xFF);
-	block = block >> 24;
-	fis->lba4 = (uint8_t)((block >> 8) & 0xFF);
-	fis->lba5 = (uint8_t)((block >> 16) & 0xFF);
-
-	/* Fill number of sectors to be read */
-	fis->countl = (uint8_t)(count & 0xFF);
-	fis->counth = (uint8_t)((count >> 8) & 0xFF);
-
-	/* Map input buffer as per read/write and get physical address */
+	/* Flush range entries and get physical address */
 	address = tegrabl_dma_map_buffer(TEGRABL_MODULE_SATA, context->instance,
-				buf, count << block_size_log2,
-				is_write ? TEGRABL_DMA_TO_DEVICE : TEGRABL_DMA_FROM_DEVICE);
+			context->dsm_buf, size, TEGRABL_DMA_TO_DEVICE);
 
 	mapped_buf = true;
 
-	pr_debug("Buffer addresss is %p\n", buf);
-	pr_debug("Dma address of buffer is %"PRIx64"\n", address);
-
 	if (!address) {
-		pr_debug("dma map returned zero address for buf.\n");
-		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+		pr_debug("dma map returned zero address for dsm buf.\n");
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 3);
 		goto fail;
 	}
 
 	/* Fill the prdt entry */
 	prdt_entry->address_low = (address & 0xFFFFFFFF);
 	prdt_entry->address_high = (((address >> 32) & 0xFFFFFFFF));
-	prdt_entry->irc = (1 << 31);
-	prdt_entry->irc |= ((count << block_size_log2) - 1);
+	prdt_entry->irc = (1 << 31) | (size - 1);
 
 	/* Fill the command list. Use only one prdt entry. */
-	context->command_list_buf[0] = AHCI_CMD_HEADER_CFL | AHCI_CMD_HEADER_PRDTL;
-	if (is_write) {
-		context->command_list_buf[0] |= CMD_HEADER_WRITE;
-	}
-
-	context->command_list_buf[1] = count << block_size_log2;
+	context->command_list_buf[0] = AHCI_CMD_HEADER_CFL | AHCI_CMD_HEADER_PRDTL |
+			CMD_HEADER_WRITE;
+	context->command_list_buf[1] = size;
 
 	/* Flush the updated command table and get its physical address */
 	address = tegrabl_dma_map_buffer(TEGRABL_MODULE_SATA, context->instance,
@@ -182,11 +1077,9 @@ tegrabl_error_t tegrabl_sata_ahci_io(
 
 	mapped_cmd_table = true;
 
-	pr_debug("Dma address of command table is %"PRIx64"\n", address);
-
 	if (!address) {
 		pr_debug("dma map returned zero address for command table.\n");
-		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 4);
 		goto fail;
 	}
 
@@ -197,28 +1090,23 @@ tegrabl_error_t tegrabl_sata_ahci_io(
 	address = tegrabl_dma_map_buffer(TEGRABL_MODULE_SATA, context->instance,
 				&context->command_list_buf[0],
 				TEGRABL_SATA_AHCI_COMMAND_LIST_BUF_SIZE, TEGRABL_DMA_TO_DEVICE);
-	mapped_cmd_list = true;
 
-	pr_debug("Dma address of command list buffer is %"PRIx64"\n", address);
+	mapped_cmd_list = true;
 
 	if (!address) {
 		pr_debug("dma map returned zero address for command list buf.\n");
-		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 5);
 		goto fail;
 	}
 
 	/* Enable appropriate interrupts */
 	reg = 0;
 	reg = NV_FLD_SET_DRF_NUM(AHCI, PORT_PXIE, DPE, 1, reg);
-
-	if (is_write) {
-		reg = NV_FLD_SET_DRF_NUM(AHCI, PORT_PXIE, DHRE, 1, reg);
-	}
-
+	reg = NV_FLD_SET_DRF_NUM(AHCI, PORT_PXIE, DHRE, 1, reg);
 	NV_WRITE32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_PORT_PXIE_0, reg);
 
 	/* Initiate transaction and wait for completion or timeout */
-	error = tegrabl_sata_start_command(timeout);
+	error = tegrabl_sata_start_command(TEGRABL_SATA_ERASE_TIMEOUT);
 
 fail:
 	if (mapped_cmd_list) {
@@ -229,8 +1117,7 @@ fail:
 
 	if (mapped_buf) {
 		tegrabl_dma_unmap_buffer(TEGRABL_MODULE_SATA, context->instance,
-			buf, count << block_size_log2,
-			is_write ? TEGRABL_DMA_TO_DEVICE : TEGRABL_DMA_FROM_DEVICE);
+			context->dsm_buf, size, TEGRABL_DMA_TO_DEVICE);
 	}
 
 	if (mapped_cmd_table) {
@@ -245,11 +1132,47 @@ fail:
 tegrabl_error_t tegrabl_sata_ahci_erase(
 		struct tegrabl_sata_context *context, bnum_t block, bnum_t count)
 {
-	TEGRABL_UNUSED(context);
-	TEGRABL_UNUSED(block);
-	TEGRABL_UNUSED(count);
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	uint32_t max_ranges = 0;
+	uint32_t num_ranges = 0;
+	uint32_t num_blocks = 0;
+	uint64_t range_count = 0;
+	bnum_t start_block = 0;
+
+	if (!context->supports_trim) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 0);
+		goto fail;
+	}
+
+	pr_debug("Sata trim block %d, count %d\n", block, count);
+
+	max_ranges = context->dsm_blocks * SATA_DSM_RANGES_PER_BLOCK;
+
+	while (count != 0U) {
+		start_block = block;
+
+		/* Unused entries must have zero length */
+		memset(context->dsm_buf, 0x0, TEGRABL_SATA_AHCI_DSM_BUF_SIZE);
 
-	return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 0);
+		for (num_ranges = 0; (num_ranges < max_ranges) && (count != 0U);
+				num_ranges++) {
+			range_count = MIN(count, (bnum_t)SATA_DSM_RANGE_MAX_SECTORS);
+			context->dsm_buf[num_ranges] = (uint64_t)block |
+				(range_count << SATA_DSM_RANGE_LENGTH_SHIFT);
+			block += range_count;
+			count -= range_count;
+		}
+
+		num_blocks = DIV_CEIL(num_ranges, SATA_DSM_RANGES_PER_BLOCK);
+		error = tegrabl_sata_ahci_dsm_trim(context, num_blocks);
+		if (error != TEGRABL_NO_ERROR) {
+			pr_error("Sata trim failed at block %u\n", start_block);
+			goto fail;
+		}
+	}
+
+fail:
+	return error;
 }
 
 tegrabl_error_t tegrabl_sata_ahci_flush_device(
@@ -348,6 +1271,96 @@ fail:
 	return error;
 }
 
+/**
+ * @brief Checks whether device supports DATA SET MANAGEMENT TRIM and
+ * allocates buffer for LBA range entries if so.
+ *
+ * @param context SATA context
+ * @param dev_id Identify data of the device
+ */
+static void tegrabl_sata_ahci_trim_init(struct tegrabl_sata_context *context,
+		struct tegrabl_ata_dev_id *dev_id)
+{
+	uint32_t max_blocks = 0;
+
+	context->supports_trim = false;
+
+	if (!context->support_extended_cmd ||
+		((dev_id->dsm_support[0] & (1 << SATA_SUPPORTS_DSM_TRIM)) == 0U)) {
+		pr_debug("TRIM not supported\n");
+		return;
+	}
+
+	/* Zero means the device does not report a limit, use one block */
+	max_blocks = (uint32_t)dev_id->dsm_max_blocks[0] |
+				 ((uint32_t)dev_id->dsm_max_blocks[1] << 8);
+	if (max_blocks == 0U) {
+		max_blocks = 1;
+	}
+
+	if (context->dsm_buf == NULL) {
+		context->dsm_buf = tegrabl_alloc_align(TEGRABL_HEAP_DMA, 512,
+				TEGRABL_SATA_AHCI_DSM_BUF_SIZE);
+		if (context->dsm_buf == NULL) {
+			pr_warn("No memory for DSM buffer, TRIM disabled\n");
+			return;
+		}
+	}
+
+	context->dsm_blocks = MIN(max_blocks,
+			(uint32_t)TEGRABL_SATA_AHCI_DSM_MAX_BLOCKS);
+	context->supports_trim = true;
+
+	pr_debug("Supports TRIM with %u range blocks\n", context->dsm_blocks);
+}
+
+#if defined(CONFIG_ENABLE_SATA_NCQ)
+/**
+ * @brief Checks whether both controller and device support native command
+ * queuing and allocates per slot command tables if so.
+ *
+ * @param context SATA context
+ * @param dev_id Identify data of the device
+ */
+static void tegrabl_sata_ahci_ncq_init(struct tegrabl_sata_context *context,
+		struct tegrabl_ata_dev_id *dev_id)
+{
+	uint32_t reg = 0;
+	uint32_t slots = 0;
+	uint32_t depth = 0;
+
+	context->supports_ncq = false;
+
+	reg = NV_READ32(NV_ADDRESS_MAP_SATA_AHCI_BASE + AHCI_HBA_CAP_0);
+	if ((NV_DRF_VAL(AHCI, HBA_CAP, SNCQ, reg) == 0U) ||
+		!context->support_extended_cmd ||
+		((dev_id->sata_capabilities[1] & (1 << SATA_SUPPORTS_NCQ)) == 0U)) {
+		pr_debug("NCQ not supported\n");
+		return;
+	}
+
+	slots = NV_DRF_VAL(AHCI, HBA_CAP, NCS, reg) + 1U;
+	depth = (dev_id->queue_depth[0] & SATA_QUEUE_DEPTH_MASK) + 1U;
+	slots = MIN(slots, depth);
+	slots = MIN(slots, (uint32_t)TEGRABL_SATA_AHCI_MAX_SLOTS);
+
+	if (context->ncq_tables == NULL) {
+		context->ncq_tables = tegrabl_alloc_align(TEGRABL_HEAP_DMA, 256,
+				TEGRABL_SATA_AHCI_MAX_SLOTS *
+				TEGRABL_SATA_AHCI_NCQ_CMD_TABLE_SIZE);
+		if (context->ncq_tables == NULL) {
+			pr_warn("No memory for NCQ command tables, NCQ disabled\n");
+			return;
+		}
+	}
+
+	context->ncq_slots = slots;
+	context->supports_ncq = true;
+
+	pr_info("SATA NCQ enabled with %u slots\n", slots);
+}
+#endif
+
 /**
  * @brief Identifies the device connected to SATA controller
  * and retrieves the information about storage device
@@ -484,6 +1497,12 @@ static tegrabl_error_t tegrabl_sata_ahci_indentify_device(
 
 	pr_debug("%s extended command.",
 			context->support_extended_cmd ? "Supports" : "Does not support");
+
+	tegrabl_sata_ahci_trim_init(context, dev_id);
+
+#if defined(CONFIG_ENABLE_SATA_NCQ)
+	tegrabl_sata_ahci_ncq_init(context, dev_id);
+#endif
 	pr_debug("Total sectors %d\n", (uint32_t)context->block_count);
 	pr_debug("%s flush command.",
 			context->supports_flush ? "Supports" : "Does not support");
@@ -886,6 +1905,16 @@ void tegrabl_sata_ahci_free_buffers(struct tegrabl_sata_context *context)
 	tegrabl_dealloc(TEGRABL_HEAP_DMA, context->indentity_buf);
 	tegrabl_dealloc(TEGRABL_HEAP_DMA, context->command_list_buf);
 	tegrabl_dealloc(TEGRABL_HEAP_DMA, context->command_table);
+	if (context->ncq_tables != NULL) {
+		tegrabl_dealloc(TEGRABL_HEAP_DMA, context->ncq_tables);
+		context->ncq_tables = NULL;
+	}
+	context->supports_ncq = false;
+	if (context->dsm_buf != NULL) {
+		tegrabl_dealloc(TEGRABL_HEAP_DMA, context->dsm_buf);
+		context->dsm_buf = NULL;
+	}
+	context->supports_trim = false;
 }
 
 /**
@@ -13,6 +13,7 @@
 
 #include <stdint.h>
 #include <tegrabl_error.h>
+#include <tegrabl_dmamap.h>
 
 #define TEGRABL_SATA_SECTOR_SIZE_LOG2 (9)
 
@@ -23,7 +24,24 @@
 #define SATA_BUFFER_ALIGNEMENTS (4096)
 #define SATA_MAX_READ_WRITE_SECTORS 0xFF
 
+/* Native command queuing: one command table per slot, each with a small
+ * prdt list. A prdt entry can describe at most 4MB. */
+#define TEGRABL_SATA_AHCI_MAX_SLOTS 32
+#define TEGRABL_SATA_AHCI_NCQ_CMD_TABLE_SIZE (256)
+#define TEGRABL_SATA_AHCI_NCQ_MAX_PRDT 8
+#define SATA_AHCI_PRDT_MAX_BYTES (4 * 1024 * 1024)
+#define SATA_NCQ_MAX_SECTORS 0x8000
+
+/* DATA SET MANAGEMENT: each 512 byte block of payload holds 64 LBA range
+ * entries of 8 bytes, each covering up to 0xFFFF sectors. */
+#define TEGRABL_SATA_AHCI_DSM_MAX_BLOCKS 8
+#define TEGRABL_SATA_AHCI_DSM_BUF_SIZE (TEGRABL_SATA_AHCI_DSM_MAX_BLOCKS * 512)
+#define SATA_DSM_RANGES_PER_BLOCK 64
+#define SATA_DSM_RANGE_MAX_SECTORS 0xFFFF
+#define SATA_DSM_RANGE_LENGTH_SHIFT 48
+
 #define SATA_COMINIT_TIMEOUT 200000 /* us */
+#define SATA_COMRESET_DELAY 1000 /* us */
 #define SATA_D2H_FIS_TIMEOUT 1000000 /* us */
 #define TEGRABL_SATA_FLUSH_TIMEOUT 30000000 /* us */
 #define TEGRABL_SATA_ERASE_TIMEOUT 10000000 /* us */
@@ -32,12 +50,17 @@
 #define TEGRABL_SATA_IDENTIFY_TIMEOUT 1000000 /* us */
 
 #define AHCI_CMD_HEADER_PRDTL (1 << 16)
+#define AHCI_CMD_HEADER_PRDTL_SHIFT 16
+#define AHCI_CMD_HEADER_WORDS 8
 #define AHCI_CMD_HEADER_CFL 0x5
 #define AHCI_CMD_HEADER_WRITE (1 << 6)
 
 #define SATA_SUPPORTS_FLUSH 4
 #define SATA_SUPPORTS_FLUSH_EXT 5
 #define SATA_SUPPORTS_48_BIT_ADDRESS 2
+#define SATA_SUPPORTS_NCQ 0
+#define SATA_QUEUE_DEPTH_MASK 0x1F
+#define SATA_SUPPORTS_DSM_TRIM 0
 
 #define CMD_HEADER_WRITE (1 << 6)
 
@@ -45,9 +68,18 @@
 #define SATA_COMMAND_DMA_WRITE 0xCA
 #define SATA_COMMAND_DMA_READ 0xC8
 #define SATA_COMMAND_DMA_READ_EXTENDED 0x25
+#define SATA_COMMAND_FPDMA_READ 0x60
+#define SATA_COMMAND_FPDMA_WRITE 0x61
 #define SATA_COMMAND_IDENTIFY 0xec
 #define SATA_COMMAND_FLUSH 0xE7
 #define SATA_COMMAND_FLUSH_EXTENDED 0xEA
+#define SATA_COMMAND_DATA_SET_MANAGEMENT 0x06
+#define SATA_DSM_FEATURE_TRIM 0x01
+#define SATA_COMMAND_READ_LOG_EXT 0x2F
+#define SATA_LOG_NCQ_COMMAND_ERROR 0x10
+#define SATA_NCQ_ERROR_LOG_NQ (1 << 7)
+#define SATA_NCQ_ERROR_LOG_TAG_MASK 0x1F
+#define SATA_PXSSTS_DET_PHY_READY 0x3
 
 /**
  * @brief defines the mode supported by sata device driver
@@ -69,6 +101,32 @@ enum tegrabl_sata_interface_speed {
 };
 
 
+/**
+ * @brief Defines the state of the transfer started with
+ * tegrabl_sata_ahci_io_start
+ */
+struct tegrabl_sata_xfer {
+	/* Buffer, start sector and number of sectors of the request */
+	void *buf;
+	bnum_t block;
+	bnum_t count;
+	bool is_write;
+	time_t timeout;
+	/* Dma address, sector and count of the part not yet issued */
+	dma_addr_t buf_address;
+	bnum_t next_block;
+	bnum_t remaining;
+	/* Slots issued in the current batch and those still outstanding */
+	uint32_t mask;
+	uint32_t pending;
+	/* Time of the last completion seen in the batch in us */
+	time_t start_time;
+	/* Is the transfer still in flight */
+	bool active;
+	/* Status of the transfer once it is over */
+	tegrabl_error_t error;
+};
+
 /**
  * @brief Defines the structure for book keeping
  */
@@ -89,6 +147,14 @@ struct tegrabl_sata_context {
 	uint8_t *indentity_buf;
 	uint32_t *command_list_buf;
 	uint32_t *command_table;
+	/* Per slot command tables for queued commands */
+	uint32_t *ncq_tables;
+	/* Number of command slots used for queued commands */
+	uint32_t ncq_slots;
+	/* Payload buffer for DATA SET MANAGEMENT (TRIM) ranges */
+	uint64_t *dsm_buf;
+	/* Number of 512 byte payload blocks per DSM command */
+	uint32_t dsm_blocks;
 
 	/* Is flush supported */
 	bool supports_flush;
@@ -98,6 +164,12 @@ struct tegrabl_sata_context {
 	bool initialized;
 	/* Are extended commands supported */
 	bool support_extended_cmd;
+	/* Are queued (FPDMA) commands supported by host and device */
+	bool supports_ncq;
+	/* Is DATA SET MANAGEMENT TRIM supported */
+	bool supports_trim;
+	/* Transfer started with tegrabl_sata_ahci_io_start */
+	struct tegrabl_sata_xfer xfer;
 };
 
 /**
@@ -182,11 +254,18 @@ struct tegrabl_ata_dev_id {
 	uint8_t model_number[40];
 	uint8_t not_used3[26];
 	uint8_t sectors[4];
-	uint8_t not_used4[48];
+	uint8_t not_used4[26];
+	uint8_t queue_depth[2];
+	uint8_t sata_capabilities[2];
+	uint8_t not_used5[18];
 	uint8_t command_supported[2];
-	uint8_t not_used5[26];
+	uint8_t not_used6[26];
 	uint8_t sectors_48bit[6];
-	uint8_t not_used6[302];
+	uint8_t not_used7[4];
+	uint8_t dsm_max_blocks[2];
+	uint8_t not_used8[126];
+	uint8_t dsm_support[2];
+	uint8_t not_used9[168];
 };
 
 /**
@@ -201,7 +280,9 @@ tegrabl_error_t tegrabl_sata_ahci_init(struct tegrabl_sata_context *context,
 
 /**
  * @brief Read or write number block starting from specified
- * block
+ * block. Requests of any size are accepted; they are issued as queued
+ * commands over all available slots when the device supports NCQ, or
+ * split into single DMA commands otherwise.
  *
  * @param context Context information
  * @param buf Buffer to save read content or to write to device
@@ -215,7 +296,38 @@ tegrabl_error_t tegrabl_sata_ahci_io(struct tegrabl_sata_context *context,
 		void *buf, bnum_t block, bnum_t count, bool is_write, time_t timeout);
 
 /**
- * @brief Erases storage device connected to sata controller
+ * @brief Starts read or write of number of blocks starting from specified
+ * block without waiting for it. With NCQ the first batch of queued commands
+ * is issued and the rest are issued from tegrabl_sata_ahci_io_poll, else the
+ * request is completed with non-queued commands before returning.
+ *
+ * @param context Context information
+ * @param buf Buffer to save read content or to write to device
+ * @param block Start sector for read/write
+ * @param count Number of sectors to read/write
+ * @param is_write True if write operation
+ * @param timeout Time to wait for a completion in us
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error.
+ */
+tegrabl_error_t tegrabl_sata_ahci_io_start(struct tegrabl_sata_context *context,
+		void *buf, bnum_t block, bnum_t count, bool is_write, time_t timeout);
+
+/**
+ * @brief Moves the transfer started with tegrabl_sata_ahci_io_start forward
+ * without waiting.
+ *
+ * @param context Context information
+ *
+ * @return TEGRABL_ERR_BUSY while the transfer is in flight, else the status
+ * of the transfer.
+ */
+tegrabl_error_t tegrabl_sata_ahci_io_poll(struct tegrabl_sata_context *context);
+
+/**
+ * @brief Erases storage device connected to sata controller by issuing
+ * DATA SET MANAGEMENT TRIM commands for the range. Each command carries
+ * as many LBA range entries as the device accepts.
  *
  * @param context Context information
  * @param block start sector from which erasing should start
@@ -58,6 +58,21 @@ static tegrabl_error_t tegrabl_sata_bdev_ioctl(
 	case TEGRABL_IOCTL_DEVICE_CACHE_FLUSH:
 		error = tegrabl_sata_ahci_flush_device(context);
 		break;
+	case TEGRABL_IOCTL_ERASE_SUPPORT:
+		if (!argp) {
+			error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+			break;
+		}
+		*(bool *)argp = context->supports_trim;
+		break;
+	case TEGRABL_IOCTL_SECURE_ERASE_SUPPORT:
+		if (!argp) {
+			error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+			break;
+		}
+		/* TRIM does not guarantee the data is unrecoverable */
+		*(bool *)argp = false;
+		break;
 #endif
 	default:
 		pr_debug("Unknown ioctl %"PRIu32"\n", ioctl);
@@ -82,9 +97,7 @@ static tegrabl_error_t tegrabl_sata_bdev_read_block(struct tegrabl_bdev *dev,
 		 void *buffer, bnum_t block, bnum_t count)
 {
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
-	uint32_t bulk_count = 0;
 	struct tegrabl_sata_context *context = NULL;
-	uint8_t *buf = buffer;
 
 	if (!dev || !buffer) {
 		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
@@ -104,19 +117,9 @@ static tegrabl_error_t tegrabl_sata_bdev_read_block(struct tegrabl_bdev *dev,
 	}
 
 	pr_debug("%s: start block = %d, count = %d\n", __func__, block, count);
-	while (count != 0U) {
-		bulk_count = MIN(count, SATA_MAX_READ_WRITE_SECTORS);
-		error = tegrabl_sata_ahci_io(context, buf, block, bulk_count, false,
-				TEGRABL_SATA_READ_TIMEOUT);
-
-		if (error != TEGRABL_NO_ERROR) {
-			goto fail;
-		}
-
-		count -= bulk_count;
-		buf += (bulk_count << context->block_size_log2);
-		block += bulk_count;
-	}
+	/* AHCI layer splits the request as per command limits */
+	error = tegrabl_sata_ahci_io(context, buffer, block, count, false,
+			TEGRABL_SATA_READ_TIMEOUT);
 
 fail:
 	return error;
@@ -137,9 +140,7 @@ static tegrabl_error_t tegrabl_sata_bdev_write_block(struct tegrabl_bdev *dev,
 			 const void *buffer, bnum_t block, bnum_t count)
 {
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
-	uint32_t bulk_count = 0;
 	struct tegrabl_sata_context *context = NULL;
-	const uint8_t *buf = buffer;
 
 	if (!dev || !buffer) {
 		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
@@ -160,20 +161,9 @@ static tegrabl_error_t tegrabl_sata_bdev_write_block(struct tegrabl_bdev *dev,
 
 	pr_debug("%s: start block = %d, count = %d\n", __func__, block, count);
 
-	while (count) {
-		bulk_count = MIN(count, SATA_MAX_READ_WRITE_SECTORS);
-
-		error = tegrabl_sata_ahci_io(context, (void *)buf, block, bulk_count,
-				true, TEGRABL_SATA_WRITE_TIMEOUT);
-
-		if (error != TEGRABL_NO_ERROR) {
-			goto fail;
-		}
-
-		count -= bulk_count;
-		buf += (bulk_count << context->block_size_log2);
-		block += bulk_count;
-	}
+	/* AHCI layer splits the request as per command limits */
+	error = tegrabl_sata_ahci_io(context, (void *)buffer, block, count, true,
+			TEGRABL_SATA_WRITE_TIMEOUT);
 
 fail:
 	return error;
@@ -191,12 +181,93 @@ fail:
 static tegrabl_error_t tegrabl_sata_bdev_erase(
 		struct tegrabl_bdev *dev, bnum_t block, bnum_t count, bool is_secure)
 {
-	TEGRABL_UNUSED(dev);
-	TEGRABL_UNUSED(block);
-	TEGRABL_UNUSED(count);
-	TEGRABL_UNUSED(is_secure);
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	struct tegrabl_sata_context *context = NULL;
+
+	if (!dev) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+		goto fail;
+	}
+
+	context = (struct tegrabl_sata_context *)dev->priv_data;
+
+	if (!context) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+		goto fail;
+	}
+
+	if (is_secure) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 0);
+		goto fail;
+	}
+
+	if ((block + count) > context->block_count) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 0);
+		goto fail;
+	}
+
+	pr_debug("%s: start block = %d, count = %d\n", __func__, block, count);
+
+	error = tegrabl_sata_ahci_erase(context, block, count);
+
+fail:
+	return error;
+}
+#endif
+
+#if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
+/**
+ * @brief Starts an asynchronous read or write of the blocks of the request.
+ *
+ * @param dev Block device handle
+ * @param aio Request to be started
+ * @param is_write True if write operation
+ *
+ * @return TEGRABL_NO_ERROR if started else appropriate error.
+ */
+static tegrabl_error_t tegrabl_sata_bdev_xfer_start(struct tegrabl_bdev *dev,
+		tegrabl_aio_t *aio, bool is_write)
+{
+	struct tegrabl_sata_context *context = NULL;
+
+	if (!dev || !aio || !aio->buf) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 2);
+	}
+
+	context = (struct tegrabl_sata_context *)dev->priv_data;
+
+	if (!context) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 2);
+	}
+
+	if ((aio->block + aio->count) > context->block_count) {
+		return TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 2);
+	}
+
+	return tegrabl_sata_ahci_io_start(context, aio->buf, aio->block,
+			(bnum_t)aio->count, is_write,
+			is_write ? TEGRABL_SATA_WRITE_TIMEOUT : TEGRABL_SATA_READ_TIMEOUT);
+}
+
+static tegrabl_error_t tegrabl_sata_bdev_async_read_block(
+		struct tegrabl_bdev *dev, tegrabl_aio_t *aio)
+{
+	return tegrabl_sata_bdev_xfer_start(dev, aio, false);
+}
+
+static tegrabl_error_t tegrabl_sata_bdev_async_write_block(
+		struct tegrabl_bdev *dev, tegrabl_aio_t *aio)
+{
+	return tegrabl_sata_bdev_xfer_start(dev, aio, true);
+}
+
+static tegrabl_error_t tegrabl_sata_bdev_xfer_poll(struct tegrabl_bdev *dev,
+		tegrabl_aio_t *aio)
+{
+	TEGRABL_UNUSED(aio);
 
-	return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 0);
+	return tegrabl_sata_ahci_io_poll(
+			(struct tegrabl_sata_context *)dev->priv_data);
 }
 #endif
 
@@ -265,6 +336,9 @@ static tegrabl_error_t tegrabl_sata_register_region(
 #if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
 	user_dev->write_block = tegrabl_sata_bdev_write_block;
 	user_dev->erase = tegrabl_sata_bdev_erase;
+	user_dev->async_read_block = tegrabl_sata_bdev_async_read_block;
+	user_dev->async_write_block = tegrabl_sata_bdev_async_write_block;
+	user_dev->xfer_poll = tegrabl_sata_bdev_xfer_poll;
 #endif
 	user_dev->close = tegrabl_sata_bdev_close;
 	user_dev->ioctl = tegrabl_sata_bdev_ioctl;
@@ -17,6 +17,7 @@
 #include <tegrabl_sdmmc_bdev_local.h>
 #include <tegrabl_sdmmc_rpmb.h>
 #include <tegrabl_sdmmc_protocol.h>
+#include <tegrabl_sdmmc_host.h>
 #include <tegrabl_malloc.h>
 #include <tegrabl_clock.h>
 #include <tegrabl_module.h>
@@ -160,6 +161,9 @@ tegrabl_error_t sd_bdev_open(uint32_t instance)
 fail:
 
 	if ((error != TEGRABL_NO_ERROR) && context) {
+#if defined(CONFIG_ENABLE_SDMMC_ADMA2)
+		sdmmc_adma2_free_table(context);
+#endif
 		tegrabl_dealloc(TEGRABL_HEAP_DMA, context);
 	}
 
@@ -187,6 +191,9 @@ tegrabl_error_t sd_bdev_close(tegrabl_bdev_t *dev)
 	/* Close allocated context for sdmmc. */
 	if (priv_data && (context->count_devices == 1)) {
 		contexts[context->controller_id] = NULL;
+#if defined(CONFIG_ENABLE_SDMMC_ADMA2)
+		sdmmc_adma2_free_table(context);
+#endif
 		tegrabl_dealloc(TEGRABL_HEAP_DMA, context);
 	} else if (priv_data && context->count_devices) {
 		context->count_devices--;
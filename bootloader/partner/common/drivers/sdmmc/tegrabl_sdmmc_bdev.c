@@ -17,6 +17,7 @@
 #include <tegrabl_sdmmc_bdev_local.h>
 #include <tegrabl_sdmmc_rpmb.h>
 #include <tegrabl_sdmmc_protocol.h>
+#include <tegrabl_sdmmc_host.h>
 #include <tegrabl_malloc.h>
 #include <tegrabl_clock.h>
 #include <tegrabl_module.h>
@@ -135,6 +136,37 @@ fail:
 }
 #endif
 
+#if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
+tegrabl_error_t sdmmc_bdev_async_read_block(tegrabl_bdev_t *dev,
+	tegrabl_aio_t *aio)
+{
+	sdmmc_priv_data_t *priv_data = (sdmmc_priv_data_t *)dev->priv_data;
+
+	return sdmmc_io_start(dev, aio->buf, aio->block, (bnum_t)aio->count, 0,
+				(sdmmc_context_t *)priv_data->context, priv_data->device);
+}
+
+#if !defined(CONFIG_DISABLE_EMMC_BLOCK_WRITE)
+tegrabl_error_t sdmmc_bdev_async_write_block(tegrabl_bdev_t *dev,
+	tegrabl_aio_t *aio)
+{
+	sdmmc_priv_data_t *priv_data = (sdmmc_priv_data_t *)dev->priv_data;
+
+	return sdmmc_io_start(dev, aio->buf, aio->block, (bnum_t)aio->count, 1,
+				(sdmmc_context_t *)priv_data->context, priv_data->device);
+}
+#endif
+
+tegrabl_error_t sdmmc_bdev_xfer_poll(tegrabl_bdev_t *dev, tegrabl_aio_t *aio)
+{
+	sdmmc_priv_data_t *priv_data = (sdmmc_priv_data_t *)dev->priv_data;
+
+	TEGRABL_UNUSED(aio);
+
+	return sdmmc_io_poll((sdmmc_context_t *)priv_data->context);
+}
+#endif
+
 static tegrabl_error_t sdmmc_register_region(sdmmc_context_t *context)
 {
 	tegrabl_bdev_t *user_dev = NULL;
@@ -188,6 +220,11 @@ static tegrabl_error_t sdmmc_register_region(sdmmc_context_t *context)
 #endif
 #if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
 	boot_dev->erase = sdmmc_bdev_erase;
+	boot_dev->async_read_block = sdmmc_bdev_async_read_block;
+#if !defined(CONFIG_DISABLE_EMMC_BLOCK_WRITE)
+	boot_dev->async_write_block = sdmmc_bdev_async_write_block;
+#endif
+	boot_dev->xfer_poll = sdmmc_bdev_xfer_poll;
 #endif
 	boot_dev->close = sdmmc_bdev_close;
 	boot_dev->ioctl = sdmmc_bdev_ioctl;
@@ -239,10 +276,17 @@ static tegrabl_error_t sdmmc_register_region(sdmmc_context_t *context)
 #endif
 #if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
 	user_dev->erase = sdmmc_bdev_erase;
+	user_dev->async_read_block = sdmmc_bdev_async_read_block;
+#if !defined(CONFIG_DISABLE_EMMC_BLOCK_WRITE)
+	user_dev->async_write_block = sdmmc_bdev_async_write_block;
+#endif
+	user_dev->xfer_poll = sdmmc_bdev_xfer_poll;
 #endif
 	user_dev->close = sdmmc_bdev_close;
 	user_dev->ioctl = sdmmc_bdev_ioctl;
 	user_dev->priv_data = (void *)user_priv_data;
+	/* Boot and user regions are accessed through the same controller */
+	user_dev->xfer_queue_dev = boot_dev;
 
 	/* Register sdmmc_user device. */
 	pr_debug("registering user device\n");
@@ -295,6 +339,7 @@ static tegrabl_error_t sdmmc_register_region(sdmmc_context_t *context)
 	rpmb_dev->close = sdmmc_bdev_close;
 	rpmb_dev->ioctl = sdmmc_bdev_ioctl;
 	rpmb_dev->priv_data = (void *)rpmb_priv_data;
+	rpmb_dev->xfer_queue_dev = boot_dev;
 
 	/* Register sdmmc_rpmb device. */
 	pr_debug("registering rpmb device\n");
@@ -403,6 +448,9 @@ tegrabl_error_t sdmmc_bdev_open(
 fail:
 
 	if ((error != TEGRABL_NO_ERROR) && context) {
+#if defined(CONFIG_ENABLE_SDMMC_ADMA2)
+		sdmmc_adma2_free_table(context);
+#endif
 		tegrabl_dealloc(TEGRABL_HEAP_DMA, context);
 	}
 
@@ -428,6 +476,9 @@ tegrabl_error_t sdmmc_bdev_close(tegrabl_bdev_t *dev)
 	/* Close allocated context for sdmmc. */
 	if (priv_data && (context->count_devices == 1)) {
 		contexts[context->controller_id] = NULL;
+#if defined(CONFIG_ENABLE_SDMMC_ADMA2)
+		sdmmc_adma2_free_table(context);
+#endif
 		tegrabl_dealloc(TEGRABL_HEAP_DMA, context);
 	} else if (priv_data && context->count_devices) {
 		context->count_devices--;
@@ -58,6 +58,42 @@ tegrabl_error_t sdmmc_bdev_write_block(tegrabl_bdev_t *dev,
 	const void *buf, bnum_t block, bnum_t count);
 #endif
 
+#if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
+/** @brief Starts asynchronous read of the request. Completion has to
+ *         be checked with sdmmc_bdev_xfer_poll.
+ *
+ *  @param dev The registered bio device on which io is required.
+ *  @param aio Asynchronous io request.
+ *
+ *  @return TEGRABL_NO_ERROR if success, error code if fails.
+ */
+tegrabl_error_t sdmmc_bdev_async_read_block(tegrabl_bdev_t *dev,
+	tegrabl_aio_t *aio);
+
+#if !defined(CONFIG_DISABLE_EMMC_BLOCK_WRITE)
+/** @brief Starts asynchronous write of the request. Completion has to
+ *         be checked with sdmmc_bdev_xfer_poll.
+ *
+ *  @param dev The registered bio device on which io is required.
+ *  @param aio Asynchronous io request.
+ *
+ *  @return TEGRABL_NO_ERROR if success, error code if fails.
+ */
+tegrabl_error_t sdmmc_bdev_async_write_block(tegrabl_bdev_t *dev,
+	tegrabl_aio_t *aio);
+#endif
+
+/** @brief Checks the progress of asynchronous io request.
+ *
+ *  @param dev The registered bio device on which io is going on.
+ *  @param aio Asynchronous io request.
+ *
+ *  @return TEGRABL_ERR_BUSY if io is in progress, TEGRABL_NO_ERROR if
+ *          completed, error code if fails.
+ */
+tegrabl_error_t sdmmc_bdev_xfer_poll(tegrabl_bdev_t *dev, tegrabl_aio_t *aio);
+#endif
+
 #if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
 /** @brief Erase the number of sectors starting from offset argument till the
  *         number of sectors is equal to len. On successful read it returns the
@@ -14,6 +14,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <tegrabl_sdmmc_card_reg.h>
+#include <tegrabl_error.h>
 #include <tegrabl_debug.h>
 #include <tegrabl_timer.h>
 
@@ -211,6 +212,41 @@ typedef struct sdmmc_context {
 
 	bool is_hostv4_enabled;
 
+	/* Buffer of the ongoing block transfer */
+	uint8_t *xfer_buf;
+
+	/* Next sector of the ongoing block transfer */
+	uint32_t xfer_block;
+
+	/* Sectors left in the ongoing block transfer */
+	uint32_t xfer_count;
+
+	/* Sectors covered by the transfer programmed in the controller */
+	uint32_t xfer_current_count;
+
+	/* Is the ongoing block transfer a write */
+	uint8_t xfer_is_write;
+
+	/* Error which ended the last block transfer, kept till the next one */
+	tegrabl_error_t xfer_error;
+
+	/* Block length last set with SET_BLOCKLEN (CMD16), 0 if not known */
+	uint32_t cached_block_len;
+
+	/* Card takes SET_BLOCK_COUNT (CMD23) ahead of multi block transfers */
+	uint8_t supports_cmd23;
+
+	/* CMD23 was sent for the next data command, skip auto CMD12 */
+	uint8_t cmd23_issued;
+
+#if defined(CONFIG_ENABLE_SDMMC_ADMA2)
+	/* ADMA2 descriptor table, allocated on first use */
+	void *adma_table;
+
+	/* Is the ongoing block transfer done through ADMA2 */
+	uint8_t xfer_use_adma;
+#endif
+
 } sdmmc_context_t;
 
 #define SDMMC_BLOCK_SIZE_LOG2			9	/* 512 bytes */
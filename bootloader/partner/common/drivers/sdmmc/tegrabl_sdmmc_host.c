@@ -24,6 +24,9 @@
 #include <arapb_misc_gp.h>
 #include <tegrabl_drf.h>
 #include <tegrabl_addressmap.h>
+#if defined(CONFIG_ENABLE_SDMMC_ADMA2)
+#include <tegrabl_malloc.h>
+#endif
 
 /*  Defines the macro for reading from various offsets of sdmmc base controller.
  */
@@ -35,6 +38,32 @@
 #define sdmmc_writel(context, reg, value) \
 	NV_WRITE32((context->base_addr + SDMMC_##reg##_0), value);
 
+#if defined(CONFIG_ENABLE_SDMMC_ADMA2)
+/* Attributes of adma2 descriptors */
+#define ADMA2_ATTR_VALID				(1U << 0)
+#define ADMA2_ATTR_END					(1U << 1)
+#define ADMA2_ATTR_ACT_TRAN				(2U << 4)
+
+/* Descriptor for 32 bit addressing */
+struct sdmmc_adma2_desc32 {
+	uint16_t attr;
+	uint16_t len;
+	uint32_t addr;
+};
+
+/* Descriptor for 64 bit addressing in host version 4 mode */
+struct sdmmc_adma2_desc64 {
+	uint16_t attr;
+	uint16_t len;
+	uint32_t addr_lo;
+	uint32_t addr_hi;
+	uint32_t reserved;
+};
+
+#define ADMA2_DESC_SIZE(context) ((context)->is_hostv4_enabled ? \
+	sizeof(struct sdmmc_adma2_desc64) : sizeof(struct sdmmc_adma2_desc32))
+#endif
+
 /** @brief Wait till the internal clock is stable.
  *
  *  @param context Context information to determine the base
@@ -605,8 +634,11 @@ tegrabl_error_t sdmmc_prepare_cmd_reg(uint32_t *cmd_reg, uint8_t data_cmd,
 
 	/* Enable multiple block select. */
 	if ((index == CMD_READ_MULTIPLE) || (index == CMD_WRITE_MULTIPLE)) {
-		reg |= NV_DRF_NUM(SDMMC, CMD_XFER_MODE, MULTI_BLOCK_SELECT , 1) |
-				NV_DRF_DEF(SDMMC, CMD_XFER_MODE, AUTO_CMD12_EN, CMD12);
+		reg |= NV_DRF_NUM(SDMMC, CMD_XFER_MODE, MULTI_BLOCK_SELECT , 1);
+		/* Card stops by itself after a SET_BLOCK_COUNT (CMD23). */
+		if (context->cmd23_issued == 0U) {
+			reg |= NV_DRF_DEF(SDMMC, CMD_XFER_MODE, AUTO_CMD12_EN, CMD12);
+		}
 	}
 
 	/* Select data direction for write. */
@@ -1016,6 +1048,15 @@ void sdmmc_set_num_blocks(uint32_t block_size, uint32_t num_blocks,
  */
 void sdmmc_setup_dma(dma_addr_t buf, sdmmc_context_t *context)
 {
+#if defined(CONFIG_ENABLE_SDMMC_ADMA2)
+	uint32_t reg;
+
+	/* Previous transfer may have left adma2 selected. */
+	reg = sdmmc_readl(context, POWER_CONTROL_HOST);
+	reg = NV_FLD_SET_DRF_DEF(SDMMC, POWER_CONTROL_HOST, DMA_SELECT, SDMA, reg);
+	sdmmc_writel(context, POWER_CONTROL_HOST, reg);
+#endif
+
 	if (context->is_hostv4_enabled == false) {
 		sdmmc_writel(context, SYSTEM_ADDRESS, (uintptr_t)buf);
 	}
@@ -1027,6 +1068,96 @@ void sdmmc_setup_dma(dma_addr_t buf, sdmmc_context_t *context)
 #endif
 }
 
+#if defined(CONFIG_ENABLE_SDMMC_ADMA2)
+tegrabl_error_t sdmmc_adma2_alloc_table(sdmmc_context_t *context)
+{
+	if (context->adma_table != NULL) {
+		return TEGRABL_NO_ERROR;
+	}
+
+	context->adma_table = tegrabl_alloc_align(TEGRABL_HEAP_DMA, 64,
+		SDMMC_ADMA2_MAX_DESC * sizeof(struct sdmmc_adma2_desc64));
+	if (context->adma_table == NULL) {
+		return TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 13);
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+void sdmmc_adma2_free_table(sdmmc_context_t *context)
+{
+	if (context->adma_table != NULL) {
+		tegrabl_dealloc(TEGRABL_HEAP_DMA, context->adma_table);
+		context->adma_table = NULL;
+	}
+}
+
+tegrabl_error_t sdmmc_adma2_set_desc(sdmmc_context_t *context, uint32_t index,
+	dma_addr_t addr, uint32_t len, bool is_last)
+{
+	struct sdmmc_adma2_desc32 *desc32;
+	struct sdmmc_adma2_desc64 *desc64;
+	uint16_t attr;
+
+	if ((index >= SDMMC_ADMA2_MAX_DESC) || (len == 0U) ||
+		(len > SDMMC_ADMA2_MAX_DESC_LEN)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 48);
+	}
+
+	attr = ADMA2_ATTR_VALID | ADMA2_ATTR_ACT_TRAN;
+	if (is_last) {
+		attr |= ADMA2_ATTR_END;
+	}
+
+	if (context->is_hostv4_enabled) {
+		if ((addr & 0x7U) != 0U) {
+			return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 49);
+		}
+		desc64 = (struct sdmmc_adma2_desc64 *)context->adma_table + index;
+		desc64->attr = attr;
+		desc64->len = (uint16_t)len;
+		desc64->addr_lo = (uint32_t)addr;
+		desc64->addr_hi = (uint32_t)((uint64_t)addr >> 32);
+		desc64->reserved = 0;
+	} else {
+		if (((addr & 0x3U) != 0U) || (((uint64_t)addr >> 32) != 0U)) {
+			return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 50);
+		}
+		desc32 = (struct sdmmc_adma2_desc32 *)context->adma_table + index;
+		desc32->attr = attr;
+		desc32->len = (uint16_t)len;
+		desc32->addr = (uint32_t)addr;
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+void sdmmc_setup_adma2(sdmmc_context_t *context, uint32_t num_desc)
+{
+	dma_addr_t table;
+	uint32_t reg;
+
+	table = tegrabl_dma_map_buffer(TEGRABL_MODULE_SDMMC,
+		(uint8_t)context->controller_id, context->adma_table,
+		num_desc * ADMA2_DESC_SIZE(context), TEGRABL_DMA_TO_DEVICE);
+
+	sdmmc_writel(context, ADMA_SYSTEM_ADDRESS, (uint32_t)table);
+	if (context->is_hostv4_enabled) {
+		sdmmc_writel(context, UPPER_ADMA_SYSTEM_ADDRESS,
+			(uint32_t)((uint64_t)table >> 32));
+	}
+
+	reg = sdmmc_readl(context, POWER_CONTROL_HOST);
+	reg = NV_FLD_SET_DRF_DEF(SDMMC, POWER_CONTROL_HOST, DMA_SELECT, ADMA2,
+		reg);
+	sdmmc_writel(context, POWER_CONTROL_HOST, reg);
+
+	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_SDMMC,
+		(uint8_t)context->controller_id, context->adma_table,
+		num_desc * ADMA2_DESC_SIZE(context), TEGRABL_DMA_TO_DEVICE);
+}
+#endif
+
 /** @brief checks if card is in transfer state or not and perform various
  *         operations according to the mode of operation.
  *
@@ -1053,6 +1184,9 @@ sdmmc_device_status sdmmc_query_status(sdmmc_context_t *context)
 		NV_DRF_DEF(SDMMC, INTERRUPT_STATUS, COMMAND_CRC_ERR,
 			CRC_ERR_GENERATED) |
 		NV_DRF_DEF(SDMMC, INTERRUPT_STATUS, COMMAND_TIMEOUT_ERR, TIMEOUT);
+#if defined(CONFIG_ENABLE_SDMMC_ADMA2)
+	error_mask |= NV_DRF_DEF(SDMMC, INTERRUPT_STATUS, ADMA_ERR, ERR);
+#endif
 
 	dma_boundary_interrupt =
 		NV_DRF_DEF(SDMMC, INTERRUPT_STATUS, DMA_INTERRUPT, GEN_INT);
@@ -18,6 +18,14 @@
 /* defines the maximum transfer allowed by sdma */
 #define MAX_SDMA_TRANSFER			65535
 
+#if defined(CONFIG_ENABLE_SDMMC_ADMA2)
+/* defines the number of descriptors in the adma2 descriptor table */
+#define SDMMC_ADMA2_MAX_DESC		1024
+
+/* defines the maximum bytes covered by one adma2 descriptor */
+#define SDMMC_ADMA2_MAX_DESC_LEN	(32 * 1024)
+#endif
+
 /** @brief Resets all the registers of the controller.
  *
  *  @param context Context information to determine the base
@@ -204,6 +212,43 @@ void sdmmc_set_num_blocks(uint32_t block_size, uint32_t num_blocks,
  */
 void sdmmc_setup_dma(dma_addr_t buf, sdmmc_context_t *context);
 
+#if defined(CONFIG_ENABLE_SDMMC_ADMA2)
+/** @brief Allocates the adma2 descriptor table of the controller if not
+ *         allocated yet.
+ *
+ *  @param context Context information of the controller.
+ *  @return TEGRABL_NO_ERROR if success, error code if fails.
+ */
+tegrabl_error_t sdmmc_adma2_alloc_table(sdmmc_context_t *context);
+
+/** @brief Frees the adma2 descriptor table of the controller.
+ *
+ *  @param context Context information of the controller.
+ */
+void sdmmc_adma2_free_table(sdmmc_context_t *context);
+
+/** @brief Fills one transfer descriptor of the adma2 descriptor table.
+ *
+ *  @param context Context information of the controller.
+ *  @param index Index of the descriptor in the table.
+ *  @param addr DMA address of the data.
+ *  @param len Length of the data, at most SDMMC_ADMA2_MAX_DESC_LEN.
+ *  @param is_last Marks the descriptor as end of the chain.
+ *  @return TEGRABL_NO_ERROR if success, error code if the descriptor
+ *          cannot describe the data.
+ */
+tegrabl_error_t sdmmc_adma2_set_desc(sdmmc_context_t *context, uint32_t index,
+	dma_addr_t addr, uint32_t len, bool is_last);
+
+/** @brief Points the controller at the adma2 descriptor table and selects
+ *         adma2 for the next data command.
+ *
+ *  @param context Context information of the controller.
+ *  @param num_desc Number of valid descriptors in the table.
+ */
+void sdmmc_setup_adma2(sdmmc_context_t *context, uint32_t num_desc);
+#endif
+
 /** @brief checks if card is in transfer state or not and perform various
  *         operations according to the mode of operation.
  *
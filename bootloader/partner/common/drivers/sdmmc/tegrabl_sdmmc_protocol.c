@@ -133,6 +133,14 @@ static void sdmmc_set_default_context(sdmmc_context_t *context,
 		context->data_width = 4;
 	else
 		context->data_width = 8;
+
+	/* Block length of the card is not known until CMD16 is sent. */
+	context->cached_block_len = 0;
+
+	/* eMMC takes SET_BLOCK_COUNT ahead of CMD18/CMD25. */
+	context->supports_cmd23 =
+		(context->device_type == DEVICE_TYPE_EMMC) ? 1U : 0U;
+	context->cmd23_issued = 0;
 }
 
 tegrabl_error_t sdmmc_send_command(sdmmc_cmd index, uint32_t arg,
@@ -1098,44 +1106,216 @@ fail:
 	return error;
 }
 
-/** @brief Read/write from the input block till the count of blocks.
+/** @brief Sends SET_BLOCK_COUNT (CMD23) ahead of a multi block transfer so
+ *         that the card stops by itself and no CMD12 has to follow.
+ *         Falls back to auto CMD12 for good if the card rejects CMD23.
  *
- *  @param block Start sector for read/write.
- *  @param count Number of sectors to be read/write.
- *  @param buf Input buffer for read/write.
- *  @param is_write Is the command is for write or not.
+ *  @param num_blocks Number of blocks of the following transfer.
  *  @param context Context information to determine the base
  *                 address of controller.
+ */
+static void sdmmc_set_block_count(uint32_t num_blocks,
+	sdmmc_context_t *context)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	context->cmd23_issued = 0;
+
+	/* RPMB accesses send their own CMD23 with the reliable write flag. */
+	if ((context->supports_cmd23 == 0U) ||
+		(context->current_access_region == RPMB_PARTITION)) {
+		return;
+	}
+
+	error = sdmmc_send_command(CMD_SET_BLOCK_COUNT, num_blocks,
+							   RESP_TYPE_R1, 0, context);
+	if (error == TEGRABL_NO_ERROR) {
+		error = sdmmc_verify_response(CMD_SET_BLOCK_COUNT, 0, context);
+	}
+
+	if (error != TEGRABL_NO_ERROR) {
+		pr_debug("CMD23 failed, using auto CMD12\n");
+		context->supports_cmd23 = 0;
+		return;
+	}
+
+	context->cmd23_issued = 1;
+}
+
+#if defined(CONFIG_ENABLE_SDMMC_ADMA2)
+/** @brief Chains the mapped data of the next command in the adma2
+ *         descriptor table.
+ *
+ *  @param context Context information to determine the base
+ *                 address of controller.
+ *  @param dma_addr Device address of the data.
+ *  @param size Number of bytes the command transfers.
  *  @return TEGRABL_NO_ERROR if success, error code if fails.
  */
-static tegrabl_error_t sdmmc_block_io(bnum_t block, bnum_t count, uint8_t *buf,
-	uint8_t is_write, sdmmc_context_t *context)
+static tegrabl_error_t sdmmc_adma2_prepare(sdmmc_context_t *context,
+	dma_addr_t dma_addr, uint32_t size)
+{
+	uint32_t num_desc = 0;
+	uint32_t len;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	while (size > 0U) {
+		len = MIN(size, SDMMC_ADMA2_MAX_DESC_LEN);
+		size -= len;
+		/* Terminate the chain at the last descriptor. */
+		error = sdmmc_adma2_set_desc(context, num_desc, dma_addr, len,
+									 size == 0U);
+		if (error != TEGRABL_NO_ERROR) {
+			return error;
+		}
+		dma_addr += len;
+		num_desc++;
+	}
+
+	sdmmc_setup_adma2(context, num_desc);
+
+	return error;
+}
+#endif
+
+/** @brief Programs the controller for the next chunk of the ongoing block
+ *         transfer described by the xfer fields of the context.
+ *
+ *  @param context Context information to determine the base
+ *                 address of controller.
+ *  @return TEGRABL_NO_ERROR if success, error code if fails.
+ */
+static tegrabl_error_t sdmmc_block_io_next(sdmmc_context_t *context)
 {
 	uint32_t cmd_arg;
 	bnum_t current_start_sector;
-	bnum_t residue_start_sector;
 	bnum_t current_num_sectors;
-	bnum_t residue_num_sectors;
 	sdmmc_cmd cmd;
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
 	dma_addr_t dma_addr;
 	tegrabl_dma_data_direction dma_dir;
 
-	if ((context == NULL) || (buf == NULL)) {
-		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 9);
-		goto fail;
-	}
-
 	/* Decide which command is to be send. */
-	if (is_write)
+	if (context->xfer_is_write)
 		cmd = CMD_WRITE_MULTIPLE;
 	else
 		cmd = CMD_READ_MULTIPLE;
 
+	current_start_sector = context->xfer_block;
+	/* Sdma supports maximum of 32 MB of transfer. */
+	current_num_sectors = MIN(context->xfer_count, MAX_SDMA_TRANSFER);
+
+	/* Check if data line is ready for transfer. */
+	if (sdmmc_wait_for_data_line_ready(context)) {
+		error = sdmmc_recover_controller_error(context, 1);
+		if (error != TEGRABL_NO_ERROR)
+			goto fail;
+	}
+	pr_debug("residue_start_sector = %d, residue_num_sectors = %d\n",
+		context->xfer_block, context->xfer_count);
+
+	/* Select access region. This will change start & num sector */
+	/* based on the region the request falls in. */
+
+	if ((context->current_access_region ==
+				BOOT_PARTITION_1) ||
+			(context->current_access_region ==
+				BOOT_PARTITION_2)) {
+		error = sdmmc_get_correct_boot_block(
+					&current_start_sector,
+					&current_num_sectors, context);
+		if (error != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+	}
+	pr_debug("Region = %d (1->BP1, 2->BP2, 0->UP)\n",
+			context->current_access_region);
+
+	pr_debug("actual_start_sector = %d, actual_num_sectors = %d\n",
+			current_start_sector, current_num_sectors);
+
+	/* Set number of blocks to read or write. */
+	sdmmc_set_num_blocks(SDMMC_CONTEXT_BLOCK_SIZE(context),
+						 current_num_sectors, context);
+
+	/* Set up command arg. */
+	cmd_arg = (uint32_t) current_start_sector;
+
+	pr_debug(
+			"cur_Start_Sector = %d, cur_num_sectors = %d,cmd_arg = %d\n",
+			current_start_sector,
+			current_num_sectors, cmd_arg);
+
+	dma_dir = context->xfer_is_write ?
+		TEGRABL_DMA_TO_DEVICE : TEGRABL_DMA_FROM_DEVICE;
+	dma_addr = tegrabl_dma_map_buffer(TEGRABL_MODULE_SDMMC,
+		context->controller_id, context->xfer_buf,
+		current_num_sectors << context->block_size_log2, dma_dir);
+
+#if defined(CONFIG_ENABLE_SDMMC_ADMA2)
+	if (context->xfer_use_adma) {
+		/* Chain the data in the adma2 descriptor table. */
+		error = sdmmc_adma2_prepare(context, dma_addr,
+			current_num_sectors << context->block_size_log2);
+		if (error != TEGRABL_NO_ERROR) {
+			tegrabl_dma_unmap_buffer(TEGRABL_MODULE_SDMMC,
+				(uint8_t)(context->controller_id), context->xfer_buf,
+				current_num_sectors << context->block_size_log2, dma_dir);
+			goto fail;
+		}
+	} else
+#endif
+	{
+		/* Setup Dma. */
+		pr_debug("sdma buffer address\n");
+		sdmmc_setup_dma(dma_addr, context);
+	}
+
+	sdmmc_set_block_count(current_num_sectors, context);
+
+	/* Send command to Card. */
+	error = sdmmc_send_command(cmd, cmd_arg, RESP_TYPE_R1, 1, context);
+	context->cmd23_issued = 0;
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	/* If response fails, return error. Nothing to clean up. */
+	error = sdmmc_verify_response(cmd, 0, context);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	context->xfer_current_count = current_num_sectors;
+	context->device_status = DEVICE_STATUS_IO_PROGRESS;
+	context->read_start_time = tegrabl_get_timestamp_ms();
+
+fail:
+	return error;
+}
+
+/** @brief Sets the block length if needed and programs the first chunk of
+ *         the transfer whose buffers are already stored in the context.
+ *
+ *  @param block Start sector for read/write.
+ *  @param count Number of sectors to be read/write.
+ *  @param is_write Is the command is for write or not.
+ *  @param context Context information to determine the base
+ *                 address of controller.
+ *  @return TEGRABL_NO_ERROR if success, error code if fails.
+ */
+static tegrabl_error_t sdmmc_block_io_begin(bnum_t block, bnum_t count,
+	uint8_t is_write, sdmmc_context_t *context)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	/* Enable block length setting if not DDR mode. Card keeps the */
+	/* block length, so it is only sent when it changes. */
+	if (((context->data_width == DATA_WIDTH_4BIT) ||
+		(context->data_width == DATA_WIDTH_8BIT)) &&
+		(context->cached_block_len != SDMMC_CONTEXT_BLOCK_SIZE(context))) {
+		context->cached_block_len = 0;
 
-	/* Enable block length setting if not DDR mode. */
-	if ((context->data_width == DATA_WIDTH_4BIT) ||
-		(context->data_width == DATA_WIDTH_8BIT)) {
 		/* Send SET_BLOCKLEN(CMD16) Command. */
 		error = sdmmc_send_command(CMD_SET_BLOCK_LENGTH,
 								   SDMMC_CONTEXT_BLOCK_SIZE(context),
@@ -1150,102 +1330,141 @@ static tegrabl_error_t sdmmc_block_io(bnum_t block, bnum_t count, uint8_t *buf,
 		if (error != TEGRABL_NO_ERROR) {
 			goto fail;
 		}
+
+		context->cached_block_len = SDMMC_CONTEXT_BLOCK_SIZE(context);
 	}
-	/* Store start and end sectors in temporary variable. */
-	residue_num_sectors = count;
-	residue_start_sector = block;
 
-	while (residue_num_sectors) {
-		current_start_sector = residue_start_sector;
-		current_num_sectors = residue_num_sectors;
+	/* Store start and end sectors in the context. */
+	context->xfer_block = block;
+	context->xfer_count = count;
+	context->xfer_is_write = is_write;
+	context->xfer_error = TEGRABL_NO_ERROR;
 
-		/* Check if data line is ready for transfer. */
-		if (sdmmc_wait_for_data_line_ready(context)) {
-			error = sdmmc_recover_controller_error(context, 1);
-			if (error != TEGRABL_NO_ERROR)
-				goto fail;
-		}
-		pr_debug("residue_start_sector = %d, residue_num_sectors = %d\n",
-			residue_start_sector, residue_num_sectors);
-
-		/* Select access region. This will change start & num sector */
-		/* based on the region the request falls in. */
-
-		if ((context->current_access_region ==
-					BOOT_PARTITION_1) ||
-				(context->current_access_region ==
-					BOOT_PARTITION_2)) {
-			error = sdmmc_get_correct_boot_block(
-						&current_start_sector,
-						&current_num_sectors, context);
-			if (error != TEGRABL_NO_ERROR) {
-				goto fail;
-			}
-		}
-		pr_debug("Region = %d (1->BP1, 2->BP2, 0->UP)\n",
-				context->current_access_region);
+	error = sdmmc_block_io_next(context);
+	if (error != TEGRABL_NO_ERROR) {
+		context->xfer_count = 0;
+		context->xfer_error = error;
+	}
 
-		pr_debug("actual_start_sector = %d, actual_num_sectors = %d\n",
-				current_start_sector, current_num_sectors);
+fail:
+	if (error) {
+		pr_debug("%s: exit error = %x\n", __func__, error);
+	}
+	return error;
+}
 
-		/* Set number of blocks to read or write. */
-		sdmmc_set_num_blocks(SDMMC_CONTEXT_BLOCK_SIZE(context),
-							 current_num_sectors, context);
+/** @brief Starts read/write from the input block till the count of blocks.
+ *         Transfer has to be completed by polling with sdmmc_block_io_poll.
+ *
+ *  @param block Start sector for read/write.
+ *  @param count Number of sectors to be read/write.
+ *  @param buf Input buffer for read/write.
+ *  @param is_write Is the command is for write or not.
+ *  @param context Context information to determine the base
+ *                 address of controller.
+ *  @return TEGRABL_NO_ERROR if success, error code if fails.
+ */
+static tegrabl_error_t sdmmc_block_io_start(bnum_t block, bnum_t count,
+	uint8_t *buf, uint8_t is_write, sdmmc_context_t *context)
+{
+	if ((context == NULL) || (buf == NULL)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 9);
+	}
 
-		/* Set up command arg. */
-		cmd_arg = (uint32_t) current_start_sector;
+	context->xfer_buf = buf;
 
-		pr_debug(
-				"cur_Start_Sector = %d, cur_num_sectors = %d,cmd_arg = %d\n",
-				current_start_sector,
-				current_num_sectors, cmd_arg);
+#if defined(CONFIG_ENABLE_SDMMC_ADMA2)
+	/* Use adma2 when the buffer meets its alignment, else plain sdma. */
+	context->xfer_use_adma = (((uintptr_t)buf & 0x7U) == 0U) &&
+		(sdmmc_adma2_alloc_table(context) == TEGRABL_NO_ERROR);
+#endif
 
-		dma_dir = is_write ? TEGRABL_DMA_TO_DEVICE : TEGRABL_DMA_FROM_DEVICE;
-		dma_addr = tegrabl_dma_map_buffer(TEGRABL_MODULE_SDMMC,
-			context->controller_id, buf,
-			current_num_sectors << context->block_size_log2, dma_dir);
+	return sdmmc_block_io_begin(block, count, is_write, context);
+}
 
-		/* Setup Dma. */
-		pr_debug("sdma buffer address\n");
-		sdmmc_setup_dma(dma_addr, context);
+/** @brief Checks the progress of the ongoing block transfer and programs the
+ *         next chunk once the current one is done.
+ *
+ *  @param context Context information to determine the base
+ *                 address of controller.
+ *  @return TEGRABL_ERR_BUSY if transfer is in progress, TEGRABL_NO_ERROR if
+ *          whole transfer is done, error code if fails. The error is also
+ *          kept in the context till the next transfer is started.
+ */
+static tegrabl_error_t sdmmc_block_io_poll(sdmmc_context_t *context)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
 
-		/* Send command to Card. */
-		error = sdmmc_send_command(cmd, cmd_arg, RESP_TYPE_R1, 1, context);
-		if (error != TEGRABL_NO_ERROR) {
-			goto fail;
-		}
+	if (sdmmc_query_status(context) == DEVICE_STATUS_IO_PROGRESS) {
+		return TEGRABL_ERROR(TEGRABL_ERR_BUSY, 2);
+	}
 
-		/* If response fails, return error. Nothing to clean up. */
-		error = sdmmc_verify_response(cmd, 0, context);
-		if (error != TEGRABL_NO_ERROR) {
-			goto fail;
-		}
+	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_SDMMC,
+					(uint8_t)(context->controller_id), context->xfer_buf,
+					context->xfer_current_count << context->block_size_log2,
+					context->xfer_is_write ? TEGRABL_DMA_TO_DEVICE :
+						TEGRABL_DMA_FROM_DEVICE);
 
-		context->device_status = DEVICE_STATUS_IO_PROGRESS;
-		context->read_start_time = tegrabl_get_timestamp_ms();
+	/* Error out if device is not idle. */
+	if (sdmmc_query_status(context) != DEVICE_STATUS_IDLE) {
+		error = context->xfer_is_write ?
+			TEGRABL_ERROR(TEGRABL_ERR_WRITE_FAILED, 0) :
+			TEGRABL_ERROR(TEGRABL_ERR_READ_FAILED, 0);
+		pr_info("device is not idle\n");
+		goto fail;
+	}
 
-		/* Wait for idle condition. */
-		while (sdmmc_query_status(context) == DEVICE_STATUS_IO_PROGRESS)
-			;
+	/* Update the start sectos and num sectors accordingly. */
+	context->xfer_count -= context->xfer_current_count;
+	context->xfer_block += context->xfer_current_count;
+	context->xfer_buf +=
+		(context->xfer_current_count << context->block_size_log2);
+	context->xfer_current_count = 0;
 
-		tegrabl_dma_unmap_buffer(TEGRABL_MODULE_SDMMC,
-							(uint8_t)(context->controller_id), buf,
-							current_num_sectors << context->block_size_log2,
-							dma_dir);
+	if (context->xfer_count == 0U) {
+		goto fail;
+	}
 
-		/* Error out if device is not idle. */
-		if (sdmmc_query_status(context) != DEVICE_STATUS_IDLE) {
-			error = TEGRABL_ERROR(TEGRABL_ERR_BUSY, 1);
-			pr_info("device is not idle\n");
-			goto fail;
-		}
+	error = sdmmc_block_io_next(context);
+	if (error == TEGRABL_NO_ERROR) {
+		return TEGRABL_ERROR(TEGRABL_ERR_BUSY, 2);
+	}
+
+fail:
+	if (error) {
+		context->xfer_count = 0;
+		context->xfer_error = error;
+		pr_debug("%s: exit error = %x\n", __func__, error);
+	}
+	return error;
+}
+
+/** @brief Read/write from the input block till the count of blocks.
+ *
+ *  @param block Start sector for read/write.
+ *  @param count Number of sectors to be read/write.
+ *  @param buf Input buffer for read/write.
+ *  @param is_write Is the command is for write or not.
+ *  @param context Context information to determine the base
+ *                 address of controller.
+ *  @return TEGRABL_NO_ERROR if success, error code if fails.
+ */
+static tegrabl_error_t sdmmc_block_io(bnum_t block, bnum_t count, uint8_t *buf,
+	uint8_t is_write, sdmmc_context_t *context)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
 
-		/* Update the start sectos and num sectors accordingly. */
-		residue_num_sectors -= current_num_sectors;
-		residue_start_sector += current_num_sectors;
-		buf += (current_num_sectors << context->block_size_log2);
+	error = sdmmc_block_io_start(block, count, buf, is_write, context);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
 	}
 
+	/* Wait for idle condition. */
+	do {
+		error = sdmmc_block_io_poll(context);
+	} while (TEGRABL_ERROR_REASON(error) == TEGRABL_ERR_BUSY &&
+			 (context->xfer_count != 0U));
+
 fail:
 	if (error) {
 		pr_debug("%s: exit error = %x\n", __func__, error);
@@ -1538,33 +1757,21 @@ fail:
 	return error;
 }
 
-/** @brief Read/write from the input block till the count of blocks.
+/** @brief Selects the access region for the device and checks that the
+ *         blocks to be accessed lie inside it.
  *
  *  @param dev Bio device from which read/write is done.
- *  @param buf Input buffer for read/write.
  *  @param block Start sector for read/write.
  *  @param count Number of sectors to be read/write.
- *  @param is_write Is the command is for write or not.
  *  @param context Context information to determine the base
  *                 address of controller.
  *  @param device User or Boot device to be accessed.
  *
  *  @return TEGRABL_NO_ERROR if success, error code if fails.
  */
-tegrabl_error_t sdmmc_io(tegrabl_bdev_t *dev, void *buf, bnum_t block,
-	bnum_t count, uint8_t is_write, sdmmc_context_t *context,
-	sdmmc_device device)
+static tegrabl_error_t sdmmc_io_prepare(tegrabl_bdev_t *dev, bnum_t block,
+	bnum_t count, sdmmc_context_t *context, sdmmc_device device)
 {
-	uint32_t i = 0;
-	bnum_t current_sectors = 0;
-	tegrabl_error_t error = TEGRABL_NO_ERROR;
-	uint8_t *pbuf = buf;
-
-	if ((dev == NULL) || (buf == NULL) || (context == NULL)) {
-		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 12);
-		goto fail;
-	}
-
 	/* Mark the device is idle. */
 	context->device_status = DEVICE_STATUS_IDLE;
 	pr_debug("StartBlock= %d NumofBlock = %d\n", block, count);
@@ -1578,8 +1785,7 @@ tegrabl_error_t sdmmc_io(tegrabl_bdev_t *dev, void *buf, bnum_t block,
 			sdmmc_select_access_region(context, USER_PARTITION);
 		} else {
 			pr_debug("wrong block to look for\n");
-			error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 13);
-			goto fail;
+			return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 13);
 		}
 	}
 
@@ -1587,24 +1793,67 @@ tegrabl_error_t sdmmc_io(tegrabl_bdev_t *dev, void *buf, bnum_t block,
 	if ((block > (dev->block_count - 1)) ||
 		((block + count) > (dev->block_count))) {
 		pr_debug("block %d outside range with count %u\n", block, count);
-		error = TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 0);
+		return TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 0);
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+tegrabl_error_t sdmmc_io_start(tegrabl_bdev_t *dev, void *buf, bnum_t block,
+	bnum_t count, uint8_t is_write, sdmmc_context_t *context,
+	sdmmc_device device)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	if ((dev == NULL) || (buf == NULL) || (context == NULL)) {
+		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 12);
 		goto fail;
 	}
-	/* Sdma supports maximum of 32 MB of transfer. */
-	while (i < count) {
-		current_sectors =
-			(count - i) > MAX_SDMA_TRANSFER ? MAX_SDMA_TRANSFER : (count - i);
 
-		error = sdmmc_block_io(block + i, current_sectors, pbuf, is_write,
-					context);
-		if (error != TEGRABL_NO_ERROR) {
-			goto fail;
-		}
+	error = sdmmc_io_prepare(dev, block, count, context, device);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	error = sdmmc_block_io_start(block, count, buf, is_write, context);
+
+fail:
+	if (error != TEGRABL_NO_ERROR) {
+		pr_debug("%s: exit error = %x\n", __func__, error);
+	}
+	return error;
+}
+
+tegrabl_error_t sdmmc_io_poll(sdmmc_context_t *context)
+{
+	if (context == NULL) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 25);
+	}
 
-		i += current_sectors;
-		pbuf += (current_sectors << context->block_size_log2);
+	/* Transfer is over, report how it ended */
+	if (context->xfer_count == 0U) {
+		return context->xfer_error;
 	}
 
+	return sdmmc_block_io_poll(context);
+}
+
+tegrabl_error_t sdmmc_io(tegrabl_bdev_t *dev, void *buf, bnum_t block,
+	bnum_t count, uint8_t is_write, sdmmc_context_t *context,
+	sdmmc_device device)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	error = sdmmc_io_start(dev, buf, block, count, is_write, context, device);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	do {
+		error = sdmmc_io_poll(context);
+	} while (TEGRABL_ERROR_REASON(error) == TEGRABL_ERR_BUSY &&
+			 (context->xfer_count != 0U));
+
 fail:
 	if (error != TEGRABL_NO_ERROR) {
 		pr_debug("%s: exit error = %x\n", __func__, error);
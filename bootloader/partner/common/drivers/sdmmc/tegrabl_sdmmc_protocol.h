@@ -212,6 +212,34 @@ tegrabl_error_t sdmmc_io(tegrabl_bdev_t *dev, void *buf, bnum_t block,
 	bnum_t count, uint8_t is_write, sdmmc_context_t *context,
 	sdmmc_device device);
 
+/** @brief Starts read/write from the input block till the count of blocks
+ *         and returns without waiting for the transfer to complete.
+ *
+ *  @param dev Bio device from which read/write is done.
+ *  @param buf Input buffer for read/write.
+ *  @param block Start sector for read/write.
+ *  @param count Number of sectors to be read/write.
+ *  @param is_write Is the command is for write or not.
+ *  @param context Context information to determine the base
+ *                 address of controller.
+ *  @param device User or Boot device to be accessed.
+ *
+ *  @return TEGRABL_NO_ERROR if success, error code if fails.
+ */
+tegrabl_error_t sdmmc_io_start(tegrabl_bdev_t *dev, void *buf, bnum_t block,
+	bnum_t count, uint8_t is_write, sdmmc_context_t *context,
+	sdmmc_device device);
+
+/** @brief Checks the progress of the transfer started by sdmmc_io_start.
+ *
+ *  @param context Context information to determine the base
+ *                 address of controller.
+ *
+ *  @return TEGRABL_ERR_BUSY if transfer is in progress, TEGRABL_NO_ERROR
+ *          if transfer is completed, error code if fails.
+ */
+tegrabl_error_t sdmmc_io_poll(sdmmc_context_t *context);
+
 /** @brief Performs erase from given offset till the length of sectors.
  *
  *  @param dev Bio device handle in which erase is required.
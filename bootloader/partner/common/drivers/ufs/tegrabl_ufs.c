@@ -1093,6 +1093,37 @@ tegrabl_error_t tegrabl_ufs_queue_trd(uint32_t trd_index, uint32_t trd_timeout)
 	return TEGRABL_NO_ERROR;
 }
 
+/** Queues all TRDs in trd_mask with a single doorbell write. On failure
+ *  nothing is queued and the caller still owns the TRDs.
+ */
+static tegrabl_error_t
+tegrabl_ufs_queue_trd_list(uint32_t trd_mask, struct tegrabl_ufs_rw_trd *prw_trd,
+			uint32_t num_trd)
+{
+	uint32_t reg_data;
+	uint32_t starttime;
+	uint32_t i;
+
+	reg_data = UFS_READ32(UTRLDBR);
+	if ((reg_data & trd_mask) != 0U) {
+		return TEGRABL_ERROR(TEGRABL_ERR_FATAL, 8U);
+	}
+
+	/* Doorbell bits are write-1-to-set, zeroes leave other slots alone */
+	UFS_WRITE32(UTRLDBR, trd_mask);
+
+	starttime = tegrabl_get_timestamp_us();
+	for (i = 0; i < num_trd; i++) {
+		memset((void *)&pufs_context->trd_info[prw_trd[i].trd_index],
+			0, sizeof(struct trdinfo));
+		pufs_context->trd_info[prw_trd[i].trd_index].trd_starttime =
+			starttime;
+		pufs_context->trd_info[prw_trd[i].trd_index].trd_timeout =
+			prw_trd[i].timeout;
+	}
+	return TEGRABL_NO_ERROR;
+}
+
 static tegrabl_error_t
 tegrabl_ufs_wait_trd_request_complete(uint32_t trd_index, uint32_t timeout)
 {
@@ -1864,34 +1895,12 @@ fail:
 	return error;
 }
 
-tegrabl_error_t
-tegrabl_ufs_rw_common(const uint32_t block, const uint32_t page,
-			const uint32_t length, uint32_t *pbuffer, uint32_t opcode)
+#if defined(UFS_REQUEST_SENSE)
+static tegrabl_error_t tegrabl_ufs_wait_lun_ready(void)
 {
-	uint32_t trd_index = 0;
-	uint32_t cmd_desc_index = 0;
-	struct cmd_descriptor *plcmd_descriptor;
-	struct command_upiu *pcommand_upiu;
-	struct response_upiu *presponse_upiu;
-	uint32_t pending_length = length;
-	uint32_t prdt_length;
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
-#if defined(UFS_REQUEST_SENSE)
 	uint32_t lun_ready = 0;
-#endif
-	uint32_t direction = (opcode == SCSI_WRITE10_OPCODE) ? 1 : 0;
-
-	TEGRABL_UNUSED(page);
 
-	pr_debug("UFS R/W block %d len %d\n", block, length);
-
-	if (length > MAX_PRDT_LENGTH*MAX_BLOCKS) {
-		pr_error("# of blocks %u > %u\n", length,
-			 (unsigned int)MAX_PRDT_LENGTH*MAX_BLOCKS);
-		return error;
-	}
-
-#if defined(UFS_REQUEST_SENSE)
 	do {
 		error = tegrabl_ufs_test_unit_ready(pufs_context->boot_lun);
 		if (error == TEGRABL_NO_ERROR) {
@@ -1911,8 +1920,28 @@ tegrabl_ufs_rw_common(const uint32_t block, const uint32_t page,
 			return error;
 		}
 	} while (!lun_ready);
+
+	return error;
+}
 #endif
 
+/** Builds the command UPIU, PRDT and TRD of a READ(10)/WRITE(10) request
+ *  without ringing the doorbell.
+ */
+static tegrabl_error_t
+tegrabl_ufs_prepare_rw_trd(const uint32_t block, const uint32_t length,
+			uint32_t *pbuffer, uint32_t opcode,
+			struct tegrabl_ufs_rw_trd *prw_trd)
+{
+	uint32_t trd_index = 0;
+	uint32_t cmd_desc_index = 0;
+	struct cmd_descriptor *plcmd_descriptor;
+	struct command_upiu *pcommand_upiu;
+	uint32_t pending_length = length;
+	uint32_t prdt_length;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	uint32_t direction = (opcode == SCSI_WRITE10_OPCODE) ? 1 : 0;
+
 	error = tegrabl_ufs_get_tx_rx_descriptor(&trd_index);
 	if (error != TEGRABL_NO_ERROR) {
 		pr_error("ufs: Tx/Rx Descriptor not available.\n");
@@ -1922,6 +1951,7 @@ tegrabl_ufs_rw_common(const uint32_t block, const uint32_t page,
 	error = tegrabl_ufs_get_cmd_descriptor(&cmd_desc_index);
 	if (error != TEGRABL_NO_ERROR) {
 		pr_error("ufs: Command Descriptor not available\n");
+		pufs_context->tx_req_des_in_use--;
 		return error;
 	}
 
@@ -1936,7 +1966,8 @@ tegrabl_ufs_rw_common(const uint32_t block, const uint32_t page,
 				UFS_UPIU_FLAGS_W_SHIFT : UFS_UPIU_FLAGS_R_SHIFT);
 	pcommand_upiu->basic_header.lun = pufs_context->boot_lun;
 	pcommand_upiu->basic_header.cmd_set_type = UPIU_COMMAND_SET_SCSI;
-	pcommand_upiu->basic_header.task_tag = (direction ? 0x14 : 0x15);
+	/* Task tag has to be unique among outstanding requests */
+	pcommand_upiu->basic_header.task_tag = (uint8_t)trd_index;
 	pcommand_upiu->expected_data_tx_len_bige =
 		BYTE_SWAP32(length * (1 << pufs_context->page_size_log2));
 
@@ -2005,17 +2036,56 @@ tegrabl_ufs_rw_common(const uint32_t block, const uint32_t page,
 				(direction ? DATA_DIR_H2D : DATA_DIR_D2H),
 				prdt_length);
 	if (error != TEGRABL_NO_ERROR) {
+		tegrabl_ufs_free_trd_cmd_desc();
 		return error;
 	}
 
-	error = tegrabl_ufs_queue_trd(trd_index,
-					prdt_length * SCSI_REQ_READ_TIMEOUT);
-	if (error != TEGRABL_NO_ERROR) {
-		return error;
-	}
+	prw_trd->trd_index = trd_index;
+	prw_trd->cmd_desc_index = cmd_desc_index;
+	prw_trd->pbuffer = pbuffer;
+	prw_trd->length = length;
+	prw_trd->direction = direction;
+	prw_trd->timeout = prdt_length * SCSI_REQ_READ_TIMEOUT;
 
-	error = tegrabl_ufs_wait_trd_request_complete(trd_index,
-				prdt_length * SCSI_REQ_READ_TIMEOUT);
+	return error;
+}
+
+/** Releases the descriptors and data buffer mapping of a READ(10)/WRITE(10)
+ *  TRD that was prepared but never handed to the controller.
+ */
+static void tegrabl_ufs_release_rw_trd(struct tegrabl_ufs_rw_trd *prw_trd)
+{
+	struct cmd_descriptor *plcmd_descriptor;
+
+	plcmd_descriptor = &pcmd_descriptor[prw_trd->cmd_desc_index];
+
+	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_UFS, 0,
+		&plcmd_descriptor->vucd_generic_resp_upiu,
+		sizeof(union ucd_generic_resp_upiu),
+		TEGRABL_DMA_FROM_DEVICE);
+
+	tegrabl_ufs_free_trd_cmd_desc();
+
+	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_UFS, 0,
+		prw_trd->pbuffer, prw_trd->length * 4096,
+		(prw_trd->direction ? TEGRABL_DMA_TO_DEVICE :
+		 TEGRABL_DMA_FROM_DEVICE));
+}
+
+/** Waits for a queued READ(10)/WRITE(10) TRD, checks its response and
+ *  releases its descriptors.
+ */
+static tegrabl_error_t
+tegrabl_ufs_complete_rw_trd(struct tegrabl_ufs_rw_trd *prw_trd)
+{
+	struct cmd_descriptor *plcmd_descriptor;
+	struct response_upiu *presponse_upiu;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	plcmd_descriptor = &pcmd_descriptor[prw_trd->cmd_desc_index];
+
+	error = tegrabl_ufs_wait_trd_request_complete(prw_trd->trd_index,
+				prw_trd->timeout);
 	if (error != TEGRABL_NO_ERROR) {
 		return error;
 	}
@@ -2047,14 +2117,246 @@ tegrabl_ufs_rw_common(const uint32_t block, const uint32_t page,
 	tegrabl_ufs_free_trd_cmd_desc();
 
 	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_UFS, 0,
-		pbuffer, length * 4096,
-		(direction ? TEGRABL_DMA_TO_DEVICE : TEGRABL_DMA_FROM_DEVICE));
+		prw_trd->pbuffer, prw_trd->length * 4096,
+		(prw_trd->direction ? TEGRABL_DMA_TO_DEVICE :
+		 TEGRABL_DMA_FROM_DEVICE));
+
+	return error;
+}
+
+tegrabl_error_t
+tegrabl_ufs_rw_common(const uint32_t block, const uint32_t page,
+			const uint32_t length, uint32_t *pbuffer, uint32_t opcode)
+{
+	struct tegrabl_ufs_rw_trd rw_trd;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	TEGRABL_UNUSED(page);
+
+	pr_debug("UFS R/W block %d len %d\n", block, length);
+
+	if (length > MAX_PRDT_LENGTH*MAX_BLOCKS) {
+		pr_error("# of blocks %u > %u\n", length,
+			 (unsigned int)MAX_PRDT_LENGTH*MAX_BLOCKS);
+		return error;
+	}
+
+#if defined(UFS_REQUEST_SENSE)
+	error = tegrabl_ufs_wait_lun_ready();
+	if (error != TEGRABL_NO_ERROR) {
+		return error;
+	}
+#endif
+
+	error = tegrabl_ufs_prepare_rw_trd(block, length, pbuffer, opcode,
+				&rw_trd);
+	if (error != TEGRABL_NO_ERROR) {
+		return error;
+	}
+
+	error = tegrabl_ufs_queue_trd(rw_trd.trd_index, rw_trd.timeout);
+	if (error != TEGRABL_NO_ERROR) {
+		return error;
+	}
+
+	error = tegrabl_ufs_complete_rw_trd(&rw_trd);
+	if (error != TEGRABL_NO_ERROR) {
+		return error;
+	}
 
 	pr_debug("R/W successfull\n");
 
 	return error;
 }
 
+/* Queued R/W started by tegrabl_ufs_rw_queued_start() */
+static struct tegrabl_ufs_rw_queue {
+	struct tegrabl_ufs_rw_trd rw_trd[UFS_MAX_QUEUED_TRD];
+	uint32_t num_trd;
+	uint32_t trd_mask;
+	uint32_t block;
+	uint32_t length;
+	uint8_t *buf;
+	uint32_t batch_block;
+	uint32_t opcode;
+	bool active;
+	tegrabl_error_t error;
+} ufs_rw_queue;
+
+/** Builds the next batch of TRDs of the queued R/W and rings the doorbell
+ *  for all of them at once.
+ */
+static tegrabl_error_t tegrabl_ufs_rw_queue_batch(
+			struct tegrabl_ufs_rw_queue *queue)
+{
+	uint32_t max_trd;
+	uint32_t chunk;
+	uint32_t i;
+	tegrabl_error_t error;
+
+	/*
+	 * TRDs share cache lines, so the list is never written while the
+	 * controller owns any entry of it: a whole batch is built first,
+	 * queued with one doorbell write and drained before the next one.
+	 */
+	max_trd = MIN(MAX_TRD_NUM - pufs_context->tx_req_des_in_use,
+				MAX_CMD_DESC_NUM - pufs_context->cmd_desc_in_use);
+	max_trd = MIN(max_trd, UFS_MAX_QUEUED_TRD);
+	if (max_trd == 0) {
+		return TEGRABL_ERROR(TEGRABL_ERR_RESOURCE_MAX, 2U);
+	}
+
+	queue->trd_mask = 0;
+	queue->batch_block = queue->block;
+	for (queue->num_trd = 0;
+		 (queue->num_trd < max_trd) && (queue->length > 0); queue->num_trd++) {
+		chunk = MIN(queue->length, MAX_PRDT_LENGTH * MAX_BLOCKS);
+		error = tegrabl_ufs_prepare_rw_trd(queue->block, chunk,
+					(uint32_t *)queue->buf, queue->opcode,
+					&queue->rw_trd[queue->num_trd]);
+		if (error != TEGRABL_NO_ERROR) {
+			/* Whatever got prepared is still queued and drained */
+			queue->error = error;
+			queue->length = 0;
+			break;
+		}
+		queue->trd_mask |= 1U << queue->rw_trd[queue->num_trd].trd_index;
+		queue->block += chunk;
+		queue->length -= chunk;
+		queue->buf += chunk * BLOCK_SIZE;
+	}
+
+	if (queue->trd_mask == 0U) {
+		return queue->error;
+	}
+
+	error = tegrabl_ufs_queue_trd_list(queue->trd_mask, queue->rw_trd,
+				queue->num_trd);
+	if (error != TEGRABL_NO_ERROR) {
+		for (i = 0; i < queue->num_trd; i++) {
+			tegrabl_ufs_release_rw_trd(&queue->rw_trd[i]);
+		}
+		queue->num_trd = 0;
+		queue->trd_mask = 0;
+		return error;
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+tegrabl_error_t
+tegrabl_ufs_rw_queued_start(uint32_t block, uint32_t length,
+			uint32_t *pbuffer, uint32_t opcode)
+{
+	struct tegrabl_ufs_rw_queue *queue = &ufs_rw_queue;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	pr_debug("UFS queued R/W block %d len %d\n", block, length);
+
+	if (queue->active) {
+		return TEGRABL_ERROR(TEGRABL_ERR_BUSY, 0U);
+	}
+
+#if defined(UFS_REQUEST_SENSE)
+	error = tegrabl_ufs_wait_lun_ready();
+	if (error != TEGRABL_NO_ERROR) {
+		return error;
+	}
+#endif
+
+	queue->block = block;
+	queue->length = length;
+	queue->buf = (uint8_t *)pbuffer;
+	queue->opcode = opcode;
+	queue->num_trd = 0;
+	queue->trd_mask = 0;
+	queue->error = TEGRABL_NO_ERROR;
+
+	if (length == 0U) {
+		return TEGRABL_NO_ERROR;
+	}
+
+	error = tegrabl_ufs_rw_queue_batch(queue);
+	if (error != TEGRABL_NO_ERROR) {
+		pr_error("ufs queued R/W failed at block %u\n", queue->batch_block);
+		return error;
+	}
+
+	queue->active = true;
+
+	return TEGRABL_NO_ERROR;
+}
+
+tegrabl_error_t tegrabl_ufs_rw_queued_poll(void)
+{
+	struct tegrabl_ufs_rw_queue *queue = &ufs_rw_queue;
+	struct trdinfo *trd_info;
+	uint32_t now;
+	uint32_t i;
+	tegrabl_error_t err;
+
+	/* Transfer is over, report how it ended */
+	if (!queue->active) {
+		return queue->error;
+	}
+
+	if ((UFS_READ32(UTRLDBR) & queue->trd_mask) != 0U) {
+		now = tegrabl_get_timestamp_us();
+		for (i = 0; i < queue->num_trd; i++) {
+			trd_info = &pufs_context->trd_info[queue->rw_trd[i].trd_index];
+			if ((now - trd_info->trd_starttime) < trd_info->trd_timeout) {
+				return TEGRABL_ERROR(TEGRABL_ERR_BUSY, 1U);
+			}
+		}
+		/* Timed out, completing the TRDs below reports the error */
+	}
+
+	/* Drain everything queued even if one request fails */
+	for (i = 0; i < queue->num_trd; i++) {
+		err = tegrabl_ufs_complete_rw_trd(&queue->rw_trd[i]);
+		if ((err != TEGRABL_NO_ERROR) && (queue->error == TEGRABL_NO_ERROR)) {
+			queue->error = err;
+		}
+	}
+	queue->num_trd = 0;
+	queue->trd_mask = 0;
+
+	if ((queue->error == TEGRABL_NO_ERROR) && (queue->length > 0)) {
+		err = tegrabl_ufs_rw_queue_batch(queue);
+		if (err == TEGRABL_NO_ERROR) {
+			return TEGRABL_ERROR(TEGRABL_ERR_BUSY, 2U);
+		}
+		queue->error = err;
+	}
+
+	queue->active = false;
+	if (queue->error != TEGRABL_NO_ERROR) {
+		pr_error("ufs queued R/W failed at block %u\n", queue->batch_block);
+	} else {
+		pr_debug("Queued R/W successfull\n");
+	}
+
+	return queue->error;
+}
+
+tegrabl_error_t
+tegrabl_ufs_rw_queued(uint32_t block, uint32_t length, uint32_t *pbuffer,
+			uint32_t opcode)
+{
+	tegrabl_error_t error;
+
+	error = tegrabl_ufs_rw_queued_start(block, length, pbuffer, opcode);
+	if (error != TEGRABL_NO_ERROR) {
+		return error;
+	}
+
+	do {
+		error = tegrabl_ufs_rw_queued_poll();
+	} while (TEGRABL_ERROR_REASON(error) == TEGRABL_ERR_BUSY);
+
+	return error;
+}
+
 tegrabl_error_t
 tegrabl_ufs_read(const uint32_t block, const uint32_t page,
 			const uint32_t length, uint32_t *pbuffer)
@@ -2069,6 +2371,12 @@ tegrabl_ufs_read(const uint32_t block, const uint32_t page,
 	return error;
 }
 
+tegrabl_error_t
+tegrabl_ufs_read_queued(uint32_t block, uint32_t length, uint32_t *pbuffer)
+{
+	return tegrabl_ufs_rw_queued(block, length, pbuffer, SCSI_READ10_OPCODE);
+}
+
 tegrabl_error_t
 tegrabl_ufs_write(const uint32_t block,
 			const uint32_t page,
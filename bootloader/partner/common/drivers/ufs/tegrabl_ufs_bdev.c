@@ -67,13 +67,6 @@ fail:
 	return error;
 }
 
-#if defined(CONFIG_ENABLE_UFS_KPI)
-static time_t last_read_start_time;
-static time_t last_read_end_time;
-static time_t total_read_time;
-static uint32_t total_read_size;
-#endif
-
 /**
  * @brief Reads number of block from specified block into buffer
  *
@@ -92,10 +85,6 @@ static tegrabl_error_t tegrabl_ufs_bdev_read_block(
 	uint32_t bulk_count = 0;
 	struct tegrabl_ufs_context *context = NULL;
 	uint8_t *buf = buffer;
-#if defined(CONFIG_ENABLE_UFS_KPI)
-	last_read_start_time = tegrabl_get_timestamp_us();
-	total_read_size += count;
-#endif
 	if (!dev || !buffer) {
 		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
 		goto fail;
@@ -114,6 +103,15 @@ static tegrabl_error_t tegrabl_ufs_bdev_read_block(
 	}
 
 
+	/* Large reads are split across several TRDs kept in flight together */
+	if (count > UFS_RW_BLOCK_MAX) {
+		error = tegrabl_ufs_read_queued(block, count, (uint32_t *)buf);
+		if (error != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+		count = 0;
+	}
+
 	while (count) {
 		bulk_count = MIN(count, UFS_RW_BLOCK_MAX);
 		error = tegrabl_ufs_read(block, 0,
@@ -126,23 +124,10 @@ static tegrabl_error_t tegrabl_ufs_bdev_read_block(
 		buf += (bulk_count << context->block_size_log2);
 		block += bulk_count;
 	}
-#if defined(CONFIG_ENABLE_UFS_KPI)
-	last_read_end_time = tegrabl_get_timestamp_us();
-	total_read_time += last_read_end_time - last_read_start_time;
-	pr_info("total read time is =%"PRIu64"\n", total_read_time);
-	pr_info("total blocks is =%0x\n", total_read_size);
-#endif
 fail:
 	return error;
 }
 
-#if defined(CONFIG_ENABLE_UFS_KPI)
-static time_t last_write_start_time;
-static time_t last_write_end_time;
-static time_t total_write_time;
-static uint32_t total_write_size;
-#endif
-
 #if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
 /**
  * @brief Writes number of blocks from specified block with content from buffer
@@ -163,10 +148,6 @@ tegrabl_ufs_bdev_write_block(struct tegrabl_bdev *dev,
 	struct tegrabl_ufs_context *context = NULL;
 	const uint8_t *buf = buffer;
 
-#if defined(CONFIG_ENABLE_UFS_KPI)
-	last_write_start_time = tegrabl_get_timestamp_us();
-	total_write_size += count;
-#endif
 	if (!dev || !buffer) {
 		error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
 		goto fail;
@@ -196,12 +177,6 @@ tegrabl_ufs_bdev_write_block(struct tegrabl_bdev *dev,
 		buf += (bulk_count << context->block_size_log2);
 		block += bulk_count;
 	}
-#if defined(CONFIG_ENABLE_UFS_KPI)
-	last_write_end_time = tegrabl_get_timestamp_us();
-	total_write_time += last_write_end_time - last_write_start_time;
-	pr_info("total write time is =%"PRIu64"\n", total_write_time);
-	pr_info("total blocks is =%0x\n", total_write_size);
-#endif
 fail:
 	return error;
 }
@@ -230,6 +205,62 @@ static tegrabl_error_t tegrabl_ufs_bdev_erase(
 }
 #endif
 
+#if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
+/**
+ * @brief Starts an asynchronous read or write of the blocks of the request
+ * through the queued TRD path.
+ *
+ * @param dev Block device handle
+ * @param aio Request to be started
+ * @param opcode SCSI opcode of the transfer
+ *
+ * @return TEGRABL_NO_ERROR if started else appropriate error.
+ */
+static tegrabl_error_t tegrabl_ufs_bdev_xfer_start(struct tegrabl_bdev *dev,
+		tegrabl_aio_t *aio, uint32_t opcode)
+{
+	struct tegrabl_ufs_context *context = NULL;
+
+	if (!dev || !aio || !aio->buf) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 1);
+	}
+
+	context = (struct tegrabl_ufs_context *)dev->priv_data;
+
+	if (!context) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 1);
+	}
+
+	if ((aio->block + aio->count) > context->boot_lun_num_blocks) {
+		return TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 1);
+	}
+
+	return tegrabl_ufs_rw_queued_start(aio->block, (uint32_t)aio->count,
+				(uint32_t *)aio->buf, opcode);
+}
+
+static tegrabl_error_t tegrabl_ufs_bdev_async_read_block(
+		struct tegrabl_bdev *dev, tegrabl_aio_t *aio)
+{
+	return tegrabl_ufs_bdev_xfer_start(dev, aio, SCSI_READ10_OPCODE);
+}
+
+static tegrabl_error_t tegrabl_ufs_bdev_async_write_block(
+		struct tegrabl_bdev *dev, tegrabl_aio_t *aio)
+{
+	return tegrabl_ufs_bdev_xfer_start(dev, aio, SCSI_WRITE10_OPCODE);
+}
+
+static tegrabl_error_t tegrabl_ufs_bdev_xfer_poll(struct tegrabl_bdev *dev,
+		tegrabl_aio_t *aio)
+{
+	TEGRABL_UNUSED(dev);
+	TEGRABL_UNUSED(aio);
+
+	return tegrabl_ufs_rw_queued_poll();
+}
+#endif
+
 /**
  * @brief Closes the Bio device instance
  *
@@ -289,6 +320,9 @@ static tegrabl_error_t tegrabl_ufs_register_region(
 #if !defined(CONFIG_ENABLE_BLOCKDEV_BASIC)
 	user_dev->write_block = tegrabl_ufs_bdev_write_block;
 	user_dev->erase = tegrabl_ufs_bdev_erase;
+	user_dev->async_read_block = tegrabl_ufs_bdev_async_read_block;
+	user_dev->async_write_block = tegrabl_ufs_bdev_async_write_block;
+	user_dev->xfer_poll = tegrabl_ufs_bdev_xfer_poll;
 #endif
 	user_dev->close = tegrabl_ufs_bdev_close;
 	user_dev->ioctl = tegrabl_ufs_bdev_ioctl;
@@ -19,6 +19,8 @@
 #define UFS_PAGE_SIZE_LOG2   12
 #define SCSI_REQ_READ_TIMEOUT      1000000
 #define SCSI_REQ_ERASE_TIMEOUT      1000000000
+/* Max number of READ(10)/WRITE(10) TRDs rung with one doorbell write */
+#define UFS_MAX_QUEUED_TRD   MAX_TRD_NUM
 
 /* Create UFS context structure
 */
@@ -28,6 +30,16 @@ struct trdinfo {
 	uint32_t trd_timeout;
 };
 
+/* Book keeping of a READ(10)/WRITE(10) TRD until it completes */
+struct tegrabl_ufs_rw_trd {
+	uint32_t trd_index;
+	uint32_t cmd_desc_index;
+	uint32_t *pbuffer;
+	uint32_t length;
+	uint32_t direction;
+	uint32_t timeout;
+};
+
 struct tegrabl_ufs_internal_params {
 	uint32_t boot_enabled;
 	uint32_t page_size_log2;
@@ -65,8 +77,15 @@ tegrabl_error_t tegrabl_ufs_init(const struct tegrabl_ufs_params *params,
 	struct tegrabl_ufs_context *context);
 tegrabl_error_t tegrabl_ufs_rw_common(const uint32_t block, const uint32_t page,
 			const uint32_t length, uint32_t *pbuffer, uint32_t direction);
+tegrabl_error_t tegrabl_ufs_rw_queued(uint32_t block, uint32_t length,
+	uint32_t *pbuffer, uint32_t opcode);
+tegrabl_error_t tegrabl_ufs_rw_queued_start(uint32_t block, uint32_t length,
+	uint32_t *pbuffer, uint32_t opcode);
+tegrabl_error_t tegrabl_ufs_rw_queued_poll(void);
 tegrabl_error_t tegrabl_ufs_read(const uint32_t block, const uint32_t page,
 	const uint32_t length, uint32_t *pbuffer);
+tegrabl_error_t tegrabl_ufs_read_queued(uint32_t block, uint32_t length,
+	uint32_t *pbuffer);
 tegrabl_error_t tegrabl_ufs_write(const uint32_t block, const uint32_t page,
 	const uint32_t length, uint32_t *pbuffer);
 void tegrabl_ufs_get_params(const uint32_t param_index,
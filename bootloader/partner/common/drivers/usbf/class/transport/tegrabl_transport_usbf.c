@@ -437,6 +437,20 @@ struct usbf_config config_fastboot = {
 static uint8_t tempbuf[MAX_TCM_BUFFER_SUPPORTED];
 static uint8_t *ptempbuf = (uint8_t *)&tempbuf[0];
 
+/**
+ * @brief Converts transfer timeout in msec to the per event timeout in usec
+ * which xusbf driver polls with. Timeouts which do not fit are treated as
+ * the longest one supported.
+ */
+static uint32_t transport_usbf_timeout_us(time_t timeout)
+{
+	if (timeout >= (UINT32_MAX / 1000U)) {
+		return UINT32_MAX;
+	}
+
+	return (uint32_t)timeout * 1000U;
+}
+
 static bool is_buffer_from_tcm(const void *buf)
 {
 	uint8_t *tcm_start = (uint8_t *)(NV_ADDRESS_MAP_BPMP_BTCM_BASE);
@@ -458,8 +472,8 @@ tegrabl_error_t tegrabl_transport_usbf_send(const void *buffer,
 	uint32_t tfr_length;
 	uint32_t bytes_sent = 0;
 	uint8_t *buf = (uint8_t *)buffer;
+	uint32_t timeout_us = transport_usbf_timeout_us(timeout);
 
-	TEGRABL_UNUSED(timeout);
 	*bytes_transmitted = 0;
 	/*
 	 1) Check given buffer is from BTCM, need to maintain local buffer
@@ -482,7 +496,8 @@ tegrabl_error_t tegrabl_transport_usbf_send(const void *buffer,
 		else
 			tfr_length = length;
 
-		retval = tegrabl_usbf_transmit((uint8_t *)buf, tfr_length, &bytes_sent);
+		retval = tegrabl_usbf_transmit((uint8_t *)buf, tfr_length, &bytes_sent,
+									   timeout_us);
 		if (retval != TEGRABL_NO_ERROR) {
 			pr_critical(
 							   "ERROR: Add to request queue failed\n");
@@ -509,9 +524,8 @@ tegrabl_error_t tegrabl_transport_usbf_receive(void *buf, uint32_t length,
 	uint32_t bytes_received = 0;
 	void *dataptr = buf;
 	bool is_tcm_buffer = is_buffer_from_tcm(buf);
+	uint32_t timeout_us = transport_usbf_timeout_us(timeout);
 
-
-	TEGRABL_UNUSED(timeout);
 	*received = 0;
 
 	if (is_tcm_buffer) {
@@ -522,6 +536,14 @@ tegrabl_error_t tegrabl_transport_usbf_receive(void *buf, uint32_t length,
 							   "ERROR: Passed TCM buffer greater than 1K\n");
 			return TEGRABL_ERR_BAD_PARAMETER;
 		}
+	} else if (length > MAX_TFR_LENGTH) {
+		/* Keep multiple TRBs in flight for large transfers */
+		retval = tegrabl_usbf_receive_multi((uint8_t *)buf, length, received,
+											timeout_us);
+		if (retval != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+		return TEGRABL_NO_ERROR;
 	}
 
 	while (length != 0U) {
@@ -531,7 +553,7 @@ tegrabl_error_t tegrabl_transport_usbf_receive(void *buf, uint32_t length,
 			tfr_length = length;
 
 		retval = tegrabl_usbf_receive((uint8_t *)dataptr, tfr_length,
-					 &bytes_received);
+					 &bytes_received, timeout_us);
 		if (retval != TEGRABL_NO_ERROR) {
 			goto fail;
 		}
@@ -553,6 +575,35 @@ fail:
 	return retval;
 }
 
+tegrabl_error_t tegrabl_transport_usbf_receive_start(void *buf,
+													 uint32_t length)
+{
+	if ((buf == NULL) || is_buffer_from_tcm(buf)) {
+		return TEGRABL_ERR_BAD_PARAMETER;
+	}
+
+	return tegrabl_usbf_receive_multi_start((uint8_t *)buf, length);
+}
+
+tegrabl_error_t tegrabl_transport_usbf_receive_complete(uint32_t *received,
+														time_t timeout)
+{
+	tegrabl_error_t retval = TEGRABL_NO_ERROR;
+
+	retval = tegrabl_usbf_receive_multi_complete(received,
+			transport_usbf_timeout_us(timeout));
+	if (retval != TEGRABL_NO_ERROR) {
+		pr_critical("ERROR: USB RECEIVE FAILED\n");
+	}
+
+	return retval;
+}
+
+void tegrabl_transport_usbf_receive_abort(void)
+{
+	tegrabl_usbf_receive_multi_abort();
+}
+
 #if defined(CONFIG_ENABLE_USBF_SNO)
 static tegrabl_error_t update_usbf_serial_no(void)
 {
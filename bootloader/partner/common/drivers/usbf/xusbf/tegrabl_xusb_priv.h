@@ -189,6 +189,12 @@ struct xusb_device_context {
 	uint32_t enumerated;
 	uint32_t bytes_txfred;
 	uint32_t tx_count;
+	uint32_t rx_short_pkt; /* Short packet seen on EP1_OUT */
+	/* State of multi TRB receive on EP1_OUT */
+	uint8_t *rx_buffer;
+	dma_addr_t rx_dma_buf;
+	uint32_t rx_bytes;
+	uint32_t rx_queued;
 	uint32_t cntrl_seq_num;
 	uint32_t setup_pkt_index;
 	uint32_t config_num;
@@ -57,6 +57,16 @@
 #define NUM_TRB_TRANSFER_RING 16
 #define NUM_EP_CONTEXT  4
 
+/* Bulk out TRBs kept armed by tegrabl_usbf_receive_multi(). One ring entry
+ * is the link TRB and one is left free so that a full ring can be told
+ * apart from an empty one.
+ */
+#define RX_MAX_ARMED_TRBS (NUM_TRB_TRANSFER_RING - 2)
+/* Largest transfer length a normal TRB can describe. */
+#define RX_MAX_TRB_LENGTH (64 * 1024)
+/* Time in usec to wait for events already posted for cancelled TRBs. */
+#define CANCEL_EVENT_TIMEOUT_US 100
+
 /* 512 bytes. */
 #define SETUP_DATA_BUFFER_SIZE     (0x200)
 
@@ -1620,6 +1630,9 @@ static tegrabl_error_t tegrabl_handle_txfer_event(
 			p_xusb_dev_context->tx_count--;
 			/* Short packet is not necessary an error
 			* because we prime for 4K bytes. */
+			if (p_tx_eventrb->trb_tx_len != 0U) {
+				p_xusb_dev_context->rx_short_pkt = 1;
+			}
 		}
 		/* This should be zero except in the case of a short packet. */
 	} else if (p_tx_eventrb->comp_code == CTRL_DIR_ERR_CODE) {
@@ -1971,8 +1984,44 @@ tegrabl_error_t tegrabl_usbf_enumerate(uint8_t *buffer)
 	return TEGRABL_NO_ERROR;
 }
 
+/**
+ * @brief Drops TRBs still armed on a bulk endpoint after a failed transfer.
+ * Endpoint is stopped and its ring is reset so that no TRB is left pointing
+ * into the caller's buffer.
+ *
+ * @param ep_index Bulk endpoint to be reset.
+ */
+static void tegrabl_usbf_cancel_ep(enum endpoint ep_index)
+{
+	struct xusb_device_context *p_xusb_dev_context = &s_xusb_device_context;
+	uint32_t i;
+
+	if (p_xusb_dev_context->tx_count == 0U) {
+		return;
+	}
+
+	pr_warn("%s: dropping %u armed TRBs of ep %d\n", __func__,
+			p_xusb_dev_context->tx_count, ep_index);
+	tegrabl_disable_ep(ep_index);
+
+	/* Consume events posted before endpoint stopped, they refer to
+	 * ring entries which are about to be reset.
+	 */
+	for (i = 0; i < NUM_TRB_EVENT_RING; i++) {
+		if (tegrabl_poll_for_event(CANCEL_EVENT_TIMEOUT_US) !=
+			TEGRABL_NO_ERROR) {
+			break;
+		}
+	}
+
+	if (tegrabl_initep(ep_index, false) != TEGRABL_NO_ERROR) {
+		pr_error("%s: failed to reset ep %d\n", __func__, ep_index);
+	}
+	p_xusb_dev_context->tx_count = 0;
+}
+
 tegrabl_error_t tegrabl_usbf_receive(uint8_t *buffer, uint32_t bytes,
-		uint32_t *bytes_received)
+		uint32_t *bytes_received, uint32_t timeout_us)
 {
 	tegrabl_error_t e = TEGRABL_NO_ERROR;
 	uint32_t direction;
@@ -1994,8 +2043,9 @@ tegrabl_error_t tegrabl_usbf_receive(uint8_t *buffer, uint32_t bytes,
 	tegrabl_issue_normal_trb(dma_buf, bytes, direction);
 	p_xusb_dev_context->tx_count++;
 	while (p_xusb_dev_context->tx_count) {
-		e = tegrabl_poll_for_event(0xFFFFFFFF);
+		e = tegrabl_poll_for_event(timeout_us);
 		if (e != TEGRABL_NO_ERROR) {
+			tegrabl_usbf_cancel_ep(EP1_OUT);
 			break;
 		}
 	}
@@ -2007,8 +2057,169 @@ tegrabl_error_t tegrabl_usbf_receive(uint8_t *buffer, uint32_t bytes,
 	return e;
 }
 
+/**
+ * @brief Arms bulk out TRBs for the not yet queued part of the multi TRB
+ * receive, as long as ring has free entries. Doorbell is rung once for
+ * the whole batch.
+ */
+static tegrabl_error_t tegrabl_usbf_rx_multi_arm(void)
+{
+	tegrabl_error_t e = TEGRABL_NO_ERROR;
+	struct xusb_device_context *p_xusb_dev_context = &s_xusb_device_context;
+	struct normal_trb normal_trb;
+	uint32_t tfr_length;
+	uint32_t ring_doorbell;
+
+	while ((p_xusb_dev_context->rx_queued < p_xusb_dev_context->rx_bytes) &&
+		   (p_xusb_dev_context->tx_count < RX_MAX_ARMED_TRBS) &&
+		   (p_xusb_dev_context->rx_short_pkt == 0U)) {
+		tfr_length = MIN(p_xusb_dev_context->rx_bytes -
+						 p_xusb_dev_context->rx_queued,
+						 (uint32_t)RX_MAX_TRB_LENGTH);
+		ring_doorbell = ((p_xusb_dev_context->rx_queued + tfr_length) ==
+							p_xusb_dev_context->rx_bytes) ||
+			((p_xusb_dev_context->tx_count + 1U) == RX_MAX_ARMED_TRBS);
+
+		memset((void *)&normal_trb, 0, sizeof(struct normal_trb));
+		tegrabl_create_normal_trb(&normal_trb,
+				p_xusb_dev_context->rx_dma_buf + p_xusb_dev_context->rx_queued,
+				tfr_length, DIR_OUT);
+		e = tegrabl_queue_trb(EP1_OUT, &normal_trb, ring_doorbell);
+		if (e != TEGRABL_NO_ERROR) {
+			return e;
+		}
+
+		p_xusb_dev_context->bytes_txfred += tfr_length;
+		p_xusb_dev_context->tx_count++;
+		p_xusb_dev_context->rx_queued += tfr_length;
+	}
+	p_xusb_dev_context->wait_for_eventt = NORMAL_TRB;
+
+	return e;
+}
+
+/**
+ * @brief Gives up multi TRB receive. Bulk out endpoint is reset and buffer
+ * is unmapped.
+ */
+static void tegrabl_usbf_rx_multi_cancel(void)
+{
+	struct xusb_device_context *p_xusb_dev_context = &s_xusb_device_context;
+
+	if (p_xusb_dev_context->rx_buffer == NULL) {
+		return;
+	}
+
+	tegrabl_usbf_cancel_ep(EP1_OUT);
+
+	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_XUSBF, 0,
+				(void *)p_xusb_dev_context->rx_buffer,
+				p_xusb_dev_context->rx_bytes, TEGRABL_DMA_FROM_DEVICE);
+	p_xusb_dev_context->rx_buffer = NULL;
+}
+
+tegrabl_error_t tegrabl_usbf_receive_multi_start(uint8_t *buffer,
+		uint32_t bytes)
+{
+	tegrabl_error_t e = TEGRABL_NO_ERROR;
+	struct xusb_device_context *p_xusb_dev_context = &s_xusb_device_context;
+
+	if (buffer == NULL) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+	}
+
+	p_xusb_dev_context->bytes_txfred = 0;
+	p_xusb_dev_context->tx_count = 0;
+	p_xusb_dev_context->rx_short_pkt = 0;
+	p_xusb_dev_context->rx_buffer = buffer;
+	p_xusb_dev_context->rx_bytes = bytes;
+	p_xusb_dev_context->rx_queued = 0;
+
+	p_xusb_dev_context->rx_dma_buf = tegrabl_dma_map_buffer(
+				TEGRABL_MODULE_XUSBF, 0, (void *)buffer, bytes,
+				TEGRABL_DMA_FROM_DEVICE);
+
+	e = tegrabl_usbf_rx_multi_arm();
+	if (e != TEGRABL_NO_ERROR) {
+		tegrabl_usbf_rx_multi_cancel();
+	}
+
+	return e;
+}
+
+tegrabl_error_t tegrabl_usbf_receive_multi_complete(uint32_t *bytes_received,
+		uint32_t timeout_us)
+{
+	tegrabl_error_t e = TEGRABL_NO_ERROR;
+	struct xusb_device_context *p_xusb_dev_context = &s_xusb_device_context;
+
+	if ((bytes_received == NULL) || (p_xusb_dev_context->rx_buffer == NULL)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+	}
+
+	while (p_xusb_dev_context->tx_count != 0U) {
+		e = tegrabl_poll_for_event(timeout_us);
+		if (e != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+
+		/* Host ended the transfer early. Data of later TRBs would not be
+		 * contiguous with what was received, so give up.
+		 */
+		if ((p_xusb_dev_context->rx_short_pkt != 0U) &&
+			((p_xusb_dev_context->tx_count != 0U) ||
+			 (p_xusb_dev_context->rx_queued < p_xusb_dev_context->rx_bytes))) {
+			pr_error("%s: short packet with %u bytes pending\n", __func__,
+					 p_xusb_dev_context->rx_bytes -
+					 p_xusb_dev_context->bytes_txfred);
+			e = TEGRABL_ERROR(TEGRABL_ERR_INVALID_STATE, 1);
+			goto fail;
+		}
+
+		/* Re-arm ring with next pieces of buffer as TRBs complete so that
+		 * endpoint never runs dry.
+		 */
+		e = tegrabl_usbf_rx_multi_arm();
+		if (e != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+	}
+
+fail:
+	*bytes_received = p_xusb_dev_context->bytes_txfred;
+
+	/* On error TRBs may still be armed, stop endpoint before the buffer
+	 * is handed back to caller.
+	 */
+	tegrabl_usbf_rx_multi_cancel();
+
+	return e;
+}
+
+void tegrabl_usbf_receive_multi_abort(void)
+{
+	tegrabl_usbf_rx_multi_cancel();
+}
+
+tegrabl_error_t tegrabl_usbf_receive_multi(uint8_t *buffer, uint32_t bytes,
+		uint32_t *bytes_received, uint32_t timeout_us)
+{
+	tegrabl_error_t e = TEGRABL_NO_ERROR;
+
+	if ((buffer == NULL) || (bytes_received == NULL)) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+	}
+
+	e = tegrabl_usbf_receive_multi_start(buffer, bytes);
+	if (e != TEGRABL_NO_ERROR) {
+		return e;
+	}
+
+	return tegrabl_usbf_receive_multi_complete(bytes_received, timeout_us);
+}
+
 tegrabl_error_t tegrabl_usbf_transmit(uint8_t *buffer, uint32_t bytes,
-		uint32_t *bytes_transmitted)
+		uint32_t *bytes_transmitted, uint32_t timeout_us)
 {
 	tegrabl_error_t e = TEGRABL_NO_ERROR;
 	uint32_t direction;
@@ -2031,8 +2242,9 @@ tegrabl_error_t tegrabl_usbf_transmit(uint8_t *buffer, uint32_t bytes,
 	p_xusb_dev_context->tx_count++;
 
 	while (p_xusb_dev_context->tx_count) {
-		e = tegrabl_poll_for_event(0xFFFFFFFF);
+		e = tegrabl_poll_for_event(timeout_us);
 		if (e != TEGRABL_NO_ERROR) {
+			tegrabl_usbf_cancel_ep(EP1_IN);
 			break;
 		}
 	}
@@ -37,6 +37,40 @@ enum {
 	TEGRABL_IOCTL_INVALID,
 };
 
+/**
+* @brief Maximum number of asynchronous io requests which can be queued on
+*        a block device at a time
+*/
+#define TEGRABL_BLOCKDEV_AIO_QUEUE_DEPTH	8U
+
+#if defined(CONFIG_ENABLE_BLOCKDEV_CACHE)
+/**
+* @brief Bytes of DMA heap used for the read cache shared by all the block
+*        devices. Can be overridden from the build.
+*/
+#if !defined(CONFIG_BLOCKDEV_CACHE_SIZE)
+#define CONFIG_BLOCKDEV_CACHE_SIZE	(256U * 1024U)
+#endif
+#endif
+
+/**
+* @brief Asynchronous io flags
+*/
+#define TEGRABL_AIO_FLAG_WRITE		(1U << 0)
+
+/**
+* @brief Asynchronous io request states
+*/
+typedef enum
+{
+	TEGRABL_AIO_STATE_FREE,
+	TEGRABL_AIO_STATE_QUEUED,
+	TEGRABL_AIO_STATE_IN_PROGRESS,
+	TEGRABL_AIO_STATE_DONE,
+} tegrabl_aio_state_t;
+
+struct tegrabl_bdev;
+
 /**
 * @brief Asynchronous io structure
 */
@@ -48,6 +82,11 @@ typedef struct
 	bnum_t block;
 	size_t count;
 	uint32_t flags;
+	tegrabl_aio_state_t state;
+	struct tegrabl_bdev *dev;
+#if defined(CONFIG_ENABLE_BLOCKDEV_KPI)
+	time_t submit_time;
+#endif
 } tegrabl_aio_t;
 
 #define TEGRABL_BLOCK_DEVICE_ID(storage_type, instance) \
@@ -110,8 +149,18 @@ typedef struct tegrabl_bdev {
 	time_t total_write_time;
 	uint64_t total_read_size;
 	uint64_t total_write_size;
+#endif
+#if defined(CONFIG_ENABLE_BLOCKDEV_CACHE)
+	bnum_t cache_next_block;
+	uint64_t cache_hits;
+	uint64_t cache_misses;
+	uint64_t cache_read_ahead;
 #endif
 	tegrabl_aio_t *xfer_queue;
+	uint32_t xfer_next_id;
+	/* Device whose request queue is used instead, for devices sharing a
+	 * controller with it */
+	struct tegrabl_bdev *xfer_queue_dev;
 
 	void *priv_data;
 
@@ -123,10 +172,11 @@ typedef struct tegrabl_bdev {
 		bnum_t block, bnum_t count);
 	tegrabl_error_t (*write_block)(struct tegrabl_bdev *, const void *buf,
 		bnum_t block, bnum_t count);
-	tegrabl_aio_t *(*async_read_block)(struct tegrabl_bdev *, void *buf,
-		bnum_t block, bnum_t count);
-	tegrabl_aio_t *(*async_write_block)(struct tegrabl_bdev *, const void *buf,
-		 bnum_t block, bnum_t count);
+	tegrabl_error_t (*async_read_block)(struct tegrabl_bdev *,
+		tegrabl_aio_t *aio);
+	tegrabl_error_t (*async_write_block)(struct tegrabl_bdev *,
+		tegrabl_aio_t *aio);
+	tegrabl_error_t (*xfer_poll)(struct tegrabl_bdev *, tegrabl_aio_t *aio);
 	tegrabl_error_t (*erase)(struct tegrabl_bdev *, bnum_t block, bnum_t count,
 		bool is_secure);
 	tegrabl_error_t (*erase_all)(struct tegrabl_bdev *, bool is_secure);
@@ -290,7 +340,7 @@ tegrabl_error_t tegrabl_blockdev_erase_all(tegrabl_bdev_t *dev, bool is_secure);
 tegrabl_aio_t *tegrabl_blockdev_async_read_block(tegrabl_bdev_t *dev, void *buf,
 	bnum_t block, bnum_t count);
 
-/** @brief Reads the data from blocks starting from given start block.
+/** @brief Writes the data from blocks starting from given start block.
  *
  *  @param dev Block device handle.
  *  @param buf Buffer from which data has to be written.
@@ -302,6 +352,31 @@ tegrabl_aio_t *tegrabl_blockdev_async_read_block(tegrabl_bdev_t *dev, void *buf,
 tegrabl_aio_t *tegrabl_blockdev_async_write_block(tegrabl_bdev_t *dev,
 	const void *buf, bnum_t block, bnum_t count);
 
+/** @brief Checks the progress of an asynchronous io request without blocking.
+ *         Queued requests are started as the device becomes free. Once the
+ *         request has completed its queue slot is released and the handle
+ *         must not be used any more.
+ *
+ *  @param dev Block device handle.
+ *  @param aio Handle returned by async read/write.
+ *
+ *  @return TEGRABL_ERR_BUSY if the request is still pending, otherwise the
+ *          completion status of the request.
+ */
+tegrabl_error_t tegrabl_blockdev_xfer_poll(tegrabl_bdev_t *dev,
+	tegrabl_aio_t *aio);
+
+/** @brief Waits till the asynchronous io request completes and releases its
+ *         queue slot.
+ *
+ *  @param dev Block device handle.
+ *  @param aio Handle returned by async read/write.
+ *
+ *  @return Completion status of the request.
+ */
+tegrabl_error_t tegrabl_blockdev_xfer_wait(tegrabl_bdev_t *dev,
+	tegrabl_aio_t *aio);
+
 /** @brief Executes given ioctl
  *
  *  @param dev Block device handle.
@@ -343,10 +418,16 @@ tegrabl_error_t tegrabl_blockdev_initialize_bdev(tegrabl_bdev_t *dev,
 	uint32_t device_id, uint32_t block_size_log2, bnum_t block_count);
 
 /**
-* @brief List the kpi like read time and write time
+* @brief List the kpi like read time and write time, and the hit and miss
+*        counts of the read cache if enabled
 */
 void tegrabl_blockdev_list_kpi(void);
 
+/**
+* @brief Adds the per storage type kpi summary to the boot profiler records
+*/
+void tegrabl_blockdev_export_kpi(void);
+
 /**
 * @brief Prints the block devices info
 */
@@ -69,6 +69,37 @@ tegrabl_error_t tegrabl_transport_usbf_send(const void *buffer, uint32_t length,
 tegrabl_error_t tegrabl_transport_usbf_receive(void *buf, uint32_t length,
 		uint32_t *received, time_t timeout);
 
+/**
+ * Starts receiving data over the Usb and returns without waiting, so that
+ * caller can process previously received data meanwhile.
+ *
+ * @note Only one receive can be outstanding. TCM buffers are not supported.
+ *
+ * @param buf A pointer to the data bytes to receive.
+ * @param length The number of bytes to to receive.
+ *
+ * @return NO_ERROR if receive is started successfully.
+ */
+tegrabl_error_t tegrabl_transport_usbf_receive_start(void *buf,
+		uint32_t length);
+
+/**
+ * Waits for receive started by tegrabl_transport_usbf_receive_start().
+ *
+ * @param received A pointer to the bytes received.
+ * @param timeout transfer timeout value in msec.
+ *
+ * @return NO_ERROR if receive completed successfully.
+ */
+tegrabl_error_t tegrabl_transport_usbf_receive_complete(uint32_t *received,
+		time_t timeout);
+
+/**
+ * Gives up receive started by tegrabl_transport_usbf_receive_start(), so
+ * that its buffer can be freed. Nothing is done if no receive is pending.
+ */
+void tegrabl_transport_usbf_receive_abort(void);
+
 /**
  * Closes USB Device.
  *
@@ -126,10 +126,12 @@ tegrabl_error_t tegrabl_usbf_enumerate(uint8_t *buffer);
  * @param bytes_transmitted Pointer retuns the number of bytes
  * actually transfered.
  *
+ * @param timeout_us Maximum time in usec to wait for each transfer event.
+ *
  * @return returns the status.
  */
 tegrabl_error_t tegrabl_usbf_transmit(uint8_t *buffer, uint32_t bytes,
-			uint32_t *bytes_transmitted);
+			uint32_t *bytes_transmitted, uint32_t timeout_us);
 
 /**
  * @brief Transmit the data on the USB  bus and exit after transfer
@@ -169,10 +171,70 @@ tegrabl_error_t tegrabl_usbf_transmit_complete(uint32_t *p_bytes_transferred,
  * @param bytes_received Pointer retuns the number of bytes
  * actually received.
  *
+ * @param timeout_us Maximum time in usec to wait for each transfer event.
+ *
  * @return returns the status.
  */
 tegrabl_error_t tegrabl_usbf_receive(uint8_t *buffer, uint32_t bytes,
-		uint32_t *bytes_received);
+		uint32_t *bytes_received, uint32_t timeout_us);
+
+/**
+ * @brief Receive data from the USB bus keeping several transfer TRBs
+ * armed on the bulk out ring, and exit only after transfer completed.
+ * Buffer is split in TRB sized pieces and ring is re-armed as each piece
+ * completes, so that endpoint is not idle between pieces.
+ *
+ * @param buffer buffer pointer to receive the data into.
+ *
+ * @param bytes Number of bytes to be received.
+ *
+ * @param bytes_received Pointer retuns the number of bytes
+ * actually received.
+ *
+ * @param timeout_us Maximum time in usec to wait for each transfer event.
+ *
+ * @return returns the status. Short packet before the last piece is
+ * reported as error.
+ */
+tegrabl_error_t tegrabl_usbf_receive_multi(uint8_t *buffer, uint32_t bytes,
+		uint32_t *bytes_received, uint32_t timeout_us);
+
+/**
+ * @brief Arm multi TRB receive of buffer and return immediately. Data
+ * lands in buffer by DMA while caller does other work; ring is re-armed
+ * by tegrabl_usbf_receive_multi_complete().
+ *
+ * @param buffer buffer pointer to receive the data into.
+ *
+ * @param bytes Number of bytes to be received.
+ *
+ * @return returns the status.
+ */
+tegrabl_error_t tegrabl_usbf_receive_multi_start(uint8_t *buffer,
+		uint32_t bytes);
+
+/**
+ * @brief Wait for multi TRB receive started by
+ * tegrabl_usbf_receive_multi_start() to complete. On error, TRBs still
+ * armed are dropped and bulk out endpoint is reset, so buffer can be reused
+ * or freed once this returns.
+ *
+ * @param bytes_received Pointer retuns the number of bytes
+ * actually received.
+ *
+ * @param timeout_us Maximum time in usec to wait for each transfer event.
+ *
+ * @return returns the status.
+ */
+tegrabl_error_t tegrabl_usbf_receive_multi_complete(uint32_t *bytes_received,
+		uint32_t timeout_us);
+
+/**
+ * @brief Give up multi TRB receive started by
+ * tegrabl_usbf_receive_multi_start(). TRBs still armed are dropped and
+ * bulk out endpoint is reset. Nothing is done if no receive is pending.
+ */
+void tegrabl_usbf_receive_multi_abort(void);
 
 /**
  * @brief Submit the data receive request and return immediatly.
@@ -64,8 +64,76 @@ typedef struct {
 	 * @return SUCCESS or FAILURE
 	 */
 	tegrabl_error_t (*end)(void *context);
+
+	/**
+	 * @brief: streaming decompression handler, continues from where the
+	 *         previous call stopped. Input which cannot be processed yet
+	 *         (e.g. a partial block) is left unconsumed and has to be passed
+	 *         again along with the data following it. Optional.
+	 *
+	 * @param cntxt: the context returned by init
+	 * @param in_buffer: pointer to next input compressed data
+	 * @param in_size: input data size
+	 * @param consumed: input data size processed
+	 * @param out_buffer: pointer to where next decompressed data goes
+	 * @param outbuf_size: space left in output buffer
+	 * @param written_size: decompressed data size of this call
+	 * @param done: set once end of compressed data is reached
+	 *
+	 * @return SUCCESS or FAILURE
+	 */
+	tegrabl_error_t (*decompress_stream)(void *cntxt, void *in_buffer,
+										 uint32_t in_size, uint32_t *consumed,
+										 void *out_buffer, uint32_t outbuf_size,
+										 uint32_t *written_size, bool *done);
 } decompressor;
 
+/**
+ * @brief: independent block of compressed data which can be decoded on any
+ *         core, in any order
+ *
+ * @param decode: decodes the block, returns decompressed size or negative value
+ *                on failure
+ * @param in_buffer: pointer to compressed block
+ * @param in_size: compressed block size
+ * @param out_buffer: where decompressed block goes
+ * @param outbuf_size: MAX decompressed block size
+ * @param result: return value of decode
+ */
+struct decompress_block_job {
+	int32_t (*decode)(struct decompress_block_job *job);
+	const void *in_buffer;
+	uint32_t in_size;
+	void *out_buffer;
+	uint32_t outbuf_size;
+	int32_t result;
+};
+
+/**
+ * @brief: runs decode of each of the jobs and returns once all are done
+ */
+typedef void (*decompress_block_runner_t)(struct decompress_block_job *jobs,
+										  uint32_t count);
+
+/**
+ * @brief: state of a streaming decompression
+ *
+ * @param decomp: decompression handler
+ * @param context: context returned by init of decomp
+ * @param out_buffer: pointer to decompressed data buffer
+ * @param outbuf_size: size of out_buffer
+ * @param written_size: decompressed data size so far
+ * @param done: true once end of compressed data is reached
+ */
+struct decompress_stream {
+	decompressor *decomp;
+	void *context;
+	uint8_t *out_buffer;
+	uint32_t outbuf_size;
+	uint32_t written_size;
+	bool done;
+};
+
 /**
  * @brief: get the decompression handle as per magic ID
  *
@@ -104,6 +172,61 @@ tegrabl_error_t do_decompress(decompressor *decomp, uint8_t *read_buffer,
 							  uint32_t read_size, uint8_t *out_buffer,
 							  uint32_t *outbuf_size);
 
+/**
+ * @brief: start streaming decompression of content to out_buffer
+ *
+ * @param stream: stream state to initialize
+ * @param decomp: decompression handler
+ * @param compressed_size: total compressed data size (in byte)
+ * @param out_buffer: pointer to uncompressed data buffer
+ * @param outbuf_size: size of out_buffer
+ *
+ * @return TEGRABL_ERR_NOT_SUPPORTED if decomp cannot stream, else error status
+ *         of initialization
+ */
+tegrabl_error_t decompress_stream_init(struct decompress_stream *stream,
+									   decompressor *decomp,
+									   uint32_t compressed_size,
+									   uint8_t *out_buffer,
+									   uint32_t outbuf_size);
+
+/**
+ * @brief: decompress next part of the compressed content. Unconsumed input
+ *         has to be fed again together with the data following it.
+ *
+ * @param stream: stream state
+ * @param in_buffer: pointer to next compressed data
+ * @param in_size: compressed data size
+ * @param consumed: compressed data size processed
+ *
+ * @return error status of decompression
+ */
+tegrabl_error_t decompress_stream_feed(struct decompress_stream *stream,
+									   uint8_t *in_buffer, uint32_t in_size,
+									   uint32_t *consumed);
+
+/**
+ * @brief: release resources held by the stream
+ *
+ * @param stream: stream state
+ */
+void decompress_stream_end(struct decompress_stream *stream);
+
+/**
+ * @brief: register handler which decodes batches of independent blocks, e.g.
+ *         on several cores. Without one, blocks are decoded serially.
+ *
+ * @param runner: batch handler, NULL to go back to serial decode
+ */
+void decompress_set_block_runner(decompress_block_runner_t runner);
+
+/**
+ * @brief: get handler registered with decompress_set_block_runner
+ *
+ * @return batch handler, NULL if none
+ */
+decompress_block_runner_t decompress_get_block_runner(void);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -33,6 +33,8 @@
 #define STATE_ERROR 3
 #define USB_BUFFER_ALIGNMENT 4096
 #define FASTBOOT_CMD_RCV_BUF_SIZE 512
+/* Size of each of the two buffers used by flash-stream */
+#define FASTBOOT_STREAM_CHUNK_SIZE (1024 * 1024)
 
 /* Max timeout for any USB transfer is set to 5 sec */
 #define FB_TFR_TIMEOUT  5000
@@ -69,4 +71,13 @@ void fastboot_okay(const char *info);
  */
 void fastboot_fail(const char *info);
 
+/**
+ * @brief get the data received by the last download command
+ *
+ * @param size size of downloaded data, 0 if there is none (output param)
+ *
+ * @return pointer to downloaded data
+ */
+void *tegrabl_fastboot_get_download_buffer(uint32_t *size);
+
 #endif
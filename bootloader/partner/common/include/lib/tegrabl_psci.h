@@ -11,6 +11,14 @@
 #ifndef INCLUDED_TEGRABL_PSCI_H
 #define INCLUDED_TEGRABL_PSCI_H
 
+#include <stdint.h>
+#include <tegrabl_error.h>
+
+/* States of a CPU returned by tegrabl_psci_affinity_info() */
+#define TEGRABL_PSCI_AFFINITY_ON			0
+#define TEGRABL_PSCI_AFFINITY_OFF			1
+#define TEGRABL_PSCI_AFFINITY_ON_PENDING	2
+
 /**
 * @brief reset the board
 */
@@ -21,5 +29,32 @@ void tegrabl_psci_sys_reset(void);
 */
 void tegrabl_psci_sys_off(void);
 
+/**
+* @brief power-on a CPU, which starts executing at entry in the current EL
+* with MMU and caches off
+*
+* @param mpidr MPIDR of the CPU
+* @param entry physical address the CPU starts from
+* @param context_id value passed to the CPU in x0
+*
+* @return TEGRABL_NO_ERROR if the CPU is being powered on
+*/
+tegrabl_error_t tegrabl_psci_cpu_on(uint64_t mpidr, uintptr_t entry,
+									uint64_t context_id);
+
+/**
+* @brief power-off the calling CPU, does not return
+*/
+void tegrabl_psci_cpu_off(void);
+
+/**
+* @brief get power state of a CPU
+*
+* @param mpidr MPIDR of the CPU
+*
+* @return one of TEGRABL_PSCI_AFFINITY_*, negative PSCI error code on failure
+*/
+int64_t tegrabl_psci_affinity_info(uint64_t mpidr);
+
 #endif /*INCLUDED_TEGRABL_PSCI_H*/
 
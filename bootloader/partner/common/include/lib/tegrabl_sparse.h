@@ -98,6 +98,16 @@ struct tegrabl_unsparse_state {
 	uint32_t fill_value;
 	/* Total chunks processed */
 	uint64_t chunks_processed;
+	/* Buffer in which RAW data is gathered before writing */
+	uint8_t *stage_buffer;
+	/* Bytes gathered in stage buffer */
+	uint64_t stage_len;
+	/* Buffer from which fill chunks are written */
+	uint32_t *fill_buffer;
+	/* Value fill buffer is patterned with */
+	uint32_t fill_pattern;
+	/* Bytes of fill buffer which hold the pattern */
+	uint32_t fill_valid;
 	/**
 	 * @brief Handle of function which will write to correct location while
 	 * unsparsing.
@@ -184,6 +194,26 @@ tegrabl_error_t tegrabl_sparse_unsparse(
 		struct tegrabl_unsparse_state *unsparse_state, const void *buff,
 		uint64_t length, void *aux_info);
 
+/**
+ * @brief Checks if unsparse machine has processed the last chunk of image.
+ *
+ * @param unsparse_state Handle of state maintained by unsparse machine.
+ *
+ * @return true if all chunks mentioned in image header are processed.
+ */
+bool tegrabl_sparse_unsparse_is_complete(
+		const struct tegrabl_unsparse_state *unsparse_state);
+
+/**
+ * @brief Releases resources held by unsparse machine when unsparsing is
+ * given up before the last chunk is processed. Data gathered but not yet
+ * written is dropped.
+ *
+ * @param unsparse_state Handle of state maintained by unsparse machine.
+ */
+void tegrabl_sparse_abort_unsparse(
+		struct tegrabl_unsparse_state *unsparse_state);
+
 /**
  * @brief Initializes context for creating sparse image.
  *
@@ -113,6 +113,18 @@
  */
 uint32_t tegrabl_utils_crc32(uint32_t val, void *buffer, size_t buffer_size);
 
+/**
+ * @brief Computes the crc32 of two buffers put one after the other from the
+ * crc32 of each.
+ *
+ * @param crc1			crc32 of first buffer.
+ * @param crc2			crc32 of second buffer, computed with 0 as initial value.
+ * @param len2			size of second buffer.
+ *
+ * @return crc32 of both buffers.
+ */
+uint32_t tegrabl_utils_crc32_combine(uint32_t crc1, uint32_t crc2, size_t len2);
+
 /**
  * @brief Computes the checksum of buffer.
  *
@@ -29,6 +29,97 @@
 #  define PUP(a) *++(a)
 #endif
 
+#ifdef INFLATE_FAST_WIDE
+
+#ifdef __ARM_NEON
+#  include <arm_neon.h>
+#endif
+
+/* Load 8 bytes, unaligned, in little-endian order */
+local unsigned long read64le(p)
+const unsigned char FAR *p;
+{
+    unsigned long v;
+
+    zmemcpy((Bytef *)&v, (const Bytef *)p, sizeof(v));
+    return v;
+}
+
+/* Copy one INFLATE_FAST_CHUNK sized chunk */
+local void chunk_copy_one(out, from)
+unsigned char FAR *out;
+const unsigned char FAR *from;
+{
+#ifdef __ARM_NEON
+    vst1q_u8(out, vld1q_u8(from));
+#else
+    unsigned long v[2];
+
+    zmemcpy((Bytef *)v, (const Bytef *)from, sizeof(v));
+    zmemcpy((Bytef *)out, (const Bytef *)v, sizeof(v));
+#endif
+}
+
+/*
+   Copy a match of len bytes from dist bytes back in the output and return
+   the new end of output.  from may overlap the bytes being written when dist
+   is less than len.  Up to INFLATE_FAST_CHUNK - 1 bytes past the end of the
+   match may be written, which is why inflate() requires more output space
+   before calling inflate_fast().
+ */
+local unsigned char FAR *chunk_copy(out, from, dist, len)
+unsigned char FAR *out;
+const unsigned char FAR *from;
+unsigned dist;
+unsigned len;
+{
+    unsigned char FAR *end = out + len;
+    unsigned long v;
+
+    if (dist >= INFLATE_FAST_CHUNK) {
+        /* each chunk only reads bytes that are already written */
+        do {
+            chunk_copy_one(out, from);
+            out += INFLATE_FAST_CHUNK;
+            from += INFLATE_FAST_CHUNK;
+        } while (out < end);
+    }
+    else if (dist >= sizeof(v)) {
+        do {
+            zmemcpy((Bytef *)&v, (const Bytef *)from, sizeof(v));
+            zmemcpy((Bytef *)out, (const Bytef *)&v, sizeof(v));
+            out += sizeof(v);
+            from += sizeof(v);
+        } while (out < end);
+    }
+    else if (dist == 1) {                       /* run of one byte */
+        memset(out, *from, len);
+    }
+    else {
+        do {
+            *out++ = *from++;
+        } while (out < end);
+    }
+    return end;
+}
+
+#endif /* INFLATE_FAST_WIDE */
+
+/* Copy n bytes from the window, n is not preserved */
+#ifdef INFLATE_FAST_WIDE
+#  define COPY_WINDOW(n) \
+    do { \
+        zmemcpy(out + OFF, from + OFF, n); \
+        out += n; \
+        from += n; \
+    } while (0)
+#else
+#  define COPY_WINDOW(n) \
+    do { \
+        PUP(out) = PUP(from); \
+    } while (--(n))
+#endif
+
 /*
    Decode literal, length, and distance codes and write out the resulting
    literal and match bytes until either not enough input or output is
@@ -40,8 +131,8 @@
    Entry assumptions:
 
         state->mode == LEN
-        strm->avail_in >= 6
-        strm->avail_out >= 258
+        strm->avail_in >= INFLATE_FAST_MIN_INPUT
+        strm->avail_out >= INFLATE_FAST_MIN_OUTPUT
         start >= strm->avail_out
         state->bits < 8
 
@@ -63,6 +154,12 @@
       bytes, which is the maximum length that can be coded.  inflate_fast()
       requires strm->avail_out >= 258 for each loop to avoid checking for
       output space.
+
+    - With INFLATE_FAST_WIDE the bit buffer is refilled with a single 8 byte
+      load at the top of each loop, which leaves at least 56 bits in it, and
+      more than the 48 bits a length/distance pair can use.  That load and
+      the chunked match copies are what the larger minimum input and output
+      sizes are for.
  */
 void ZLIB_INTERNAL inflate_fast(strm, start)
 z_streamp strm;
@@ -97,10 +194,10 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
     /* copy state to local variables */
     state = (struct inflate_state FAR *)strm->state;
     in = strm->next_in - OFF;
-    last = in + (strm->avail_in - 5);
+    last = in + (strm->avail_in - (INFLATE_FAST_MIN_INPUT - 1));
     out = strm->next_out - OFF;
     beg = out - (start - strm->avail_out);
-    end = out + (strm->avail_out - 257);
+    end = out + (strm->avail_out - (INFLATE_FAST_MIN_OUTPUT - 1));
 #ifdef INFLATE_STRICT
     dmax = state->dmax;
 #endif
@@ -118,12 +215,20 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
     /* decode literals and length/distances until end-of-block or not enough
        input data or output space */
     do {
+#ifdef INFLATE_FAST_WIDE
+        /* bytes beyond the ones counted are loaded as well, but as they are
+           the following input bytes anyway, or-ing them in again is harmless */
+        hold |= read64le(in + OFF) << bits;
+        in += (63 - bits) >> 3;
+        bits |= 56;
+#else
         if (bits < 15) {
             hold += (unsigned long)(PUP(in)) << bits;
             bits += 8;
             hold += (unsigned long)(PUP(in)) << bits;
             bits += 8;
         }
+#endif
         here = lcode[hold & lmask];
       dolen:
         op = (unsigned)(here.bits);
@@ -140,21 +245,25 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
             len = (unsigned)(here.val);
             op &= 15;                           /* number of extra bits */
             if (op) {
+#ifndef INFLATE_FAST_WIDE
                 if (bits < op) {
                     hold += (unsigned long)(PUP(in)) << bits;
                     bits += 8;
                 }
+#endif
                 len += (unsigned)hold & ((1U << op) - 1);
                 hold >>= op;
                 bits -= op;
             }
             Tracevv((stderr, "inflate:         length %u\n", len));
+#ifndef INFLATE_FAST_WIDE
             if (bits < 15) {
                 hold += (unsigned long)(PUP(in)) << bits;
                 bits += 8;
                 hold += (unsigned long)(PUP(in)) << bits;
                 bits += 8;
             }
+#endif
             here = dcode[hold & dmask];
           dodist:
             op = (unsigned)(here.bits);
@@ -164,6 +273,7 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
             if (op & 16) {                      /* distance base */
                 dist = (unsigned)(here.val);
                 op &= 15;                       /* number of extra bits */
+#ifndef INFLATE_FAST_WIDE
                 if (bits < op) {
                     hold += (unsigned long)(PUP(in)) << bits;
                     bits += 8;
@@ -172,6 +282,7 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                         bits += 8;
                     }
                 }
+#endif
                 dist += (unsigned)hold & ((1U << op) - 1);
 #ifdef INFLATE_STRICT
                 if (dist > dmax) {
@@ -218,9 +329,7 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                         from += wsize - op;
                         if (op < len) {         /* some from window */
                             len -= op;
-                            do {
-                                PUP(out) = PUP(from);
-                            } while (--op);
+                            COPY_WINDOW(op);
                             from = out - dist;  /* rest from output */
                         }
                     }
@@ -229,16 +338,12 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                         op -= wnext;
                         if (op < len) {         /* some from end of window */
                             len -= op;
-                            do {
-                                PUP(out) = PUP(from);
-                            } while (--op);
+                            COPY_WINDOW(op);
                             from = window - OFF;
                             if (wnext < len) {  /* some from start of window */
                                 op = wnext;
                                 len -= op;
-                                do {
-                                    PUP(out) = PUP(from);
-                                } while (--op);
+                                COPY_WINDOW(op);
                                 from = out - dist;      /* rest from output */
                             }
                         }
@@ -247,12 +352,20 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                         from += wnext - op;
                         if (op < len) {         /* some from window */
                             len -= op;
-                            do {
-                                PUP(out) = PUP(from);
-                            } while (--op);
+                            COPY_WINDOW(op);
                             from = out - dist;  /* rest from output */
                         }
                     }
+#ifdef INFLATE_FAST_WIDE
+                    if (from == out - dist) {
+                        out = chunk_copy(out + OFF, from + OFF, dist, len) -
+                              OFF;
+                    }
+                    else {                      /* rest is from window */
+                        zmemcpy(out + OFF, from + OFF, len);
+                        out += len;
+                    }
+#else
                     while (len > 2) {
                         PUP(out) = PUP(from);
                         PUP(out) = PUP(from);
@@ -264,9 +377,13 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                         if (len > 1)
                             PUP(out) = PUP(from);
                     }
+#endif
                 }
                 else {
                     from = out - dist;          /* copy direct from output */
+#ifdef INFLATE_FAST_WIDE
+                    out = chunk_copy(out + OFF, from + OFF, dist, len) - OFF;
+#else
                     do {                        /* minimum length is three */
                         PUP(out) = PUP(from);
                         PUP(out) = PUP(from);
@@ -278,6 +395,7 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
                         if (len > 1)
                             PUP(out) = PUP(from);
                     }
+#endif
                 }
             }
             else if ((op & 64) == 0) {          /* 2nd level distance code */
@@ -315,9 +433,12 @@ unsigned start;         /* inflate()'s starting value for strm->avail_out */
     /* update state and return */
     strm->next_in = in + OFF;
     strm->next_out = out + OFF;
-    strm->avail_in = (unsigned)(in < last ? 5 + (last - in) : 5 - (in - last));
+    strm->avail_in = (unsigned)(in < last ?
+                                (INFLATE_FAST_MIN_INPUT - 1) + (last - in) :
+                                (INFLATE_FAST_MIN_INPUT - 1) - (in - last));
     strm->avail_out = (unsigned)(out < end ?
-                                 257 + (end - out) : 257 - (out - end));
+                                 (INFLATE_FAST_MIN_OUTPUT - 1) + (end - out) :
+                                 (INFLATE_FAST_MIN_OUTPUT - 1) - (out - end));
     state->hold = hold;
     state->bits = bits;
     return;
@@ -8,4 +8,22 @@
    subject to change. Applications should only use zlib.h.
  */
 
+/* On little-endian 64-bit targets inflate_fast() refills the bit buffer 8
+   bytes at a time and copies matches in INFLATE_FAST_CHUNK byte chunks.  Both
+   read or write past the exact end of the data, so inflate() has to leave it
+   more slack at the ends of the input and output buffers. */
+#if !defined(INFLATE_FAST_WIDE) && defined(__aarch64__) && \
+    !defined(__AARCH64EB__)
+#  define INFLATE_FAST_WIDE
+#endif
+
+#ifdef INFLATE_FAST_WIDE
+#  define INFLATE_FAST_CHUNK 16
+#  define INFLATE_FAST_MIN_INPUT 8
+#  define INFLATE_FAST_MIN_OUTPUT (258 + INFLATE_FAST_CHUNK - 1)
+#else
+#  define INFLATE_FAST_MIN_INPUT 6
+#  define INFLATE_FAST_MIN_OUTPUT 258
+#endif
+
 void ZLIB_INTERNAL inflate_fast OF((z_streamp strm, unsigned start));
@@ -41,6 +41,24 @@ static char bootimg_cmdline[BOOT_ARGS_SIZE + BOOT_EXTRA_ARGS_SIZE + VENDOR_BOOT_
 
 #define FDT_SIZE_BL_DT_NODES (4048 + 4048)
 
+/* ramdisk may extend up to where boot.img is loaded */
+#define MAX_RAMDISK_SIZE (BOOT_IMAGE_LOAD_ADDRESS - RAMDISK_ADDRESS)
+
+/* "070701" newc, "070702" newc with crc and "070707" odc cpio archives */
+#define CPIO_MAGIC "0707"
+#define CPIO_MAGIC_SIZE 4
+
+#if defined(CONFIG_ENABLE_RAMDISK_DECOMPRESS)
+/* Alignment of cpio archives following one another */
+#define CPIO_ALIGN 4ULL
+#endif
+
+#if defined(CONFIG_ENABLE_BOOTIMG_SCATTER_LOAD)
+/* Sections of boot.img and vendor_boot.img already read to their place */
+static uint32_t bootimg_placed;
+static uint32_t vendor_bootimg_placed;
+#endif
+
 void tegrabl_get_ramdisk_info(uint64_t *start, uint64_t *size)
 {
 	if (start) {
@@ -132,6 +150,23 @@ static tegrabl_error_t extract_kernel(tegrabl_bootimg_header *hdr,
 	else
 		kernel_load = (char *)LINUX_LOAD_ADDRESS;
 
+#if defined(CONFIG_ENABLE_KERNEL_STREAM_DECOMPRESS)
+	if (tegrabl_loader_get_decompressed_kernel((uint8_t *)hdr + kernel_offset,
+											   hdr->kernel_size, kernel_load,
+											   &decomp_size)) {
+		pr_info("Kernel image (%u bytes) decompressed at %p while loading ... ",
+				decomp_size, kernel_load);
+		goto done;
+	}
+#endif
+#if defined(CONFIG_ENABLE_BOOTIMG_SCATTER_LOAD)
+	if (bootimg_placed & TEGRABL_BOOTIMG_SCATTER_KERNEL) {
+		pr_info("Kernel image (%u bytes) read to %p while loading ... ",
+				hdr->kernel_size, kernel_load);
+		goto done;
+	}
+#endif
+
 	is_compressed = is_compressed_content((uint8_t *)hdr + kernel_offset,
 										  &decomp);
 
@@ -152,6 +187,10 @@ static tegrabl_error_t extract_kernel(tegrabl_bootimg_header *hdr,
 		}
 	}
 
+#if defined(CONFIG_ENABLE_KERNEL_STREAM_DECOMPRESS) || \
+	defined(CONFIG_ENABLE_BOOTIMG_SCATTER_LOAD)
+done:
+#endif
 	pr_info("Done\n");
 
 	*kernel_entry_point = kernel_load;
@@ -159,31 +198,87 @@ static tegrabl_error_t extract_kernel(tegrabl_bootimg_header *hdr,
 	return TEGRABL_NO_ERROR;
 }
 
-static tegrabl_error_t validate_ramdisk(uint64_t addr_to_check)
+/* Checks ramdisk is not empty and returns the decompressor for it if it is
+ * compressed in a format known to decompressor framework. Plain cpio and
+ * formats only the kernel knows (xz, lzma, bzip2, lzo, ...) are passed as is */
+static tegrabl_error_t validate_ramdisk(uint64_t addr_to_check, uint64_t size,
+									   decompressor **pdecomp)
 {
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
-	unsigned char gzip_header[] = { 0x1f, 0x8b };
+	uint8_t *head = (uint8_t *)((uintptr_t)addr_to_check);
+
+	*pdecomp = NULL;
 
-	/* Check if ramdisk is valid */
-	if (memcmp((void *)addr_to_check, gzip_header, 2)) {
-		pr_error("Invalid vendor ramdisk image @ %p (header magic mismatch)\n", (void *)addr_to_check);
-		pr_error("Byte 0: expected: %d, got: %d\n", gzip_header[0], ((unsigned char*)addr_to_check)[0]);
-		pr_error("Byte 1: expected: %d, got: %d\n", gzip_header[1], ((unsigned char*)addr_to_check)[1]);
+	if (size == 0) {
+		pr_error("Invalid ramdisk image @ %p (empty)\n", head);
 		err = TEGRABL_ERROR(TEGRABL_ERR_VERIFY_FAILED, 0);
+		goto fail;
 	}
+
+	if ((size >= CPIO_MAGIC_SIZE) && !memcmp(head, CPIO_MAGIC, CPIO_MAGIC_SIZE))
+		goto fail;
+
+	if (size >= 2)
+		*pdecomp = decompress_method(head, 2);
+	if (*pdecomp == NULL) {
+		pr_warn("Ramdisk @ %p in format unknown to bootloader (magic 0x%02x "
+				"0x%02x), passing it as is\n", head, head[0],
+				size >= 2 ? head[1] : 0);
+	}
+
+fail:
 	return err;
 }
 
+/* Puts ramdisk of *size bytes at src to dst, on the way decompressing it if
+ * enabled, and updates *size to what is left at dst */
+static void place_ramdisk(uint64_t src, uint64_t dst, uint64_t *size,
+						  decompressor *decomp, uint64_t dst_max)
+{
+#if defined(CONFIG_ENABLE_RAMDISK_DECOMPRESS)
+	tegrabl_error_t err;
+	uint32_t decomp_size;
+
+	if ((decomp != NULL) && (src != dst)) {
+		pr_info("Decompressing %s ramdisk (len: %"PRIu64") from 0x%"PRIx64
+				" to 0x%"PRIx64"\n", decomp->name, *size, src, dst);
+		decomp_size = (uint32_t)MIN(dst_max, UINT32_MAX);
+		err = do_decompress(decomp, (uint8_t *)((uintptr_t)src),
+							(uint32_t)*size, (uint8_t *)((uintptr_t)dst),
+							&decomp_size);
+		if (err == TEGRABL_NO_ERROR) {
+			*size = decomp_size;
+			return;
+		}
+		/* kernel can still unpack it */
+		pr_warn("Error 0x%08x decompressing ramdisk, passing it as is\n", err);
+	}
+#else
+	(void)decomp;
+	(void)dst_max;
+#endif
+
+	if (src != dst) {
+		pr_info("Move ramdisk (len: %"PRIu64") from 0x%"PRIx64" to 0x%"PRIx64
+				"\n", *size, src, dst);
+		memmove((void *)((uintptr_t)dst), (void *)((uintptr_t)src), *size);
+	}
+}
+
 static tegrabl_error_t extract_ramdisk(tegrabl_bootimg_header *hdr,
 								   tegrabl_vendor_bootimg_header *vndhdr)
 {
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	decompressor *decomp = NULL;
 	ramdisk_load = RAMDISK_ADDRESS;
 #if CONFIG_BOOTIMG_HEADER_VERSION >= 3
 	/* NOTE: Vendor ramdisk must come first */
 
 	uint64_t ramdisk_offset = (uint64_t)NULL; /* Offset of 1st ramdisk byte in boot.img */
 	uint64_t vendor_ramdisk_offset = (uint64_t)NULL; /* Offset of 1st ramdisk byte in vendor_boot.img */
+#if defined(CONFIG_ENABLE_RAMDISK_DECOMPRESS)
+	uint64_t padding;
+#endif
 	/*
 	  TODO: Dynamic vendor_boot.img header size detection
 	  https://android.googlesource.com/platform/system/tools/mkbootimg/+/master/include/bootimg/bootimg.h#193
@@ -192,50 +287,67 @@ static tegrabl_error_t extract_ramdisk(tegrabl_bootimg_header *hdr,
 	vendor_ramdisk_offset = ROUND_UP_POW2(VENDOR_HEADER_SIZE, vndhdr->page_size);
 	pr_info("vendor_ramdisk_offset: %"PRIu64"\n", vendor_ramdisk_offset);
 	vendor_ramdisk_offset = (uintptr_t)vndhdr + vendor_ramdisk_offset;
+#if defined(CONFIG_ENABLE_BOOTIMG_SCATTER_LOAD)
+	if (vendor_bootimg_placed & TEGRABL_BOOTIMG_SCATTER_RAMDISK)
+		vendor_ramdisk_offset = ramdisk_load;
+#endif
 	vendor_ramdisk_size = vndhdr->vendor_ramdisk_size;
 	/* Check vendor_ramdisk before copying */
-	err = validate_ramdisk(vendor_ramdisk_offset);
+	err = validate_ramdisk(vendor_ramdisk_offset, vendor_ramdisk_size, &decomp);
 	if (err) {
 		goto fail;
 	}
 	pr_info("Valid vendor ramdisk image @ %p\n", (void *)vendor_ramdisk_offset);
 	/* Move vendor ramdisk into memory first */
-	pr_info("Move vendor_boot.img ramdisk (len: %"PRIu64") from 0x%"PRIx64" to 0x%"PRIx64"\n",
-			vendor_ramdisk_size, vendor_ramdisk_offset, ramdisk_load);
-	memmove((void *)((uintptr_t)ramdisk_load),
-			(void *)((uintptr_t)vendor_ramdisk_offset), vendor_ramdisk_size);
+	place_ramdisk(vendor_ramdisk_offset, ramdisk_load, &vendor_ramdisk_size,
+				  decomp, MAX_RAMDISK_SIZE);
+#if defined(CONFIG_ENABLE_RAMDISK_DECOMPRESS)
+	/* Plain cpio archive after a decompressed one has to start aligned,
+	 * kernel skips the zero padding in between */
+	padding = ALIGN(vendor_ramdisk_size, CPIO_ALIGN) - vendor_ramdisk_size;
+	memset((void *)((uintptr_t)(ramdisk_load + vendor_ramdisk_size)), 0,
+		   padding);
+	vendor_ramdisk_size += padding;
+#endif
 
 	ramdisk_offset = ROUND_UP_POW2(vndhdr->page_size + hdr->kernel_size,
 								   vndhdr->page_size);
 	ramdisk_offset = (uintptr_t)hdr + ramdisk_offset;
 	ramdisk_size = hdr->ramdisk_size;
 	uint64_t generic_ramdisk_start = ramdisk_load + vendor_ramdisk_size;
+#if defined(CONFIG_ENABLE_BOOTIMG_SCATTER_LOAD)
+	if (bootimg_placed & TEGRABL_BOOTIMG_SCATTER_RAMDISK)
+		ramdisk_offset = generic_ramdisk_start;
+#endif
 	/* Check ramdisk before copying */
-	err = validate_ramdisk(ramdisk_offset);
+	err = validate_ramdisk(ramdisk_offset, ramdisk_size, &decomp);
 	if (err) {
 		goto fail;
 	}
 	pr_info("Valid generic ramdisk image @ %p\n", (void *)ramdisk_offset);
 	/* Move generic ramdisk to right after vendor ramdisk */
-	if (ramdisk_offset != ramdisk_load) {
-		pr_info("Move boot.img ramdisk (len: %"PRIu64") from 0x%"PRIx64" to 0x%"PRIx64
-				"\n", ramdisk_size, ramdisk_offset, generic_ramdisk_start);
-		memmove((void *)((uintptr_t)generic_ramdisk_start),
-				(void *)((uintptr_t)ramdisk_offset), ramdisk_size);
-	}
+	place_ramdisk(ramdisk_offset, generic_ramdisk_start, &ramdisk_size, decomp,
+				  MAX_RAMDISK_SIZE - vendor_ramdisk_size);
 #else /* CONFIG_BOOTIMG_HEADER_VERSION < 3 */
 	uint64_t ramdisk_offset = (uint64_t)NULL; /* Offset of 1st ramdisk byte in boot.img */
 
 	ramdisk_offset = ROUND_UP_POW2(vndhdr->page_size + hdr->kernel_size,
 								   vndhdr->page_size);
 	ramdisk_offset = (uintptr_t)hdr + ramdisk_offset;
+#if defined(CONFIG_ENABLE_BOOTIMG_SCATTER_LOAD)
+	if (bootimg_placed & TEGRABL_BOOTIMG_SCATTER_RAMDISK)
+		ramdisk_offset = ramdisk_load;
+#endif
 	ramdisk_size = hdr->ramdisk_size;
-	if (ramdisk_offset != ramdisk_load) {
-		pr_info("Move boot.img ramdisk (len: %"PRIu64") from 0x%"PRIx64" to 0x%"PRIx64
-				"\n", ramdisk_size, ramdisk_offset, ramdisk_load);
-		memmove((void *)((uintptr_t)ramdisk_load),
-				(void *)((uintptr_t)ramdisk_offset), ramdisk_size);
+	/* Ramdisk is optional in these images */
+	if (ramdisk_size != 0) {
+		err = validate_ramdisk(ramdisk_offset, ramdisk_size, &decomp);
+		if (err) {
+			goto fail;
+		}
 	}
+	place_ramdisk(ramdisk_offset, ramdisk_load, &ramdisk_size, decomp,
+				  MAX_RAMDISK_SIZE);
 #endif /* CONFIG_BOOTIMG_HEADER_VERSION >= 3 */
 
 #if CONFIG_BOOTIMG_HEADER_VERSION >= 3
@@ -311,6 +423,19 @@ tegrabl_error_t tegrabl_load_kernel_and_dtb(
 	void *kernel_dtbo = NULL;
 	tegrabl_bootimg_header *hdr = (void *)((uintptr_t)0xDEADDEA0);
 	tegrabl_vendor_bootimg_header *vndhdr = (void *)((uintptr_t)VENDOR_BOOT_IMAGE_LOAD_ADDRESS);
+#if defined(CONFIG_ENABLE_BOOTIMG_SCATTER_LOAD)
+	bool scatter;
+	uint8_t *scatter_ramdisk = NULL;
+
+	bootimg_placed = 0;
+	vendor_bootimg_placed = 0;
+	/* Verified boot needs the images as they are stored */
+	scatter = (callbacks == NULL) || (callbacks->verify_boot == NULL);
+#if !defined(CONFIG_ENABLE_RAMDISK_DECOMPRESS)
+	/* else ramdisks are decompressed from the images to their place */
+	scatter_ramdisk = (uint8_t *)RAMDISK_ADDRESS;
+#endif
+#endif
 
 	if (!kernel_entry_point || !kernel_dtb) {
 		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
@@ -334,7 +459,16 @@ tegrabl_error_t tegrabl_load_kernel_and_dtb(
 #if CONFIG_BOOTIMG_HEADER_VERSION >= 3
 	/* vendor_boot needs to be loaded before boot so we can use the values from it's
 	   header to load the kernel and ramdisk from boot. */
+#if defined(CONFIG_ENABLE_BOOTIMG_SCATTER_LOAD)
+	if (scatter)
+		tegrabl_loader_set_bootimg_scatter(NULL, 0, scatter_ramdisk,
+										   MAX_RAMDISK_SIZE);
+#endif
 	err = tegrabl_load_binary(TEGRABL_BINARY_KERNEL_VENDOR, (void **)vndhdr, NULL);
+#if defined(CONFIG_ENABLE_BOOTIMG_SCATTER_LOAD)
+	if (scatter)
+		vendor_bootimg_placed = tegrabl_loader_get_bootimg_scatter(vndhdr);
+#endif
 	if (err != TEGRABL_NO_ERROR) {
 		pr_error("vendor_boot.img loading failed\n");
 		goto fail;
@@ -343,7 +477,39 @@ tegrabl_error_t tegrabl_load_kernel_and_dtb(
 	   to allow other functions to read them */
 	tegrabl_store_vendor_bootimg_values(vndhdr);
 #endif /* CONFIG_BOOTIMG_HEADER_VERSION */
+#if defined(CONFIG_ENABLE_KERNEL_STREAM_DECOMPRESS)
+	/*
+	 * Let kernel be decompressed while rest of boot.img is being read, but
+	 * not ahead of verified boot: nothing is decompressed before it is checked
+	 */
+	if ((callbacks == NULL) || (callbacks->verify_boot == NULL))
+		tegrabl_loader_set_kernel_decompress_buffer((void *)LINUX_LOAD_ADDRESS,
+													MAX_KERNEL_IMAGE_SIZE);
+	else
+		tegrabl_loader_set_kernel_decompress_buffer(NULL, 0);
+#endif
+#if defined(CONFIG_ENABLE_BOOTIMG_SCATTER_LOAD)
+	/* Uncompressed kernel and ramdisk are read to where they boot from */
+#if CONFIG_BOOTIMG_HEADER_VERSION >= 3
+	/* generic ramdisk goes right after vendor ramdisk */
+	if (scatter && (vndhdr->vendor_ramdisk_size <= MAX_RAMDISK_SIZE)) {
+		if (scatter_ramdisk != NULL)
+			scatter_ramdisk += vndhdr->vendor_ramdisk_size;
+		tegrabl_loader_set_bootimg_scatter((void *)LINUX_LOAD_ADDRESS,
+			MAX_KERNEL_IMAGE_SIZE, scatter_ramdisk,
+			MAX_RAMDISK_SIZE - vndhdr->vendor_ramdisk_size);
+	}
+#else
+	if (scatter)
+		tegrabl_loader_set_bootimg_scatter((void *)LINUX_LOAD_ADDRESS,
+			MAX_KERNEL_IMAGE_SIZE, scatter_ramdisk, MAX_RAMDISK_SIZE);
+#endif
+#endif
 	err = tegrabl_load_binary(kernel->bin_type, (void **)&hdr, NULL);
+#if defined(CONFIG_ENABLE_BOOTIMG_SCATTER_LOAD)
+	if (scatter)
+		bootimg_placed = tegrabl_loader_get_bootimg_scatter(hdr);
+#endif
 	if (err != TEGRABL_NO_ERROR) {
 		pr_error("boot.img loading failed\n");
 		goto fail;
@@ -399,6 +565,14 @@ load_dtb:
 	if (callbacks != NULL && callbacks->verify_boot != NULL)
 		callbacks->verify_boot(hdr, vndhdr, *kernel_dtb, kernel_dtbo);
 
+#if defined(CONFIG_ENABLE_PRELOADED_PARTITIONS)
+	/* Images get unpacked, patched and released from here on */
+	tegrabl_loader_drop_preloaded(hdr);
+	tegrabl_loader_drop_preloaded(vndhdr);
+	tegrabl_loader_drop_preloaded(*kernel_dtb);
+	tegrabl_loader_drop_preloaded(kernel_dtbo);
+#endif
+
 	err = extract_kernel(hdr, vndhdr, kernel_entry_point);
 	if (err != TEGRABL_NO_ERROR) {
 		pr_error("Error %u loading the kernel\n", err);
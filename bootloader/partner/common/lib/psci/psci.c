@@ -8,6 +8,12 @@
  * license agreement from NVIDIA Corporation is strictly prohibited.
  */
 
+#define MODULE TEGRABL_ERR_NO_MODULE
+
+#include <stdint.h>
+#include <tegrabl_error.h>
+#include <tegrabl_debug.h>
+#include <tegrabl_arm64_smccc.h>
 #include "psci_priv.h"
 
 /**
@@ -26,3 +32,55 @@ void tegrabl_psci_sys_off(void)
 	tegrabl_psci_smc(TEGRABL_PSCI_0_2_SYSTEM_OFF, 0, 0, 0);
 }
 
+
+/**
+* @brief power-on a CPU
+*/
+tegrabl_error_t tegrabl_psci_cpu_on(uint64_t mpidr, uintptr_t entry,
+									uint64_t context_id)
+{
+	struct tegrabl_arm64_smc64_params smc_regs = {
+		{TEGRABL_PSCI_0_2_CPU_ON, mpidr, entry, context_id}
+	};
+
+	tegrabl_arm64_send_smc64(&smc_regs);
+
+	if (smc_regs.reg[0] != 0) {
+		pr_error("PSCI CPU_ON of 0x%lx failed (%ld)\n", (unsigned long)mpidr,
+				 (long)smc_regs.reg[0]);
+		return TEGRABL_ERROR(TEGRABL_ERR_COMMAND_FAILED, 0);
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+/**
+* @brief power-off the calling CPU
+*/
+void tegrabl_psci_cpu_off(void)
+{
+	struct tegrabl_arm64_smc64_params smc_regs = {
+		{TEGRABL_PSCI_0_2_CPU_OFF}
+	};
+
+	tegrabl_arm64_send_smc64(&smc_regs);
+
+	/* CPU_OFF was denied, keep the CPU out of the way */
+	while (1) {
+		__asm__ volatile ("wfe");
+	}
+}
+
+/**
+* @brief get power state of a CPU
+*/
+int64_t tegrabl_psci_affinity_info(uint64_t mpidr)
+{
+	struct tegrabl_arm64_smc64_params smc_regs = {
+		{TEGRABL_PSCI_0_2_AFFINITY_INFO, mpidr, 0}
+	};
+
+	tegrabl_arm64_send_smc64(&smc_regs);
+
+	return (int64_t)smc_regs.reg[0];
+}
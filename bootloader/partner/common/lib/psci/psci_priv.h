@@ -14,8 +14,12 @@
 
 /* PSCI v0.2 interface */
 #define TEGRABL_PSCI_0_2_BASE		0x84000000
+#define TEGRABL_PSCI_0_2_BASE64		0xC4000000
 
 /* Only the PSCI FN ids which are currently needed by BL are added */
+ #define TEGRABL_PSCI_0_2_CPU_OFF       (TEGRABL_PSCI_0_2_BASE + 0x2)
+ #define TEGRABL_PSCI_0_2_CPU_ON        (TEGRABL_PSCI_0_2_BASE64 + 0x3)
+ #define TEGRABL_PSCI_0_2_AFFINITY_INFO (TEGRABL_PSCI_0_2_BASE64 + 0x4)
  #define TEGRABL_PSCI_0_2_SYSTEM_OFF    (TEGRABL_PSCI_0_2_BASE + 0x8)
  #define TEGRABL_PSCI_0_2_SYSTEM_RESET  (TEGRABL_PSCI_0_2_BASE + 0x9)
 
@@ -14,7 +14,8 @@ MODULE := $(LOCAL_DIR)
 
 GLOBAL_INCLUDES += \
 	$(LOCAL_DIR)/../../include \
-	$(LOCAL_DIR)/../../include/lib
+	$(LOCAL_DIR)/../../include/lib \
+	$(LOCAL_DIR)/../../include/arch
 
 MODULE_SRCS += \
 	$(LOCAL_DIR)/smc.S \
@@ -38,6 +38,7 @@ endif
 TEGRABL_DECOMPRESSOR_ZLIB := yes
 #TEGRABL_DECOMPRESSOR_LZF := yes
 TEGRABL_DECOMPRESSOR_LZ4 := yes
+TEGRABL_DECOMPRESSOR_ZSTD := yes
 
 ifeq ($(TEGRABL_DECOMPRESSOR_LZF), yes)
 MODULE_DEFINES += CONFIG_ENABLE_LZF=1
@@ -73,5 +74,30 @@ MODULE_SRCS +=      \
 GLOBAL_INCLUDES += $(EXTERNAL_LIB_DIR)/lz4
 endif
 
+ifeq ($(TEGRABL_DECOMPRESSOR_ZSTD), yes)
+MODULE_DEFINES += CONFIG_ENABLE_ZSTD=1
+
+# decompression only, without legacy formats, tracing and x86 assembly
+MODULE_DEFINES += \
+		ZSTD_LEGACY_SUPPORT=0 \
+		ZSTD_TRACE=0 \
+		ZSTD_DISABLE_ASM=1
+
+MODULE_SRCS +=      \
+		$(EXTERNAL_LIB_DIR)/zstd/common/debug.c \
+		$(EXTERNAL_LIB_DIR)/zstd/common/entropy_common.c \
+		$(EXTERNAL_LIB_DIR)/zstd/common/error_private.c \
+		$(EXTERNAL_LIB_DIR)/zstd/common/fse_decompress.c \
+		$(EXTERNAL_LIB_DIR)/zstd/common/xxhash.c \
+		$(EXTERNAL_LIB_DIR)/zstd/common/zstd_common.c \
+		$(EXTERNAL_LIB_DIR)/zstd/decompress/huf_decompress.c \
+		$(EXTERNAL_LIB_DIR)/zstd/decompress/zstd_ddict.c \
+		$(EXTERNAL_LIB_DIR)/zstd/decompress/zstd_decompress.c \
+		$(EXTERNAL_LIB_DIR)/zstd/decompress/zstd_decompress_block.c \
+		$(LOCAL_DIR)/tegrabl_zstd_decompress.c
+
+GLOBAL_INCLUDES += $(EXTERNAL_LIB_DIR)/zstd
+endif
+
 include make/module.mk
 
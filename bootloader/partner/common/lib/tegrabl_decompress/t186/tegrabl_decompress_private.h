@@ -15,6 +15,7 @@
 #include "tegrabl_debug.h"
 #include "tegrabl_malloc.h"
 #include "string.h"
+#include "stdbool.h"
 
 
 /* zlib decompressor APIs */
@@ -29,6 +30,12 @@ tegrabl_error_t zlib_decompress(void *cntxt, void *in_buffer, uint32_t in_size,
 
 /* zlib algo clean up api */
 tegrabl_error_t zlib_end(void *cntxt);
+
+/* zlib algo streaming decompress api */
+tegrabl_error_t zlib_decompress_stream(void *cntxt, void *in_buffer,
+									   uint32_t in_size, uint32_t *consumed,
+									   void *out_buffer, uint32_t outbuf_size,
+									   uint32_t *written_size, bool *done);
 #endif
 
 
@@ -45,10 +52,55 @@ tegrabl_error_t do_lzf_decompress(void *cntxt, void *in_buffer,
 
 
 #ifdef CONFIG_ENABLE_LZ4
+/* lz4 algo context initialization */
+void *lz4_init(uint32_t compressed_size);
+
 /* lz4 algo decompress api */
 tegrabl_error_t do_lz4_decompress(void *cntxt, void *in_buffer,
 								  uint32_t in_size, void *out_buffer,
 								  uint32_t outbuf_size, uint32_t *written_size);
+
+/* lz4 algo streaming decompress api */
+tegrabl_error_t do_lz4_decompress_stream(void *cntxt, void *in_buffer,
+										 uint32_t in_size, uint32_t *consumed,
+										 void *out_buffer, uint32_t outbuf_size,
+										 uint32_t *written_size, bool *done);
+
+/* lz4 frame algo context initialization */
+void *lz4f_init(uint32_t compressed_size);
+
+/* lz4 frame algo decompress api */
+tegrabl_error_t do_lz4f_decompress(void *cntxt, void *in_buffer,
+								   uint32_t in_size, void *out_buffer,
+								   uint32_t outbuf_size, uint32_t *written_size);
+
+/* lz4 frame algo streaming decompress api */
+tegrabl_error_t do_lz4f_decompress_stream(void *cntxt, void *in_buffer,
+										  uint32_t in_size, uint32_t *consumed,
+										  void *out_buffer,
+										  uint32_t outbuf_size,
+										  uint32_t *written_size, bool *done);
+#endif
+
+
+/* zstd decompressor APIs */
+#ifdef CONFIG_ENABLE_ZSTD
+/* zstd algo context initialization */
+void *zstd_init(uint32_t compressed_size);
+
+/* zstd algo decompress api */
+tegrabl_error_t zstd_decompress(void *cntxt, void *in_buffer, uint32_t in_size,
+								void *out_buffer, uint32_t outbuf_size,
+								uint32_t *written_size);
+
+/* zstd algo clean up api */
+tegrabl_error_t zstd_end(void *cntxt);
+
+/* zstd algo streaming decompress api */
+tegrabl_error_t zstd_decompress_stream(void *cntxt, void *in_buffer,
+									   uint32_t in_size, uint32_t *consumed,
+									   void *out_buffer, uint32_t outbuf_size,
+									   uint32_t *written_size, bool *done);
 #endif
 
 #endif
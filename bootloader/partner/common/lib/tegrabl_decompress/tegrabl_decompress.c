@@ -22,6 +22,7 @@ decompressor zlib = {
 	zlib_init,
 	zlib_decompress,
 	zlib_end,
+	zlib_decompress_stream,
 };
 #endif
 
@@ -32,6 +33,7 @@ decompressor lzf = {
 	lzf_init,
 	do_lzf_decompress,
 	NULL,
+	NULL,
 };
 #endif
 
@@ -39,12 +41,36 @@ decompressor lzf = {
 decompressor lz4 = {
 	{0x02, 0x21},
 	"lz4",
-	NULL,
+	lz4_init,
 	do_lz4_decompress,
 	NULL,
+	do_lz4_decompress_stream,
+};
+
+decompressor lz4f = {
+	{0x04, 0x22},
+	"lz4f",
+	lz4f_init,
+	do_lz4f_decompress,
+	NULL,
+	do_lz4f_decompress_stream,
+};
+#endif
+
+#ifdef CONFIG_ENABLE_ZSTD
+/* zstd frame magic is 0xFD2FB528, little endian */
+decompressor zstd = {
+	{0x28, 0xb5},
+	"zstd",
+	zstd_init,
+	zstd_decompress,
+	zstd_end,
+	zstd_decompress_stream,
 };
 #endif
 
+static decompress_block_runner_t block_runner;
+
 decompressor *decompressor_list[] = {
 #ifdef CONFIG_ENABLE_ZLIB
 	&zlib,
@@ -54,6 +80,10 @@ decompressor *decompressor_list[] = {
 #endif
 #ifdef CONFIG_ENABLE_LZ4
 	&lz4,
+	&lz4f,
+#endif
+#ifdef CONFIG_ENABLE_ZSTD
+	&zstd,
 #endif
 	NULL,
 };
@@ -153,3 +183,76 @@ tegrabl_error_t do_decompress(decompressor *decomp, uint8_t *read_buffer,
 	return err;
 }
 
+tegrabl_error_t decompress_stream_init(struct decompress_stream *stream,
+									   decompressor *decomp,
+									   uint32_t compressed_size,
+									   uint8_t *out_buffer,
+									   uint32_t outbuf_size)
+{
+	memset(stream, 0, sizeof(*stream));
+
+	if (!decomp->decompress_stream) {
+		pr_debug("%s cannot decompress as stream\n", decomp->name);
+		return TEGRABL_ERR_NOT_SUPPORTED;
+	}
+
+	if (decomp->init) {
+		stream->context = decomp->init(compressed_size);
+		if (!stream->context) {
+			pr_critical("Decompressor init failed\n");
+			return TEGRABL_ERR_INIT_FAILED;
+		}
+	}
+
+	stream->decomp = decomp;
+	stream->out_buffer = out_buffer;
+	stream->outbuf_size = outbuf_size;
+
+	return TEGRABL_NO_ERROR;
+}
+
+tegrabl_error_t decompress_stream_feed(struct decompress_stream *stream,
+									   uint8_t *in_buffer, uint32_t in_size,
+									   uint32_t *consumed)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	uint32_t written_size = 0;
+
+	*consumed = 0;
+	if (stream->done || (in_size == 0)) {
+		return TEGRABL_NO_ERROR;
+	}
+
+	err = stream->decomp->decompress_stream(stream->context, in_buffer,
+						in_size, consumed,
+						stream->out_buffer + stream->written_size,
+						stream->outbuf_size - stream->written_size,
+						&written_size, &stream->done);
+	if (err != TEGRABL_NO_ERROR) {
+		pr_critical("Failure during decompressing (err: %d)\n", err);
+		return err;
+	}
+
+	stream->written_size += written_size;
+
+	return TEGRABL_NO_ERROR;
+}
+
+void decompress_stream_end(struct decompress_stream *stream)
+{
+	if (stream->decomp && stream->decomp->end) {
+		stream->decomp->end(stream->context);
+	}
+	stream->decomp = NULL;
+	stream->context = NULL;
+}
+
+void decompress_set_block_runner(decompress_block_runner_t runner)
+{
+	block_runner = runner;
+}
+
+decompress_block_runner_t decompress_get_block_runner(void)
+{
+	return block_runner;
+}
@@ -10,9 +10,34 @@
 
 #include "tegrabl_error.h"
 #include "tegrabl_utils.h"
+#include "string.h"
 #include "lz4.h"
+#include "tegrabl_decompress.h"
 #include "tegrabl_decompress_private.h"
 
+/* Size of the magic number and of each block size field */
+#define LZ4_LEGACY_WORD_SIZE 4
+
+/* NOTE Single instance, only one stream can be decompressed at a time */
+struct lz4_context {
+	uint32_t compressed_size;
+	uint32_t processed;
+	bool done;
+};
+
+static struct lz4_context _lz4_context;
+
+void *lz4_init(uint32_t compressed_size)
+{
+	struct lz4_context *context = &_lz4_context;
+
+	context->compressed_size = compressed_size;
+	context->processed = 0;
+	context->done = false;
+
+	return context;
+}
+
 tegrabl_error_t do_lz4_decompress(void *cntxt, void *in_buffer,
 								  uint32_t in_size, void *out_buffer,
 								  uint32_t outbuf_size, uint32_t *written_size)
@@ -65,3 +90,655 @@ fail:
 
 	return ret;
 }
+
+tegrabl_error_t do_lz4_decompress_stream(void *cntxt, void *in_buffer,
+										 uint32_t in_size, uint32_t *consumed,
+										 void *out_buffer, uint32_t outbuf_size,
+										 uint32_t *written_size, bool *done)
+{
+	int32_t err = 0;
+	tegrabl_error_t ret = TEGRABL_NO_ERROR;
+	struct lz4_context *context = (struct lz4_context *)cntxt;
+	uint8_t *cbuf = (uint8_t *)in_buffer;
+	uint8_t *dbuf = (uint8_t *)out_buffer;
+	uint8_t *cbuf_end = cbuf + in_size;
+	uint8_t *dbuf_end = dbuf + outbuf_size;
+	uint32_t avail;
+	uint32_t left;
+	uint32_t c_size;
+
+	/* MAGIC NUMBER: 4B */
+	if (context->processed == 0) {
+		if (in_size < LZ4_LEGACY_WORD_SIZE) {
+			goto done;
+		}
+		cbuf += LZ4_LEGACY_WORD_SIZE;
+	}
+
+	/* Only complete blocks are decompressed, rest is left for next call */
+	while (!context->done) {
+		avail = cbuf_end - cbuf;
+		left = context->compressed_size - context->processed -
+			(uint32_t)(cbuf - (uint8_t *)in_buffer);
+
+		/* Like in do_lz4_decompress, a block size field which is not
+		 * followed by any data (e.g. the appended image size) ends it */
+		if (left <= LZ4_LEGACY_WORD_SIZE) {
+			if (avail >= left) {
+				cbuf += left;
+				context->done = true;
+			}
+			break;
+		}
+
+		if (avail < LZ4_LEGACY_WORD_SIZE) {
+			break;
+		}
+
+		/* block size: 4B */
+		c_size = *((uint32_t *)cbuf);
+		if (c_size > left - LZ4_LEGACY_WORD_SIZE) {
+			pr_critical("invalid block size %u\n", c_size);
+			ret = TEGRABL_ERR_INVALID;
+			goto done;
+		}
+		if (c_size > avail - LZ4_LEGACY_WORD_SIZE) {
+			break;
+		}
+
+		err = LZ4_decompress_safe((char *)cbuf + LZ4_LEGACY_WORD_SIZE,
+								  (char *)dbuf, c_size, dbuf_end - dbuf);
+		if (err < 0) {
+			pr_critical("failed to decompress, err=%d\n", err);
+			ret = TEGRABL_ERR_INVALID;
+			goto done;
+		}
+
+		cbuf += LZ4_LEGACY_WORD_SIZE + c_size;
+		dbuf += err;
+	}
+
+done:
+	*consumed = (uint32_t)(cbuf - (uint8_t *)in_buffer);
+	*written_size = (uint32_t)(dbuf - (uint8_t *)out_buffer);
+	context->processed += *consumed;
+	*done = context->done;
+
+	return ret;
+}
+
+/*
+ * LZ4 frame format
+ *
+ * Frame: magic, descriptor (FLG, BD, optional content size and dictionary
+ * ID, header checksum), blocks, end mark and optional content checksum.
+ * Block: 4B size (MSB set if stored uncompressed), data and optional 4B
+ * checksum of data.
+ */
+#define LZ4F_MAGIC 0x184D2204U
+#define LZ4F_HEADER_MIN_SIZE 7U
+#define LZ4F_HEADER_MAX_SIZE 19U
+#define LZ4F_FLG_VERSION_SHIFT 6
+#define LZ4F_FLG_VERSION 1U
+#define LZ4F_FLG_BLOCK_INDEP (1U << 5)
+#define LZ4F_FLG_BLOCK_CHECKSUM (1U << 4)
+#define LZ4F_FLG_CONTENT_SIZE (1U << 3)
+#define LZ4F_FLG_CONTENT_CHECKSUM (1U << 2)
+#define LZ4F_FLG_RESERVED (1U << 1)
+#define LZ4F_FLG_DICT_ID (1U << 0)
+#define LZ4F_BD_BLOCK_MAX_SHIFT 4
+#define LZ4F_BD_BLOCK_MAX_MASK 0x7U
+#define LZ4F_BD_RESERVED 0x8FU
+#define LZ4F_BLOCK_UNCOMPRESSED (1U << 31)
+#define LZ4F_WORD_SIZE 4U
+/* Linked blocks may refer back this far into previous output */
+#define LZ4F_DICT_SIZE (64U * 1024U)
+/* Blocks handed to block runner at once */
+#define LZ4F_MAX_JOBS 32U
+
+#define XXH_PRIME32_1 2654435761U
+#define XXH_PRIME32_2 2246822519U
+#define XXH_PRIME32_3 3266489917U
+#define XXH_PRIME32_4 668265263U
+#define XXH_PRIME32_5 374761393U
+
+struct lz4_xxh32 {
+	uint32_t v[4];
+	uint32_t total;
+	uint8_t mem[16];
+	uint32_t memsize;
+};
+
+/* NOTE Single instance, only one stream can be decompressed at a time */
+struct lz4f_context {
+	uint32_t block_max;
+	uint64_t content_size;
+	uint64_t written;
+	bool has_content_size;
+	bool block_independent;
+	bool block_checksum;
+	bool content_checksum;
+	bool header_done;
+	bool end_mark;
+	bool done;
+	struct lz4_xxh32 xxh;
+};
+
+static struct lz4f_context _lz4f_context;
+
+static inline uint32_t lz4_read32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+		((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint32_t lz4_rotl32(uint32_t x, uint32_t r)
+{
+	return (x << r) | (x >> (32U - r));
+}
+
+static inline uint32_t lz4_xxh32_round(uint32_t acc, uint32_t input)
+{
+	acc += input * XXH_PRIME32_2;
+	acc = lz4_rotl32(acc, 13);
+	return acc * XXH_PRIME32_1;
+}
+
+static void lz4_xxh32_init(struct lz4_xxh32 *state)
+{
+	memset(state, 0, sizeof(*state));
+	state->v[0] = XXH_PRIME32_1 + XXH_PRIME32_2;
+	state->v[1] = XXH_PRIME32_2;
+	state->v[2] = 0;
+	state->v[3] = 0U - XXH_PRIME32_1;
+}
+
+static void lz4_xxh32_stripe(struct lz4_xxh32 *state, const uint8_t *p)
+{
+	state->v[0] = lz4_xxh32_round(state->v[0], lz4_read32(p));
+	state->v[1] = lz4_xxh32_round(state->v[1], lz4_read32(p + 4));
+	state->v[2] = lz4_xxh32_round(state->v[2], lz4_read32(p + 8));
+	state->v[3] = lz4_xxh32_round(state->v[3], lz4_read32(p + 12));
+}
+
+static void lz4_xxh32_update(struct lz4_xxh32 *state, const uint8_t *p,
+							 uint32_t len)
+{
+	const uint8_t *end = p + len;
+	uint32_t fill;
+
+	state->total += len;
+
+	if ((state->memsize + len) < sizeof(state->mem)) {
+		memcpy(state->mem + state->memsize, p, len);
+		state->memsize += len;
+		return;
+	}
+
+	if (state->memsize != 0U) {
+		fill = sizeof(state->mem) - state->memsize;
+		memcpy(state->mem + state->memsize, p, fill);
+		lz4_xxh32_stripe(state, state->mem);
+		p += fill;
+		state->memsize = 0;
+	}
+
+	while ((end - p) >= (ptrdiff_t)sizeof(state->mem)) {
+		lz4_xxh32_stripe(state, p);
+		p += sizeof(state->mem);
+	}
+
+	state->memsize = (uint32_t)(end - p);
+	memcpy(state->mem, p, state->memsize);
+}
+
+static uint32_t lz4_xxh32_digest(const struct lz4_xxh32 *state)
+{
+	const uint8_t *p = state->mem;
+	const uint8_t *end = p + state->memsize;
+	uint32_t h;
+
+	if (state->total >= sizeof(state->mem)) {
+		h = lz4_rotl32(state->v[0], 1) + lz4_rotl32(state->v[1], 7) +
+			lz4_rotl32(state->v[2], 12) + lz4_rotl32(state->v[3], 18);
+	} else {
+		h = state->v[2] + XXH_PRIME32_5;
+	}
+	h += state->total;
+
+	while ((end - p) >= 4) {
+		h += lz4_read32(p) * XXH_PRIME32_3;
+		h = lz4_rotl32(h, 17) * XXH_PRIME32_4;
+		p += 4;
+	}
+	while (p < end) {
+		h += (uint32_t)(*p) * XXH_PRIME32_5;
+		h = lz4_rotl32(h, 11) * XXH_PRIME32_1;
+		p++;
+	}
+
+	h ^= h >> 15;
+	h *= XXH_PRIME32_2;
+	h ^= h >> 13;
+	h *= XXH_PRIME32_3;
+	h ^= h >> 16;
+
+	return h;
+}
+
+static uint32_t lz4_xxh32(const uint8_t *p, uint32_t len)
+{
+	struct lz4_xxh32 state;
+
+	lz4_xxh32_init(&state);
+	lz4_xxh32_update(&state, p, len);
+
+	return lz4_xxh32_digest(&state);
+}
+
+void *lz4f_init(uint32_t compressed_size)
+{
+	struct lz4f_context *context = &_lz4f_context;
+
+	(void)compressed_size;
+
+	memset(context, 0, sizeof(*context));
+	lz4_xxh32_init(&context->xxh);
+
+	return context;
+}
+
+/*
+ * Parse frame header into context. Returns TEGRABL_ERR_NOT_FOUND if more
+ * input is needed to parse it.
+ */
+static tegrabl_error_t lz4f_parse_header(struct lz4f_context *context,
+										 const uint8_t *buf, uint32_t avail,
+										 uint32_t *header_size)
+{
+	uint32_t flg;
+	uint32_t bd;
+	uint32_t size;
+	uint32_t block_max_id;
+
+	if (avail < LZ4F_HEADER_MIN_SIZE) {
+		return TEGRABL_ERR_NOT_FOUND;
+	}
+
+	if (lz4_read32(buf) != LZ4F_MAGIC) {
+		pr_critical("invalid lz4 frame magic\n");
+		return TEGRABL_ERR_INVALID;
+	}
+
+	flg = buf[4];
+	bd = buf[5];
+	if (((flg >> LZ4F_FLG_VERSION_SHIFT) != LZ4F_FLG_VERSION) ||
+		((flg & LZ4F_FLG_RESERVED) != 0U) || ((bd & LZ4F_BD_RESERVED) != 0U)) {
+		pr_critical("unsupported lz4 frame (FLG 0x%02x BD 0x%02x)\n", flg, bd);
+		return TEGRABL_ERR_NOT_SUPPORTED;
+	}
+	if ((flg & LZ4F_FLG_DICT_ID) != 0U) {
+		pr_critical("lz4 frame with dictionary is not supported\n");
+		return TEGRABL_ERR_NOT_SUPPORTED;
+	}
+
+	block_max_id = (bd >> LZ4F_BD_BLOCK_MAX_SHIFT) & LZ4F_BD_BLOCK_MAX_MASK;
+	if (block_max_id < 4U) {
+		pr_critical("invalid lz4 frame block size id %u\n", block_max_id);
+		return TEGRABL_ERR_INVALID;
+	}
+
+	size = LZ4F_HEADER_MIN_SIZE;
+	if ((flg & LZ4F_FLG_CONTENT_SIZE) != 0U) {
+		size += 8U;
+	}
+	if (avail < size) {
+		return TEGRABL_ERR_NOT_FOUND;
+	}
+
+	/* Header checksum covers the descriptor, i.e. FLG up to HC */
+	if (buf[size - 1U] !=
+		((lz4_xxh32(buf + 4, size - 5U) >> 8) & 0xFFU)) {
+		pr_critical("lz4 frame header checksum mismatch\n");
+		return TEGRABL_ERR_VERIFY_FAILED;
+	}
+
+	context->block_max = 1U << (8U + (2U * block_max_id));
+	context->block_independent = (flg & LZ4F_FLG_BLOCK_INDEP) != 0U;
+	context->block_checksum = (flg & LZ4F_FLG_BLOCK_CHECKSUM) != 0U;
+	context->content_checksum = (flg & LZ4F_FLG_CONTENT_CHECKSUM) != 0U;
+	context->has_content_size = (flg & LZ4F_FLG_CONTENT_SIZE) != 0U;
+	if (context->has_content_size) {
+		context->content_size = (uint64_t)lz4_read32(buf + 6) |
+			((uint64_t)lz4_read32(buf + 10) << 32);
+	}
+
+	*header_size = size;
+
+	return TEGRABL_NO_ERROR;
+}
+
+static int32_t lz4f_decode_block(struct decompress_block_job *job)
+{
+	return LZ4_decompress_safe(job->in_buffer, job->out_buffer,
+							   (int)job->in_size, (int)job->outbuf_size);
+}
+
+static int32_t lz4f_copy_block(struct decompress_block_job *job)
+{
+	if (job->in_size > job->outbuf_size) {
+		return -1;
+	}
+	memmove(job->out_buffer, job->in_buffer, job->in_size);
+
+	return (int32_t)job->in_size;
+}
+
+/*
+ * Check block at buf, which has avail bytes of input behind it. Returns
+ * TEGRABL_ERR_NOT_FOUND if block is not complete yet.
+ */
+static tegrabl_error_t lz4f_get_block(struct lz4f_context *context,
+									  const uint8_t *buf, uint32_t avail,
+									  uint32_t *c_size, bool *is_raw,
+									  uint32_t *block_size)
+{
+	uint32_t word;
+	uint32_t size;
+
+	if (avail < LZ4F_WORD_SIZE) {
+		return TEGRABL_ERR_NOT_FOUND;
+	}
+
+	word = lz4_read32(buf);
+	*is_raw = (word & LZ4F_BLOCK_UNCOMPRESSED) != 0U;
+	*c_size = word & ~LZ4F_BLOCK_UNCOMPRESSED;
+	if (*c_size > context->block_max) {
+		pr_critical("invalid lz4 frame block size %u\n", *c_size);
+		return TEGRABL_ERR_INVALID;
+	}
+
+	size = LZ4F_WORD_SIZE + *c_size;
+	if ((*c_size != 0U) && context->block_checksum) {
+		size += LZ4F_WORD_SIZE;
+	}
+	if (avail < size) {
+		return TEGRABL_ERR_NOT_FOUND;
+	}
+
+	if ((*c_size != 0U) && context->block_checksum &&
+		(lz4_read32(buf + LZ4F_WORD_SIZE + *c_size) !=
+		 lz4_xxh32(buf + LZ4F_WORD_SIZE, *c_size))) {
+		pr_critical("lz4 frame block checksum mismatch\n");
+		return TEGRABL_ERR_VERIFY_FAILED;
+	}
+
+	*block_size = size;
+
+	return TEGRABL_NO_ERROR;
+}
+
+static tegrabl_error_t lz4f_check_end(struct lz4f_context *context)
+{
+	if (context->has_content_size &&
+		(context->written != context->content_size)) {
+		pr_critical("lz4 frame content size mismatch\n");
+		return TEGRABL_ERR_INVALID;
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+tegrabl_error_t do_lz4f_decompress_stream(void *cntxt, void *in_buffer,
+										  uint32_t in_size, uint32_t *consumed,
+										  void *out_buffer,
+										  uint32_t outbuf_size,
+										  uint32_t *written_size, bool *done)
+{
+	tegrabl_error_t ret = TEGRABL_NO_ERROR;
+	struct lz4f_context *context = (struct lz4f_context *)cntxt;
+	struct decompress_block_job job;
+	uint8_t *cbuf = (uint8_t *)in_buffer;
+	uint8_t *dbuf = (uint8_t *)out_buffer;
+	uint8_t *cbuf_end = cbuf + in_size;
+	uint8_t *dbuf_end = dbuf + outbuf_size;
+	uint32_t avail;
+	uint32_t size = 0;
+	uint32_t c_size = 0;
+	uint32_t dict_size;
+	bool is_raw = false;
+	int32_t err;
+
+	/* Blocks are decoded strictly in order */
+	while (!context->done) {
+		avail = (uint32_t)(cbuf_end - cbuf);
+
+		if (!context->header_done) {
+			ret = lz4f_parse_header(context, cbuf, avail, &size);
+			if (ret != TEGRABL_NO_ERROR) {
+				break;
+			}
+			context->header_done = true;
+			cbuf += size;
+			continue;
+		}
+
+		if (context->end_mark) {
+			if (context->content_checksum) {
+				if (avail < LZ4F_WORD_SIZE) {
+					break;
+				}
+				if (lz4_read32(cbuf) != lz4_xxh32_digest(&context->xxh)) {
+					pr_critical("lz4 frame content checksum mismatch\n");
+					ret = TEGRABL_ERR_VERIFY_FAILED;
+					goto done;
+				}
+				cbuf += LZ4F_WORD_SIZE;
+			}
+			context->done = true;
+			break;
+		}
+
+		ret = lz4f_get_block(context, cbuf, avail, &c_size, &is_raw, &size);
+		if (ret != TEGRABL_NO_ERROR) {
+			break;
+		}
+
+		if (c_size == 0U) {
+			context->end_mark = true;
+			cbuf += size;
+			ret = lz4f_check_end(context);
+			if (ret != TEGRABL_NO_ERROR) {
+				goto done;
+			}
+			continue;
+		}
+
+		job.in_buffer = cbuf + LZ4F_WORD_SIZE;
+		job.in_size = c_size;
+		job.out_buffer = dbuf;
+		job.outbuf_size = (uint32_t)(dbuf_end - dbuf);
+		if (is_raw) {
+			err = lz4f_copy_block(&job);
+		} else if (context->block_independent) {
+			err = lz4f_decode_block(&job);
+		} else {
+			/* Output is contiguous, so the dictionary is right behind */
+			dict_size = (uint32_t)MIN(context->written,
+									  (uint64_t)LZ4F_DICT_SIZE);
+			err = LZ4_decompress_safe_usingDict((char *)job.in_buffer,
+					(char *)dbuf, (int)c_size, (int)job.outbuf_size,
+					(char *)dbuf - dict_size, (int)dict_size);
+		}
+		if (err < 0) {
+			pr_critical("failed to decompress, err=%d\n", err);
+			ret = TEGRABL_ERR_INVALID;
+			goto done;
+		}
+
+		if (context->content_checksum) {
+			lz4_xxh32_update(&context->xxh, dbuf, (uint32_t)err);
+		}
+		dbuf += err;
+		context->written += (uint32_t)err;
+		cbuf += size;
+	}
+
+	/* Running out of input is not an error for a stream */
+	if (ret == TEGRABL_ERR_NOT_FOUND) {
+		ret = TEGRABL_NO_ERROR;
+	}
+
+done:
+	*consumed = (uint32_t)(cbuf - (uint8_t *)in_buffer);
+	*written_size = (uint32_t)(dbuf - (uint8_t *)out_buffer);
+	*done = context->done;
+
+	return ret;
+}
+
+/*
+ * Decode independent blocks in batches through the registered block runner.
+ * Output offset of each block has to be known up front, so all blocks but
+ * the last one are expected to fill block_max; TEGRABL_ERR_NOT_SUPPORTED is
+ * returned when that does not hold and serial decode has to be used instead.
+ */
+static tegrabl_error_t lz4f_decompress_batched(struct lz4f_context *context,
+		decompress_block_runner_t runner, uint8_t *in_buffer, uint32_t in_size,
+		uint8_t *out_buffer, uint32_t outbuf_size, uint32_t *written_size)
+{
+	static struct decompress_block_job jobs[LZ4F_MAX_JOBS];
+	tegrabl_error_t ret = TEGRABL_NO_ERROR;
+	uint8_t *cbuf = in_buffer;
+	uint8_t *cbuf_end = in_buffer + in_size;
+	uint8_t *dbuf = out_buffer;
+	uint8_t *dbuf_end = out_buffer + outbuf_size;
+	uint32_t count = 0;
+	uint32_t size = 0;
+	uint32_t c_size = 0;
+	uint32_t i;
+	bool is_raw = false;
+	bool is_short = false;
+
+	ret = lz4f_parse_header(context, cbuf, in_size, &size);
+	if (ret != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+	cbuf += size;
+
+	do {
+		ret = lz4f_get_block(context, cbuf, (uint32_t)(cbuf_end - cbuf),
+							 &c_size, &is_raw, &size);
+		if (ret != TEGRABL_NO_ERROR) {
+			goto fail;
+		}
+
+		if (c_size != 0U) {
+			jobs[count].decode = is_raw ? lz4f_copy_block : lz4f_decode_block;
+			jobs[count].in_buffer = cbuf + LZ4F_WORD_SIZE;
+			jobs[count].in_size = c_size;
+			jobs[count].out_buffer = dbuf;
+			jobs[count].outbuf_size = MIN(context->block_max,
+										  (uint32_t)(dbuf_end - dbuf));
+			jobs[count].result = -1;
+			dbuf += jobs[count].outbuf_size;
+			count++;
+		}
+		cbuf += size;
+
+		if ((count == LZ4F_MAX_JOBS) || ((c_size == 0U) && (count != 0U))) {
+			runner(jobs, count);
+
+			for (i = 0; i < count; i++) {
+				if (jobs[i].result < 0) {
+					pr_critical("failed to decompress, err=%d\n",
+								jobs[i].result);
+					ret = TEGRABL_ERR_INVALID;
+					goto fail;
+				}
+				/* Only the last block of frame may be short */
+				if (is_short || ((uint32_t)jobs[i].result < context->block_max)) {
+					if (is_short || (i != (count - 1U)) || (c_size != 0U)) {
+						ret = TEGRABL_ERR_NOT_SUPPORTED;
+						goto fail;
+					}
+					is_short = true;
+				}
+				context->written += (uint32_t)jobs[i].result;
+			}
+			count = 0;
+		}
+	} while (c_size != 0U);
+
+	ret = lz4f_check_end(context);
+	if (ret != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	if (context->content_checksum) {
+		if ((uint32_t)(cbuf_end - cbuf) < LZ4F_WORD_SIZE) {
+			ret = TEGRABL_ERR_INVALID;
+			goto fail;
+		}
+		if (lz4_read32(cbuf) !=
+			lz4_xxh32(out_buffer, (uint32_t)context->written)) {
+			pr_critical("lz4 frame content checksum mismatch\n");
+			ret = TEGRABL_ERR_VERIFY_FAILED;
+			goto fail;
+		}
+	}
+
+	context->done = true;
+	*written_size = (uint32_t)context->written;
+
+fail:
+	return ret;
+}
+
+tegrabl_error_t do_lz4f_decompress(void *cntxt, void *in_buffer,
+								   uint32_t in_size, void *out_buffer,
+								   uint32_t outbuf_size, uint32_t *written_size)
+{
+	tegrabl_error_t ret = TEGRABL_NO_ERROR;
+	struct lz4f_context *context = (struct lz4f_context *)cntxt;
+	decompress_block_runner_t runner = decompress_get_block_runner();
+	uint32_t consumed = 0;
+	uint32_t header_size = 0;
+	bool done = false;
+
+	pr_debug("inbuf=0x%p (size:%d), outbuf=0x%p\n", in_buffer, in_size,
+			 out_buffer);
+
+	ret = lz4f_parse_header(context, in_buffer, in_size, &header_size);
+	if (ret == TEGRABL_ERR_NOT_FOUND) {
+		ret = TEGRABL_ERR_INVALID;
+	}
+	if (ret != TEGRABL_NO_ERROR) {
+		return ret;
+	}
+
+	if (context->has_content_size && (context->content_size > outbuf_size)) {
+		pr_critical("%s: output buffer is too small!\n", __func__);
+		return TEGRABL_ERR_OVERFLOW;
+	}
+
+	if ((runner != NULL) && context->block_independent) {
+		ret = lz4f_decompress_batched(context, runner, in_buffer, in_size,
+									  out_buffer, outbuf_size, written_size);
+		if (ret != TEGRABL_ERR_NOT_SUPPORTED) {
+			return ret;
+		}
+		pr_debug("lz4 frame has short blocks, decoding serially\n");
+	}
+
+	lz4f_init(in_size);
+	ret = do_lz4f_decompress_stream(context, in_buffer, in_size, &consumed,
+									out_buffer, outbuf_size, written_size,
+									&done);
+	if ((ret == TEGRABL_NO_ERROR) && !done) {
+		pr_critical("lz4 frame is truncated\n");
+		ret = TEGRABL_ERR_INVALID;
+	}
+
+	return ret;
+}
@@ -40,6 +40,7 @@ void *zlib_init(uint32_t compressed_size)
 	context->strm.opaque = Z_NULL;
 	context->strm.avail_in = 0;
 	context->strm.next_in = Z_NULL;
+	context->done = false;
 
 	/* add 32 to detect header type automatically */
 	ret = inflateInit2(&(context->strm), 32 + MAX_WBITS);
@@ -95,6 +96,42 @@ tegrabl_error_t zlib_decompress(void *cntxt, void *in_buffer, uint32_t in_size,
 	return TEGRABL_NO_ERROR;
 }
 
+tegrabl_error_t zlib_decompress_stream(void *cntxt, void *in_buffer,
+									   uint32_t in_size, uint32_t *consumed,
+									   void *out_buffer, uint32_t outbuf_size,
+									   uint32_t *written_size, bool *done)
+{
+	int32_t ret;
+	struct zlib_context *context = (struct zlib_context *)cntxt;
+
+	context->strm.avail_in = in_size;
+	context->strm.next_in = in_buffer;
+	context->strm.avail_out = outbuf_size;
+	context->strm.next_out = out_buffer;
+
+	/* inflate keeps its window across calls, so whole input is consumed as
+	 * long as there is room for the output */
+	ret = inflate(&(context->strm), Z_NO_FLUSH);
+
+	*consumed = in_size - context->strm.avail_in;
+	*written_size = outbuf_size - context->strm.avail_out;
+
+	if (ret == Z_STREAM_END) {
+		context->done = true;
+	} else if ((ret != Z_OK) && (ret != Z_BUF_ERROR)) {
+		pr_critical("zlib::inflate() returns %s (%d)\n",
+					context->strm.msg, ret);
+		return TEGRABL_ERR_BAD_PARAMETER;
+	} else if (context->strm.avail_out == 0) {
+		pr_critical("%s: output buffer is too small!\n", __func__);
+		return TEGRABL_ERR_OVERFLOW;
+	}
+
+	*done = context->done;
+
+	return TEGRABL_NO_ERROR;
+}
+
 tegrabl_error_t zlib_end(void *cntxt)
 {
 	struct zlib_context *context = (struct zlib_context *)cntxt;
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2017, NVIDIA Corporation.  All rights reserved.
+ *
+ * NVIDIA Corporation and its licensors retain all intellectual property
+ * and proprietary rights in and to this software and related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA Corporation is strictly prohibited.
+ */
+
+#include "tegrabl_error.h"
+#include "tegrabl_utils.h"
+#include "string.h"
+#define ZSTD_STATIC_LINKING_ONLY
+#include "zstd.h"
+#include "tegrabl_decompress.h"
+#include "tegrabl_decompress_private.h"
+
+/* NOTE Single instance, only one stream can be decompressed at a time */
+struct zstd_context {
+	ZSTD_DCtx *dctx;
+	ZSTD_outBuffer out;
+	bool done;
+};
+
+static struct zstd_context _zstd_context;
+
+void *zstd_init(uint32_t compressed_size)
+{
+	struct zstd_context *context = &_zstd_context;
+	size_t ret;
+
+	(void)compressed_size;
+
+	/* Context is kept if previous user did not get to end */
+	if (context->dctx == NULL) {
+		context->dctx = ZSTD_createDCtx();
+		if (context->dctx == NULL) {
+			pr_critical("failed to allocate zstd context\n");
+			return NULL;
+		}
+	} else {
+		ZSTD_DCtx_reset(context->dctx, ZSTD_reset_session_and_parameters);
+	}
+
+	/* Output always goes to one contiguous buffer, so it can serve as the
+	 * window and zstd does not need to allocate one of window size */
+	ret = ZSTD_DCtx_setParameter(context->dctx, ZSTD_d_stableOutBuffer, 1);
+	if (ZSTD_isError(ret)) {
+		pr_critical("zstd::setParameter() returns %s\n",
+					ZSTD_getErrorName(ret));
+		return NULL;
+	}
+
+	memset(&context->out, 0, sizeof(context->out));
+	context->done = false;
+
+	return context;
+}
+
+tegrabl_error_t zstd_decompress(void *cntxt, void *in_buffer, uint32_t in_size,
+								void *out_buffer, uint32_t outbuf_size,
+								uint32_t *written_size)
+{
+	struct zstd_context *context = (struct zstd_context *)cntxt;
+	size_t ret;
+
+	pr_debug("inbuf=0x%p (size:0x%x), outbuf=0x%p\n",
+			 in_buffer, in_size, out_buffer);
+
+	ret = ZSTD_decompressDCtx(context->dctx, out_buffer, outbuf_size,
+							  in_buffer, in_size);
+	if (ZSTD_isError(ret)) {
+		pr_critical("zstd::decompress() returns %s\n", ZSTD_getErrorName(ret));
+		if (ZSTD_getErrorCode(ret) == ZSTD_error_dstSize_tooSmall) {
+			return TEGRABL_ERR_OVERFLOW;
+		}
+		return TEGRABL_ERR_BAD_PARAMETER;
+	}
+
+	*written_size = (uint32_t)ret;
+	context->done = true;
+
+	pr_debug("%s: decompressed data-size: %d\n", __func__, *written_size);
+
+	return TEGRABL_NO_ERROR;
+}
+
+tegrabl_error_t zstd_decompress_stream(void *cntxt, void *in_buffer,
+									   uint32_t in_size, uint32_t *consumed,
+									   void *out_buffer, uint32_t outbuf_size,
+									   uint32_t *written_size, bool *done)
+{
+	struct zstd_context *context = (struct zstd_context *)cntxt;
+	ZSTD_inBuffer in;
+	size_t start;
+	size_t ret;
+
+	/* zstd expects the very same output buffer on every call, it has to be
+	 * continuation of the previous output */
+	if (context->out.dst == NULL) {
+		context->out.dst = out_buffer;
+		context->out.size = outbuf_size;
+		context->out.pos = 0;
+	} else if (((uint8_t *)context->out.dst + context->out.pos) != out_buffer) {
+		pr_critical("%s: output is not contiguous\n", __func__);
+		return TEGRABL_ERR_INVALID;
+	}
+	start = context->out.pos;
+
+	in.src = in_buffer;
+	in.size = in_size;
+	in.pos = 0;
+
+	/* Partial blocks are buffered by zstd, so whole input is consumed as
+	 * long as there is room for the output */
+	ret = ZSTD_decompressStream(context->dctx, &context->out, &in);
+
+	*consumed = (uint32_t)in.pos;
+	*written_size = (uint32_t)(context->out.pos - start);
+
+	if (ZSTD_isError(ret)) {
+		pr_critical("zstd::decompressStream() returns %s\n",
+					ZSTD_getErrorName(ret));
+		if (ZSTD_getErrorCode(ret) == ZSTD_error_dstSize_tooSmall) {
+			return TEGRABL_ERR_OVERFLOW;
+		}
+		return TEGRABL_ERR_BAD_PARAMETER;
+	} else if (ret == 0) {
+		/* frame is completely decoded and flushed */
+		context->done = true;
+	} else if (context->out.pos == context->out.size) {
+		pr_critical("%s: output buffer is too small!\n", __func__);
+		return TEGRABL_ERR_OVERFLOW;
+	}
+
+	*done = context->done;
+
+	return TEGRABL_NO_ERROR;
+}
+
+tegrabl_error_t zstd_end(void *cntxt)
+{
+	struct zstd_context *context = (struct zstd_context *)cntxt;
+
+	ZSTD_freeDCtx(context->dctx);
+	context->dctx = NULL;
+
+	return TEGRABL_NO_ERROR;
+}
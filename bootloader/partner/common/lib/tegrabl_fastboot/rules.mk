@@ -27,6 +27,7 @@ MODULE_SRCS += \
 	$(LOCAL_DIR)/tegrabl_fastboot_partinfo.c \
 	$(LOCAL_DIR)/tegrabl_fastboot_protocol.c \
 	$(LOCAL_DIR)/tegrabl_fastboot_oem.c \
+	$(LOCAL_DIR)/tegrabl_fastboot_batch.c \
 	$(LOCAL_DIR)/tegrabl_fastboot_a_b.c
 
 include make/module.mk
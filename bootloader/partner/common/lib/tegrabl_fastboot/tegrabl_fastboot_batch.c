@@ -0,0 +1,496 @@
+/*
+ * Copyright (c) 2017, NVIDIA Corporation.  All Rights Reserved.
+ *
+ * NVIDIA Corporation and its licensors retain all intellectual property and
+ * proprietary rights in and to this software and related documentation.  Any
+ * use, reproduction, disclosure or distribution of this software and related
+ * documentation without an express license agreement from NVIDIA Corporation
+ * is strictly prohibited.
+ */
+
+#define MODULE TEGRABL_ERR_FASTBOOT
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <kernel/thread.h>
+#include <kernel/semaphore.h>
+#include <tegrabl_error.h>
+#include <tegrabl_debug.h>
+#include <tegrabl_utils.h>
+#include <tegrabl_malloc.h>
+#include <tegrabl_fastboot_protocol.h>
+#include <tegrabl_fastboot_partinfo.h>
+#include <tegrabl_fastboot_oem.h>
+#include <tegrabl_fastboot_batch.h>
+#include <tegrabl_transport_usbf.h>
+#include <tegrabl_partition_manager.h>
+#include <tegrabl_a_b_partition_naming.h>
+#include <tegrabl_sparse.h>
+
+#define BATCH_LINE_SIZE (2 * MAX_RESPONSE_SIZE)
+
+/**
+ * @brief State of one partition of the batch
+ *
+ * @param name Partition name as given in manifest
+ * @param partition Handle of the opened partition
+ * @param size Size of the image in payload
+ * @param done Bytes of the image consumed so far
+ * @param head First bytes of image, gathered when they are split across two
+ * chunks so that image type can be found out
+ * @param head_len Valid bytes in head
+ * @param is_started true once image type is known and writing has begun
+ * @param is_sparse true if image has to be unsparsed
+ * @param unsparse_state State of the unsparse machine for sparse image
+ * @param error First error hit while writing the image
+ */
+struct batch_entry {
+	char name[MAX_RESPONSE_SIZE];
+	struct tegrabl_partition partition;
+	uint32_t size;
+	uint32_t done;
+	uint8_t head[sizeof(uint32_t)];
+	uint32_t head_len;
+	bool is_started;
+	bool is_sparse;
+	struct tegrabl_unsparse_state unsparse_state;
+	tegrabl_error_t error;
+};
+
+/**
+ * @brief Chunk of payload handed over to writer thread. NULL buffer asks the
+ * writer to exit.
+ */
+struct batch_chunk {
+	uint8_t *buf;
+	uint32_t len;
+};
+
+/**
+ * @brief Context shared between the receiving fastboot thread and the writer
+ * thread. Chunk buffers are used in turns and writer consumes them in the
+ * same order, so buffer of a chunk is the one of chunk queued
+ * FASTBOOT_BATCH_NUM_BUFS earlier.
+ *
+ * @param free_sem Counts the buffers which can be received into
+ * @param full_sem Counts the chunks queued to writer
+ */
+struct batch_ctx {
+	struct batch_entry entries[FASTBOOT_BATCH_MAX_ENTRIES];
+	uint32_t num_entries;
+	uint32_t cur_entry;
+	uint8_t *bufs[FASTBOOT_BATCH_NUM_BUFS];
+	struct batch_chunk queue[FASTBOOT_BATCH_NUM_BUFS];
+	uint32_t queue_head;
+	uint32_t queue_tail;
+	semaphore_t free_sem;
+	semaphore_t full_sem;
+};
+
+static tegrabl_error_t batch_add_entry(struct batch_ctx *ctx, char *line)
+{
+	struct batch_entry *entry;
+	const struct tegrabl_fastboot_partition_info *partinfo = NULL;
+	const char *suffix = NULL;
+	const char *tegra_part_name = NULL;
+	char *name;
+	char *size_str;
+	char *end = NULL;
+	unsigned long size;
+
+	name = line;
+	while (isspace((int)*name)) {
+		name++;
+	}
+	if ((*name == '\0') || (*name == '#')) {
+		return TEGRABL_NO_ERROR;
+	}
+
+	size_str = name;
+	while ((*size_str != '\0') && !isspace((int)*size_str)) {
+		size_str++;
+	}
+	if (*size_str == '\0') {
+		fastboot_fail("Manifest line has no size");
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 1);
+	}
+	*size_str++ = '\0';
+
+	size = tegrabl_utils_strtoul(size_str, &end, 16);
+	while ((end != NULL) && isspace((int)*end)) {
+		end++;
+	}
+	if ((end == size_str) || (end == NULL) || (*end != '\0') ||
+		(size == 0UL) || (size > UINT32_MAX)) {
+		fastboot_fail("Manifest has invalid size");
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 2);
+	}
+
+	if (ctx->num_entries == FASTBOOT_BATCH_MAX_ENTRIES) {
+		fastboot_fail("Too many partitions in manifest");
+		return TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 0);
+	}
+
+	if (strlen(name) >= sizeof(entry->name)) {
+		fastboot_fail("Partition name too long");
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 3);
+	}
+
+	/* Bootloader payload needs the complete image before it can be
+	 * processed */
+	if (tegrabl_a_b_match_part_name_with_suffix("bootloader", name)) {
+		fastboot_fail("Use download and flash for bootloader payload");
+		return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 1);
+	}
+
+	partinfo = tegrabl_fastboot_get_partinfo(name);
+	if (!partinfo) {
+		fastboot_fail("No partition present with this name.");
+		return TEGRABL_ERROR(TEGRABL_ERR_NOT_FOUND, 0);
+	}
+
+	entry = &ctx->entries[ctx->num_entries];
+	suffix = tegrabl_a_b_get_part_suffix(name);
+	tegra_part_name = tegrabl_fastboot_get_tegra_part_name(suffix, partinfo);
+	if (tegrabl_partition_open(tegra_part_name, &entry->partition) !=
+		TEGRABL_NO_ERROR) {
+		fastboot_fail("Partition may not exist or can not be accessed.");
+		return TEGRABL_ERROR(TEGRABL_ERR_OPEN_FAILED, 0);
+	}
+
+	strcpy(entry->name, name);
+	entry->size = (uint32_t)size;
+	ctx->num_entries++;
+
+	return TEGRABL_NO_ERROR;
+}
+
+static tegrabl_error_t batch_parse_manifest(struct batch_ctx *ctx,
+											const char *manifest, uint32_t size)
+{
+	char line[BATCH_LINE_SIZE];
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	uint32_t pos = 0;
+	uint32_t len;
+
+	while (pos < size) {
+		len = 0;
+		while (((pos + len) < size) && (manifest[pos + len] != '\n')) {
+			len++;
+		}
+		if (len >= sizeof(line)) {
+			fastboot_fail("Manifest line too long");
+			return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 4);
+		}
+		memcpy(line, manifest + pos, len);
+		line[len] = '\0';
+		pos += len + 1U;
+
+		error = batch_add_entry(ctx, line);
+		if (error != TEGRABL_NO_ERROR) {
+			return error;
+		}
+	}
+
+	if (ctx->num_entries == 0U) {
+		fastboot_fail("Manifest is empty");
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 5);
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+static tegrabl_error_t batch_start_entry(struct batch_entry *entry,
+										 const uint8_t *head, uint32_t len)
+{
+	entry->is_started = true;
+	entry->is_sparse = tegrabl_sparse_image_check((void *)head, len);
+
+	if (entry->is_sparse) {
+		return tegrabl_sparse_init_unsparse_state(&entry->unsparse_state,
+				tegrabl_partition_size(&entry->partition),
+				tegrabl_fastboot_partition_write,
+				tegrabl_fastboot_partition_seek);
+	}
+
+	if (entry->size > tegrabl_partition_size(&entry->partition)) {
+		pr_error("Image is larger than partition %s\n", entry->name);
+		return TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 1);
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+static tegrabl_error_t batch_write_data(struct batch_entry *entry,
+										const uint8_t *buf, uint32_t len)
+{
+	if (entry->is_sparse) {
+		return tegrabl_sparse_unsparse(&entry->unsparse_state, buf, len,
+									   &entry->partition);
+	}
+
+	return tegrabl_fastboot_partition_write(buf, len, &entry->partition);
+}
+
+static void batch_write_entry(struct batch_entry *entry, const uint8_t *buf,
+							  uint32_t len)
+{
+	uint32_t copy;
+
+	if (entry->error != TEGRABL_NO_ERROR) {
+		return;
+	}
+
+	if (!entry->is_started) {
+		if ((entry->head_len == 0U) &&
+			((len >= sizeof(entry->head)) || (len == entry->size))) {
+			entry->error = batch_start_entry(entry, buf, len);
+		} else {
+			/* Image starts at the very end of the chunk, gather the
+			 * first word from this and next chunk */
+			copy = MIN(len, sizeof(entry->head) - entry->head_len);
+			memcpy(entry->head + entry->head_len, buf, copy);
+			entry->head_len += copy;
+			buf += copy;
+			len -= copy;
+
+			if ((entry->head_len < sizeof(entry->head)) &&
+				((entry->done + copy) < entry->size)) {
+				return;
+			}
+
+			entry->error = batch_start_entry(entry, entry->head,
+											 entry->head_len);
+			if (entry->error == TEGRABL_NO_ERROR) {
+				entry->error = batch_write_data(entry, entry->head,
+												entry->head_len);
+			}
+		}
+	}
+
+	if ((entry->error == TEGRABL_NO_ERROR) && (len != 0U)) {
+		entry->error = batch_write_data(entry, buf, len);
+	}
+
+	if (entry->error != TEGRABL_NO_ERROR) {
+		pr_error("Failed to write partition %s\n", entry->name);
+	}
+}
+
+static void batch_write_chunk(struct batch_ctx *ctx, const uint8_t *buf,
+							  uint32_t len)
+{
+	struct batch_entry *entry;
+	uint32_t bytes;
+
+	while ((len != 0U) && (ctx->cur_entry < ctx->num_entries)) {
+		entry = &ctx->entries[ctx->cur_entry];
+		bytes = MIN(len, entry->size - entry->done);
+
+		batch_write_entry(entry, buf, bytes);
+
+		entry->done += bytes;
+		buf += bytes;
+		len -= bytes;
+
+		if (entry->done == entry->size) {
+			pr_info("%s: %s done\n", __func__, entry->name);
+			ctx->cur_entry++;
+		}
+	}
+}
+
+static int batch_writer(void *arg)
+{
+	struct batch_ctx *ctx = (struct batch_ctx *)arg;
+	struct batch_chunk *chunk;
+
+	while (true) {
+		sem_wait(&ctx->full_sem);
+		chunk = &ctx->queue[ctx->queue_head];
+		ctx->queue_head = (ctx->queue_head + 1U) % FASTBOOT_BATCH_NUM_BUFS;
+
+		if (chunk->buf == NULL) {
+			break;
+		}
+
+		batch_write_chunk(ctx, chunk->buf, chunk->len);
+		sem_post(&ctx->free_sem);
+	}
+
+	return 0;
+}
+
+static void batch_queue_chunk(struct batch_ctx *ctx, uint8_t *buf,
+							  uint32_t len)
+{
+	ctx->queue[ctx->queue_tail].buf = buf;
+	ctx->queue[ctx->queue_tail].len = len;
+	ctx->queue_tail = (ctx->queue_tail + 1U) % FASTBOOT_BATCH_NUM_BUFS;
+	sem_post(&ctx->full_sem);
+}
+
+static tegrabl_error_t batch_receive(struct batch_ctx *ctx, uint32_t total)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	uint32_t remaining = total;
+	uint32_t chunk_len;
+	uint32_t received = 0;
+	uint32_t idx = 0;
+
+	while (remaining != 0U) {
+		chunk_len = MIN(remaining, FASTBOOT_STREAM_CHUNK_SIZE);
+
+		/* Wait for writer to be done with the oldest buffer */
+		sem_wait(&ctx->free_sem);
+
+		error = tegrabl_transport_usbf_receive_start(ctx->bufs[idx],
+													 chunk_len);
+		if (error == TEGRABL_NO_ERROR) {
+			error = tegrabl_transport_usbf_receive_complete(&received,
+															FB_TFR_TIMEOUT);
+		}
+		if ((error != TEGRABL_NO_ERROR) || (received != chunk_len)) {
+			/* Make sure no TRB still points into the buffer, it is freed
+			 * as soon as writer is done.
+			 */
+			tegrabl_transport_usbf_receive_abort();
+			sem_post(&ctx->free_sem);
+			return TEGRABL_ERROR(TEGRABL_ERR_READ_FAILED, 0);
+		}
+
+		batch_queue_chunk(ctx, ctx->bufs[idx], chunk_len);
+		remaining -= chunk_len;
+		idx = (idx + 1U) % FASTBOOT_BATCH_NUM_BUFS;
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
+tegrabl_error_t tegrabl_fastboot_flash_batch(void)
+{
+	char response[MAX_RESPONSE_SIZE];
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	struct batch_ctx *ctx = NULL;
+	thread_t *writer = NULL;
+	const char *manifest;
+	uint32_t manifest_size = 0;
+	uint64_t total = 0;
+	uint32_t transmitted = 0;
+	uint32_t i;
+	bool is_unlocked;
+
+	error = tegrabl_is_device_unlocked(&is_unlocked);
+	if (error != TEGRABL_NO_ERROR) {
+		fastboot_fail("Bootloader lock state unknown");
+		return error;
+	}
+	if (!is_unlocked) {
+		fastboot_fail("Bootloader is locked.");
+		return TEGRABL_ERROR(TEGRABL_ERR_LOCK_FAILED, 0);
+	}
+
+	manifest = tegrabl_fastboot_get_download_buffer(&manifest_size);
+	if ((manifest == NULL) || (manifest_size == 0U)) {
+		fastboot_fail("Download manifest first");
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 6);
+	}
+
+	ctx = tegrabl_calloc(1, sizeof(*ctx));
+	if (ctx == NULL) {
+		fastboot_fail("Memory Insufficient");
+		return TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 0);
+	}
+
+	error = batch_parse_manifest(ctx, manifest, manifest_size);
+	if (error != TEGRABL_NO_ERROR) {
+		goto fail;
+	}
+
+	for (i = 0; i < ctx->num_entries; i++) {
+		total += ctx->entries[i].size;
+	}
+	if (total > UINT32_MAX) {
+		fastboot_fail("Payload too large");
+		error = TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 2);
+		goto fail;
+	}
+
+	for (i = 0; i < FASTBOOT_BATCH_NUM_BUFS; i++) {
+		ctx->bufs[i] = tegrabl_memalign(USB_BUFFER_ALIGNMENT,
+										FASTBOOT_STREAM_CHUNK_SIZE);
+		if (ctx->bufs[i] == NULL) {
+			fastboot_fail("Memory Insufficient");
+			error = TEGRABL_ERROR(TEGRABL_ERR_NO_MEMORY, 1);
+			goto fail;
+		}
+	}
+
+	sem_init(&ctx->free_sem, FASTBOOT_BATCH_NUM_BUFS);
+	sem_init(&ctx->full_sem, 0);
+
+	writer = thread_create("fastboot-batch-writer", batch_writer, ctx,
+						   DEFAULT_PRIORITY, DEFAULT_STACK_SIZE);
+	if (writer == NULL) {
+		fastboot_fail("Failed to create writer thread");
+		error = TEGRABL_ERROR(TEGRABL_ERR_INIT_FAILED, 0);
+		goto fail;
+	}
+	thread_resume(writer);
+
+	sprintf(response, "DATA%08x", (uint32_t)total);
+	error = tegrabl_transport_usbf_send(response, strlen(response),
+										&transmitted, FB_TFR_TIMEOUT);
+	if (error == TEGRABL_NO_ERROR) {
+		pr_info("%s: receiving %u bytes for %u partitions\n", __func__,
+				(uint32_t)total, ctx->num_entries);
+		error = batch_receive(ctx, (uint32_t)total);
+	}
+
+	/* Let writer finish the queued chunks and exit */
+	sem_wait(&ctx->free_sem);
+	batch_queue_chunk(ctx, NULL, 0);
+	thread_join(writer, NULL, INFINITE_TIME);
+
+	if (error != TEGRABL_NO_ERROR) {
+		pr_error("%s: usb_read failed\n", __func__);
+		fastboot_fail("USB read Failed");
+		goto fail;
+	}
+
+	for (i = 0; i < ctx->num_entries; i++) {
+		if ((ctx->entries[i].error == TEGRABL_NO_ERROR) &&
+			ctx->entries[i].is_sparse &&
+			!tegrabl_sparse_unsparse_is_complete(
+				&ctx->entries[i].unsparse_state)) {
+			pr_error("Sparse image for %s is truncated\n",
+					 ctx->entries[i].name);
+			ctx->entries[i].error = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 7);
+		}
+		if (ctx->entries[i].error != TEGRABL_NO_ERROR) {
+			tegrabl_snprintf(response, sizeof(response),
+							 "Partition %s write failed!", ctx->entries[i].name);
+			fastboot_fail(response);
+			error = ctx->entries[i].error;
+			goto fail;
+		}
+	}
+
+fail:
+	for (i = 0; i < ctx->num_entries; i++) {
+		if (ctx->entries[i].is_sparse) {
+			tegrabl_sparse_abort_unsparse(&ctx->entries[i].unsparse_state);
+		}
+	}
+	for (i = 0; i < FASTBOOT_BATCH_NUM_BUFS; i++) {
+		if (ctx->bufs[i] != NULL) {
+			tegrabl_free(ctx->bufs[i]);
+		}
+	}
+	tegrabl_free(ctx);
+
+	return error;
+}
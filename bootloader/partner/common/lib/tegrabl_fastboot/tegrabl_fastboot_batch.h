@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2017, NVIDIA Corporation.  All Rights Reserved.
+ *
+ * NVIDIA Corporation and its licensors retain all intellectual property and
+ * proprietary rights in and to this software and related documentation.  Any
+ * use, reproduction, disclosure or distribution of this software and related
+ * documentation without an express license agreement from NVIDIA Corporation
+ * is strictly prohibited.
+ */
+
+#ifndef TEGRABL_FASTBOOT_BATCH_H
+#define TEGRABL_FASTBOOT_BATCH_H
+
+#include <tegrabl_error.h>
+
+/* Max number of partitions which can be listed in one manifest */
+#define FASTBOOT_BATCH_MAX_ENTRIES 32
+
+/* Number of FASTBOOT_STREAM_CHUNK_SIZE buffers which can be received ahead
+ * of the partition writes */
+#define FASTBOOT_BATCH_NUM_BUFS 4
+
+/**
+ * @brief Flashes several partitions from a single concatenated payload.
+ *
+ * The manifest has to be sent first with download. Each line of it names a
+ * partition and the size in hex of its image, e.g. "system 0x3c00000", in
+ * the order the images are concatenated in the payload. Lines starting with
+ * '#' are skipped. The payload is then requested from host with a single
+ * DATA response and written by a separate thread while rest of it is still
+ * being received. Sparse images are unsparsed.
+ *
+ * @return TEGRABL_NO_ERROR if all the partitions are written. Otherwise
+ * failure is already reported to host and appropriate error is returned.
+ */
+tegrabl_error_t tegrabl_fastboot_flash_batch(void);
+
+#endif /* TEGRABL_FASTBOOT_BATCH_H */
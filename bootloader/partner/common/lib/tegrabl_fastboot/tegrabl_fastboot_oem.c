@@ -13,6 +13,7 @@
 #include <tegrabl_error.h>
 #include <tegrabl_devicetree.h>
 #include <tegrabl_fastboot_oem.h>
+#include <tegrabl_fastboot_batch.h>
 #include <tegrabl_debug.h>
 #include <tegrabl_fastboot_protocol.h>
 #include <string.h>
@@ -108,6 +109,8 @@ tegrabl_error_t tegrabl_fastboot_oem_handler(const char *arg)
 			tegrabl_snprintf(ecid_str, sizeof(ecid_str), "%s%08x", ecid_str,
 							 *ecid_ptr);
 		fastboot_ack("INFO", ecid_str);
+	} else if (IS_VAR_TYPE("flash-batch")) {
+		ret = tegrabl_fastboot_flash_batch();
 	}
 
 	return ret;
@@ -101,6 +101,12 @@ void fastboot_okay(const char *info)
 	fastboot_ack("OKAY", info);
 }
 
+void *tegrabl_fastboot_get_download_buffer(uint32_t *size)
+{
+	*size = download_size;
+	return download_base;
+}
+
 static void fastboot_getvar(const char *arg, char *response)
 {
 	const char *partition_name;
@@ -545,6 +551,12 @@ static void cmd_flash(const char *arg, void *data, uint32_t sz)
 	if (is_sparse) {
 		error = tegrabl_sparse_unsparse(&unsparse_state, download_base,
 										download_size, &partition);
+		if ((error == TEGRABL_NO_ERROR) &&
+			!tegrabl_sparse_unsparse_is_complete(&unsparse_state)) {
+			pr_error("Sparse image is truncated\n");
+			error = TEGRABL_ERR_INVALID;
+		}
+		tegrabl_sparse_abort_unsparse(&unsparse_state);
 	} else {
 		tegrabl_fastboot_partition_write(download_base, download_size,
 										 &partition);
@@ -557,6 +569,189 @@ flash_exit:
 		fastboot_fail("Partition write failed!");
 }
 
+/* flash-stream:<partition>:<hex size>
+ * Same as download followed by flash, except that data is written to
+ * partition while rest of the image is still being received. Two chunk
+ * buffers are used in turns: next chunk is received by DMA while current
+ * one is unsparsed or written. Bootloader payload is not supported as it
+ * needs the complete image.
+ */
+static void cmd_flash_stream(const char *arg, void *data, uint32_t sz)
+{
+	char response[MAX_RESPONSE_SIZE];
+	char part_name[MAX_RESPONSE_SIZE];
+	const struct tegrabl_fastboot_partition_info *partinfo = NULL;
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	tegrabl_error_t write_error = TEGRABL_NO_ERROR;
+	struct tegrabl_partition partition;
+	struct tegrabl_unsparse_state unsparse_state;
+	uint8_t *chunk_buf[2] = {NULL, NULL};
+	const char *size_str = NULL;
+	const char *suffix = NULL;
+	const char *tegra_part_name = NULL;
+	uint32_t len = 0;
+	uint32_t remaining = 0;
+	uint32_t chunk_len = 0;
+	uint32_t next_len = 0;
+	uint32_t received = 0;
+	uint32_t transmitted = 0;
+	uint32_t cur = 0;
+	bool is_sparse = false;
+	bool is_first = true;
+	bool is_unlocked;
+
+	(void)data;
+	(void)sz;
+
+	error = tegrabl_is_device_unlocked(&is_unlocked);
+	if (error != TEGRABL_NO_ERROR) {
+		fastboot_fail("Bootloader lock state unknown");
+		return;
+	}
+	if (!is_unlocked) {
+		fastboot_fail("Bootloader is locked.");
+		return;
+	}
+
+	size_str = strrchr(arg, ':');
+	if (!size_str || (size_str == arg) ||
+		((size_t)(size_str - arg) >= sizeof(part_name))) {
+		fastboot_fail("Usage: flash-stream:<partition>:<size>");
+		return;
+	}
+	memcpy(part_name, arg, size_str - arg);
+	part_name[size_str - arg] = '\0';
+
+	len = hex2uint32_t((const uint8_t *)(size_str + 1));
+	if (len == 0) {
+		fastboot_fail("Invalid size");
+		return;
+	}
+
+	if (tegrabl_a_b_match_part_name_with_suffix("bootloader", part_name)) {
+		fastboot_fail("Use download and flash for bootloader payload");
+		return;
+	}
+
+	suffix = tegrabl_a_b_get_part_suffix(part_name);
+
+	partinfo = tegrabl_fastboot_get_partinfo(part_name);
+	if (!partinfo) {
+		fastboot_fail("No partition present with this name.");
+		return;
+	}
+
+	tegra_part_name = tegrabl_fastboot_get_tegra_part_name(suffix, partinfo);
+	error = tegrabl_partition_open(tegra_part_name, &partition);
+	if (error) {
+		fastboot_fail("Partition may not exist or can not be accessed.");
+		return;
+	}
+
+	chunk_buf[0] = tegrabl_memalign(USB_BUFFER_ALIGNMENT,
+									FASTBOOT_STREAM_CHUNK_SIZE);
+	chunk_buf[1] = tegrabl_memalign(USB_BUFFER_ALIGNMENT,
+									FASTBOOT_STREAM_CHUNK_SIZE);
+	if (!chunk_buf[0] || !chunk_buf[1]) {
+		pr_error("%s: malloc failed\n", __func__);
+		fastboot_fail("Memory Insufficient");
+		goto free_bufs;
+	}
+
+	sprintf(response, "DATA%08x", len);
+	if (tegrabl_transport_usbf_send(response, strlen(response), &transmitted,
+									FB_TFR_TIMEOUT)) {
+		goto free_bufs;
+	}
+
+	pr_info("%s: streaming %u bytes to %s\n", __func__, len, tegra_part_name);
+	memset(&unsparse_state, 0x0, sizeof(unsparse_state));
+
+	remaining = len;
+	chunk_len = MIN(remaining, FASTBOOT_STREAM_CHUNK_SIZE);
+	error = tegrabl_transport_usbf_receive_start(chunk_buf[cur], chunk_len);
+
+	while (error == TEGRABL_NO_ERROR) {
+		error = tegrabl_transport_usbf_receive_complete(&received,
+														FB_TFR_TIMEOUT);
+		if ((error != TEGRABL_NO_ERROR) || (received != chunk_len)) {
+			error = TEGRABL_ERR_INVALID_STATE;
+			break;
+		}
+		remaining -= chunk_len;
+
+		/* Get the next chunk on its way before writing this one */
+		if (remaining != 0U) {
+			next_len = MIN(remaining, FASTBOOT_STREAM_CHUNK_SIZE);
+			error = tegrabl_transport_usbf_receive_start(chunk_buf[cur ^ 1U],
+														 next_len);
+			if (error != TEGRABL_NO_ERROR) {
+				break;
+			}
+		}
+
+		if (is_first) {
+			is_first = false;
+			is_sparse = tegrabl_sparse_image_check(chunk_buf[cur], chunk_len);
+			if (is_sparse) {
+				write_error = tegrabl_sparse_init_unsparse_state(
+					&unsparse_state, tegrabl_partition_size(&partition),
+					tegrabl_fastboot_partition_write,
+					tegrabl_fastboot_partition_seek);
+			} else if (len > tegrabl_partition_size(&partition)) {
+				pr_error("Image is larger than partition\n");
+				write_error = TEGRABL_ERR_OVERFLOW;
+			}
+		}
+
+		/* On a write failure keep draining the host so that protocol
+		 * stays in sync, and report the failure at the end.
+		 */
+		if (write_error == TEGRABL_NO_ERROR) {
+			if (is_sparse) {
+				write_error = tegrabl_sparse_unsparse(&unsparse_state,
+						chunk_buf[cur], chunk_len, &partition);
+			} else {
+				write_error = tegrabl_fastboot_partition_write(chunk_buf[cur],
+						chunk_len, &partition);
+			}
+		}
+
+		if (remaining == 0U) {
+			break;
+		}
+		chunk_len = next_len;
+		cur ^= 1U;
+	}
+
+	if (is_sparse) {
+		if ((error == TEGRABL_NO_ERROR) && (write_error == TEGRABL_NO_ERROR) &&
+			!tegrabl_sparse_unsparse_is_complete(&unsparse_state)) {
+			pr_error("Sparse image is truncated\n");
+			write_error = TEGRABL_ERR_INVALID;
+		}
+		tegrabl_sparse_abort_unsparse(&unsparse_state);
+	}
+
+	if (error != TEGRABL_NO_ERROR) {
+		pr_error("%s: usb_read failed\n", __func__);
+		fastboot_fail("USB read Failed");
+		fastboot_state = STATE_ERROR;
+	} else if (write_error != TEGRABL_NO_ERROR) {
+		fastboot_fail("Partition write failed!");
+	} else {
+		fastboot_okay("");
+	}
+
+free_bufs:
+	if (chunk_buf[0]) {
+		tegrabl_free(chunk_buf[0]);
+	}
+	if (chunk_buf[1]) {
+		tegrabl_free(chunk_buf[1]);
+	}
+}
+
 static void cmd_flashing(const char *arg, void *data, uint32_t sz)
 {
 	(void)arg;
@@ -624,6 +819,7 @@ void tegrabl_fastboot_cmd_init(void)
 	fastboot_register("erase:", cmd_erase);
 	fastboot_register("download:", cmd_download);
 	fastboot_register("flash:", cmd_flash);
+	fastboot_register("flash-stream:", cmd_flash_stream);
 	fastboot_register("boot", cmd_boot);
 	fastboot_register("continue", cmd_continue);
 	fastboot_register("oem ", cmd_oem);
@@ -448,6 +448,16 @@ fail:
 	return aio;
 }
 
+tegrabl_error_t tegrabl_partition_getstatus(struct tegrabl_partition *partition,
+		tegrabl_aio_t *aio)
+{
+	if (!partition || !partition->block_device || !aio) {
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 8);
+	}
+
+	return tegrabl_blockdev_xfer_poll(partition->block_device, aio);
+}
+
 tegrabl_error_t tegrabl_partition_publish(tegrabl_bdev_t *dev, off_t offset)
 {
 	tegrabl_error_t error = TEGRABL_NO_ERROR;
@@ -13,10 +13,25 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <tegrabl_error.h>
 
 #define TEGRABL_SPARSE_HEADER_MAJOR_VERSION (1)
 
 #define SPARSE_MAX_LOCAL_BUFFER 1024
 
+/* Size of the heap buffer used to expand fill chunks. It is kept for the
+ * life of the image. Falls back to the local buffer if it cannot be
+ * allocated.
+ */
+#define SPARSE_FILL_BUFFER_SIZE (1024 * 1024)
+#define SPARSE_FILL_BUFFER_ALIGN 64
+
+/* Size of the buffer in which RAW chunk data is gathered so that storage
+ * sees large block aligned writes. Buffers which are aligned are written
+ * directly in multiples of this size.
+ */
+#define SPARSE_STAGE_BUFFER_SIZE (1024 * 1024)
+#define SPARSE_STAGE_BUFFER_ALIGN 64
+
 #endif
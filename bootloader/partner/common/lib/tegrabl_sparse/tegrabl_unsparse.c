@@ -15,6 +15,7 @@
 #include <tegrabl_sparse.h>
 #include <tegrabl_sparse_local.h>
 #include <tegrabl_debug.h>
+#include <tegrabl_malloc.h>
 
 tegrabl_error_t tegrabl_sparse_init_unsparse_state(
 		struct tegrabl_unsparse_state *unsparse_state,
@@ -129,6 +130,184 @@ static tegrabl_error_t tegrabl_sparse_validate_chunk_header(
 	return error;
 }
 
+/**
+ * @brief Makes sure the fill buffer holds the fill value for at least
+ * the given number of bytes. The heap buffer is allocated on first use and
+ * kept in unsparse state until the image is done, so fill chunks of the same
+ * value do not pattern it again. The local buffer is used if allocation
+ * fails.
+ *
+ * @param unsparse_state Handle of state maintained by unsparse machine.
+ * @param local Buffer of SPARSE_MAX_LOCAL_BUFFER bytes to fall back to.
+ * @param size Number of bytes which are to be written from buffer.
+ * @param buffer_size Updated with size of the buffer returned.
+ *
+ * @return Buffer holding the fill value.
+ */
+static const uint32_t *tegrabl_sparse_prepare_fill(
+		struct tegrabl_unsparse_state *unsparse_state, uint32_t *local,
+		uint64_t size, uint32_t *buffer_size)
+{
+	uint32_t fill_value = unsparse_state->fill_value;
+	uint32_t *buffer = NULL;
+	uint32_t valid = 0;
+	uint32_t i = 0;
+	uint32_t end = 0;
+
+	if (unsparse_state->fill_buffer == NULL) {
+		unsparse_state->fill_buffer = tegrabl_memalign(
+				SPARSE_FILL_BUFFER_ALIGN, SPARSE_FILL_BUFFER_SIZE);
+		unsparse_state->fill_valid = 0;
+	}
+
+	if (unsparse_state->fill_buffer != NULL) {
+		if (unsparse_state->fill_pattern != fill_value) {
+			unsparse_state->fill_pattern = fill_value;
+			unsparse_state->fill_valid = 0;
+		}
+		buffer = unsparse_state->fill_buffer;
+		valid = unsparse_state->fill_valid;
+		*buffer_size = SPARSE_FILL_BUFFER_SIZE;
+	} else {
+		pr_debug("Using local buffer for fill chunks\n");
+		buffer = local;
+		*buffer_size = SPARSE_MAX_LOCAL_BUFFER;
+	}
+
+	/* Only extend the pattern as far as needed; the buffer is re-used across
+	 * fill chunks with the same value.
+	 */
+	end = (uint32_t)MIN(size, (uint64_t)*buffer_size);
+	end = ROUND_UP(end, sizeof(uint32_t));
+	for (i = valid / sizeof(uint32_t); i < (end / sizeof(uint32_t)); i++) {
+		buffer[i] = fill_value;
+	}
+
+	if ((buffer == unsparse_state->fill_buffer) && (end > valid)) {
+		unsparse_state->fill_valid = end;
+	}
+
+	return buffer;
+}
+
+/**
+ * @brief Writes the RAW data gathered in stage buffer.
+ *
+ * @param unsparse_state Handle of state maintained by unsparse machine.
+ * @param aux_info Auxiliary information passed to writer.
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error.
+ */
+static tegrabl_error_t tegrabl_sparse_stage_flush(
+		struct tegrabl_unsparse_state *unsparse_state, void *aux_info)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+
+	if (unsparse_state->stage_len == 0) {
+		return TEGRABL_NO_ERROR;
+	}
+
+	error = unsparse_state->writer(unsparse_state->stage_buffer,
+			unsparse_state->stage_len, aux_info);
+	if (error != TEGRABL_NO_ERROR) {
+		pr_debug("Failed to write unsparse image\n");
+		TEGRABL_SET_HIGHEST_MODULE(error);
+	}
+	unsparse_state->stage_len = 0;
+
+	return error;
+}
+
+/**
+ * @brief Frees the stage and fill buffers. Data still gathered in stage
+ * buffer is dropped.
+ *
+ * @param unsparse_state Handle of state maintained by unsparse machine.
+ */
+static void tegrabl_sparse_free_buffers(
+		struct tegrabl_unsparse_state *unsparse_state)
+{
+	if (unsparse_state->stage_buffer != NULL) {
+		tegrabl_free(unsparse_state->stage_buffer);
+		unsparse_state->stage_buffer = NULL;
+	}
+	unsparse_state->stage_len = 0;
+
+	if (unsparse_state->fill_buffer != NULL) {
+		tegrabl_free(unsparse_state->fill_buffer);
+		unsparse_state->fill_buffer = NULL;
+	}
+	unsparse_state->fill_valid = 0;
+}
+
+/**
+ * @brief Writes RAW chunk data. Data is gathered in the stage buffer and
+ * written once the buffer is full, except for aligned data which is written
+ * directly in multiples of the stage buffer size.
+ *
+ * @param unsparse_state Handle of state maintained by unsparse machine.
+ * @param buffer RAW data.
+ * @param size Size of the data.
+ * @param aux_info Auxiliary information passed to writer.
+ *
+ * @return TEGRABL_NO_ERROR if successful else appropriate error.
+ */
+static tegrabl_error_t tegrabl_sparse_stage_write(
+		struct tegrabl_unsparse_state *unsparse_state, const uint8_t *buffer,
+		uint64_t size, void *aux_info)
+{
+	tegrabl_error_t error = TEGRABL_NO_ERROR;
+	uint64_t bytes = 0;
+
+	if (unsparse_state->stage_buffer == NULL) {
+		unsparse_state->stage_buffer = tegrabl_memalign(
+				SPARSE_STAGE_BUFFER_ALIGN, SPARSE_STAGE_BUFFER_SIZE);
+		unsparse_state->stage_len = 0;
+	}
+
+	/* Without stage buffer, write as received. */
+	if (unsparse_state->stage_buffer == NULL) {
+		error = unsparse_state->writer(buffer, size, aux_info);
+		if (error != TEGRABL_NO_ERROR) {
+			pr_debug("Failed to write unsparse image\n");
+			TEGRABL_SET_HIGHEST_MODULE(error);
+		}
+		return error;
+	}
+
+	while (size) {
+		if ((unsparse_state->stage_len == 0) &&
+			(size >= SPARSE_STAGE_BUFFER_SIZE) &&
+			(((uintptr_t)buffer % SPARSE_STAGE_BUFFER_ALIGN) == 0)) {
+			bytes = ROUND_DOWN(size, (uint64_t)SPARSE_STAGE_BUFFER_SIZE);
+			error = unsparse_state->writer(buffer, bytes, aux_info);
+			if (error != TEGRABL_NO_ERROR) {
+				pr_debug("Failed to write unsparse image\n");
+				TEGRABL_SET_HIGHEST_MODULE(error);
+				return error;
+			}
+		} else {
+			bytes = MIN(size,
+					SPARSE_STAGE_BUFFER_SIZE - unsparse_state->stage_len);
+			memcpy(unsparse_state->stage_buffer + unsparse_state->stage_len,
+					buffer, bytes);
+			unsparse_state->stage_len += bytes;
+
+			if (unsparse_state->stage_len == SPARSE_STAGE_BUFFER_SIZE) {
+				error = tegrabl_sparse_stage_flush(unsparse_state, aux_info);
+				if (error != TEGRABL_NO_ERROR) {
+					return error;
+				}
+			}
+		}
+
+		buffer += bytes;
+		size -= bytes;
+	}
+
+	return error;
+}
+
 tegrabl_error_t tegrabl_sparse_unsparse(
 		struct tegrabl_unsparse_state *unsparse_state,
 		const void *buff, uint64_t length, void *aux_info)
@@ -137,8 +316,9 @@ tegrabl_error_t tegrabl_sparse_unsparse(
 	uint64_t size = 0;
 	uint64_t remaining = 0;
 	uint64_t offset = 0;
-	uint32_t i = 0;
-	uint32_t buffer[SPARSE_MAX_LOCAL_BUFFER / sizeof(uint32_t)];
+	uint32_t fill_local[SPARSE_MAX_LOCAL_BUFFER / sizeof(uint32_t)];
+	const uint32_t *fill_buffer = NULL;
+	uint32_t fill_buffer_size = 0;
 	const uint8_t *sparse_buffer = (const uint8_t *)buff;
 	uint8_t *tmp_buff = NULL;
 	struct tegrabl_sparse_image_header *image_header = NULL;
@@ -249,10 +429,9 @@ tegrabl_error_t tegrabl_sparse_unsparse(
 
 		case TEGRABL_UNSPARSE_PARTIAL_CHUNK_RAW:
 			size = MIN(length, remaining);
-			error = unsparse_state->writer(sparse_buffer, size, aux_info);
+			error = tegrabl_sparse_stage_write(unsparse_state, sparse_buffer,
+					size, aux_info);
 			if (error != TEGRABL_NO_ERROR) {
-				pr_debug("Failed to write unsparse image\n");
-				TEGRABL_SET_HIGHEST_MODULE(error);
 				goto fail;
 			}
 #ifdef TEGRABL_CONFIG_ENABLE_SPARSE_CRC32
@@ -289,20 +468,23 @@ tegrabl_error_t tegrabl_sparse_unsparse(
 				}
 			}
 
-			buffer[0] = unsparse_state->fill_value;
-			for (i = 1; i < ARRAY_SIZE(buffer); i++) {
-				buffer[i] = buffer[0];
+			error = tegrabl_sparse_stage_flush(unsparse_state, aux_info);
+			if (error != TEGRABL_NO_ERROR) {
+				goto fail;
 			}
 
+			fill_buffer = tegrabl_sparse_prepare_fill(unsparse_state,
+					fill_local, remaining, &fill_buffer_size);
+
 			while (remaining) {
-				size = MIN(remaining, SPARSE_MAX_LOCAL_BUFFER);
+				size = MIN(remaining, fill_buffer_size);
 				remaining -= size;
 
 #ifdef TEGRABL_CONFIG_ENABLE_SPARSE_CRC32
 				computed_crc = tegrabl_utils_crc32(computed_crc,
-						(void *)buffer, size);
+						(void *)fill_buffer, size);
 #endif
-				error = unsparse_state->writer(buffer, size, aux_info);
+				error = unsparse_state->writer(fill_buffer, size, aux_info);
 				if (error != TEGRABL_NO_ERROR) {
 					pr_debug("Failed to write unsparse image\n");
 					TEGRABL_SET_HIGHEST_MODULE(error);
@@ -317,6 +499,11 @@ tegrabl_error_t tegrabl_sparse_unsparse(
 			break;
 
 		case TEGRABL_UNSPARSE_PARTIAL_CHUNK_DONT_CARE:
+			error = tegrabl_sparse_stage_flush(unsparse_state, aux_info);
+			if (error != TEGRABL_NO_ERROR) {
+				goto fail;
+			}
+
 			error = unsparse_state->seeker(remaining, aux_info);
 			if (error != TEGRABL_NO_ERROR) {
 				pr_debug("Failed to seek to new location while unsparsing\n");
@@ -374,7 +561,36 @@ tegrabl_error_t tegrabl_sparse_unsparse(
 	unsparse_state->computed_crc = computed_crc;
 #endif
 
+	/* Write out what is gathered once the last chunk is done. */
+	if (tegrabl_sparse_unsparse_is_complete(unsparse_state)) {
+		error = tegrabl_sparse_stage_flush(unsparse_state, aux_info);
+		tegrabl_sparse_free_buffers(unsparse_state);
+	}
+
 fail:
+	if ((error != TEGRABL_NO_ERROR) && (unsparse_state != NULL)) {
+		tegrabl_sparse_free_buffers(unsparse_state);
+	}
 	return error;
 }
 
+bool tegrabl_sparse_unsparse_is_complete(
+		const struct tegrabl_unsparse_state *unsparse_state)
+{
+	if (unsparse_state == NULL) {
+		return false;
+	}
+
+	return (unsparse_state->state == TEGRABL_UNSPARSE_PARTIAL_CHUNK_HEADER) &&
+		(unsparse_state->offset == 0) &&
+		(unsparse_state->chunks_processed ==
+			unsparse_state->image_header.total_chunks);
+}
+
+void tegrabl_sparse_abort_unsparse(
+		struct tegrabl_unsparse_state *unsparse_state)
+{
+	if (unsparse_state != NULL) {
+		tegrabl_sparse_free_buffers(unsparse_state);
+	}
+}
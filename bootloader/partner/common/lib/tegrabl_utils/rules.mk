@@ -19,5 +19,12 @@ GLOBAL_INCLUDES += \
 MODULE_SRCS += \
 	$(LOCAL_DIR)/tegrabl_utils.c
 
+# CRC32 instructions are optional in ARMv8.0, crc32 uses them only if the
+# platform says its CPUs have them
+ifeq ($(CONFIG_ENABLE_HW_CRC32), yes)
+MODULE_COMPILEFLAGS += -march=armv8-a+crc
+MODULE_DEFINES += CONFIG_ENABLE_HW_CRC32=1
+endif
+
 include make/module.mk
 
@@ -12,6 +12,12 @@
 #include <tegrabl_utils.h>
 #include <stdbool.h>
 #include <tegrabl_debug.h>
+#include <string.h>
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#elif defined(CONFIG_ENABLE_HW_CRC32)
+#error "CONFIG_ENABLE_HW_CRC32 needs a compiler targeting the CRC32 extension"
+#endif
 
 /**
  * Pre calculated modulo 2 division remainder for 256 bytes combination
@@ -62,10 +68,240 @@ static uint32_t tegrabl_crc32_tab[] = {
     0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
 };
 
+/* CRC32 polynomial in reflected form, as used by the table */
+#define CRC32_POLY_REFLECTED 0xedb88320U
+
+/**
+ * @brief Multiplies a 32 bit vector by a 32x32 matrix over GF(2).
+ */
+static uint32_t crc32_gf2_matrix_times(const uint32_t *mat, uint32_t vec)
+{
+	uint32_t sum = 0;
+
+	while (vec != 0U) {
+		if ((vec & 1U) != 0U) {
+			sum ^= *mat;
+		}
+		vec >>= 1;
+		mat++;
+	}
+
+	return sum;
+}
+
+/**
+ * @brief Squares a 32x32 matrix over GF(2).
+ */
+static void crc32_gf2_matrix_square(uint32_t *square, const uint32_t *mat)
+{
+	uint32_t n;
+
+	for (n = 0; n < 32U; n++) {
+		square[n] = crc32_gf2_matrix_times(mat, mat[n]);
+	}
+}
+
+/**
+ * @brief Fills the operator which feeds one zero byte to a crc register.
+ */
+static void crc32_zero_byte_op(uint32_t *op)
+{
+	uint32_t odd[32];
+	uint32_t even[32];
+	uint32_t row = 1;
+	uint32_t n;
+
+	/* Operator for one zero bit */
+	odd[0] = CRC32_POLY_REFLECTED;
+	for (n = 1; n < 32U; n++) {
+		odd[n] = row;
+		row <<= 1;
+	}
+
+	crc32_gf2_matrix_square(even, odd);		/* 2 bits */
+	crc32_gf2_matrix_square(odd, even);		/* 4 bits */
+	crc32_gf2_matrix_square(op, odd);		/* 8 bits */
+}
+
+uint32_t tegrabl_utils_crc32_combine(uint32_t crc1, uint32_t crc2, size_t len2)
+{
+	uint32_t even[32];
+	uint32_t odd[32];
+
+	if (len2 == 0U) {
+		return crc1;
+	}
+
+	/* Feed len2 zero bytes to crc1 by squaring the operator for each bit of
+	 * len2, the pre and post conditioning of both crcs cancel out */
+	crc32_zero_byte_op(even);
+	while (true) {
+		if ((len2 & 1U) != 0U) {
+			crc1 = crc32_gf2_matrix_times(even, crc1);
+		}
+		len2 >>= 1;
+		if (len2 == 0U) {
+			break;
+		}
+
+		crc32_gf2_matrix_square(odd, even);
+		if ((len2 & 1U) != 0U) {
+			crc1 = crc32_gf2_matrix_times(odd, crc1);
+		}
+		len2 >>= 1;
+		if (len2 == 0U) {
+			break;
+		}
+
+		crc32_gf2_matrix_square(even, odd);
+	}
+
+	return crc1 ^ crc2;
+}
+
+#if defined(__ARM_FEATURE_CRC32)
+/* Bytes per lane, 3 lanes keep the CRC32 unit busy as each instruction has
+ * a latency of about 3 cycles. Must be a power of 2. */
+#define CRC32_LANE_SIZE 4096U
+#define CRC32_LANE_SIZE_LOG2 12U
+
+static uint32_t crc32_lane_op[32];
+static bool crc32_lane_op_ready;
+
+/**
+ * @brief Returns the operator which feeds CRC32_LANE_SIZE zero bytes to a
+ * crc register, computing it on first use.
+ */
+static const uint32_t *crc32_get_lane_op(void)
+{
+	uint32_t op[32];
+	uint32_t tmp[32];
+	uint32_t i;
+
+	if (__atomic_load_n(&crc32_lane_op_ready, __ATOMIC_ACQUIRE)) {
+		return crc32_lane_op;
+	}
+
+	crc32_zero_byte_op(op);
+	for (i = 0; i < CRC32_LANE_SIZE_LOG2; i++) {
+		crc32_gf2_matrix_square(tmp, op);
+		memcpy(op, tmp, sizeof(op));
+	}
+
+	/* May be computed by more than one CPU at once, they all store the same
+	 * values */
+	memcpy(crc32_lane_op, op, sizeof(op));
+	__atomic_store_n(&crc32_lane_op_ready, true, __ATOMIC_RELEASE);
+
+	return crc32_lane_op;
+}
+#elif (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define CRC32_SLICE_BY_8
+
+/* tegrabl_crc32_slice_tab[k][n] is the crc of byte n followed by k zero
+ * bytes, so that 8 bytes are looked up at once */
+static uint32_t tegrabl_crc32_slice_tab[8][256];
+static bool crc32_slice_tab_ready;
+
+static void crc32_init_slice_tab(void)
+{
+	uint32_t crc;
+	uint32_t n;
+	uint32_t k;
+
+	if (__atomic_load_n(&crc32_slice_tab_ready, __ATOMIC_ACQUIRE)) {
+		return;
+	}
+
+	/* May be done by more than one CPU at once, they all store the same
+	 * values */
+	for (n = 0; n < 256U; n++) {
+		crc = tegrabl_crc32_tab[n];
+		tegrabl_crc32_slice_tab[0][n] = crc;
+		for (k = 1; k < 8U; k++) {
+			crc = tegrabl_crc32_tab[crc & 0xFFU] ^ (crc >> 8);
+			tegrabl_crc32_slice_tab[k][n] = crc;
+		}
+	}
+
+	__atomic_store_n(&crc32_slice_tab_ready, true, __ATOMIC_RELEASE);
+}
+#endif
+
 uint32_t tegrabl_utils_crc32(uint32_t val, void *buffer, size_t buffer_size)
 {
 	uint32_t final_crc = val ^ ~0U;
 	uint8_t *buf = (uint8_t *) buffer;
+#if defined(__ARM_FEATURE_CRC32)
+	const uint32_t *lane_op;
+	uint64_t word;
+	uint64_t word1;
+	uint64_t word2;
+	uint32_t crc1;
+	uint32_t crc2;
+	uint32_t i;
+
+	/* ARMv8 CRC32 instructions use the same reflected polynomial as the
+	 * table, 8 bytes are consumed per instruction once buf is aligned */
+	while ((buffer_size != 0U) && (((uintptr_t)buf & 7U) != 0U)) {
+		final_crc = __crc32b(final_crc, *buf);
+		buf++;
+		buffer_size--;
+	}
+
+	/* Large buffers are done as 3 independent lanes which are merged by
+	 * shifting the crc of each lane over the length of the next one */
+	if (buffer_size >= (3U * CRC32_LANE_SIZE)) {
+		lane_op = crc32_get_lane_op();
+	}
+
+	while (buffer_size >= (3U * CRC32_LANE_SIZE)) {
+		crc1 = 0;
+		crc2 = 0;
+		for (i = 0; i < CRC32_LANE_SIZE; i += sizeof(word)) {
+			memcpy(&word, buf + i, sizeof(word));
+			memcpy(&word1, buf + CRC32_LANE_SIZE + i, sizeof(word1));
+			memcpy(&word2, buf + (2U * CRC32_LANE_SIZE) + i, sizeof(word2));
+			final_crc = __crc32d(final_crc, word);
+			crc1 = __crc32d(crc1, word1);
+			crc2 = __crc32d(crc2, word2);
+		}
+		final_crc = crc32_gf2_matrix_times(lane_op, final_crc) ^ crc1;
+		final_crc = crc32_gf2_matrix_times(lane_op, final_crc) ^ crc2;
+		buf += 3U * CRC32_LANE_SIZE;
+		buffer_size -= 3U * CRC32_LANE_SIZE;
+	}
+
+	while (buffer_size >= sizeof(word)) {
+		memcpy(&word, buf, sizeof(word));
+		final_crc = __crc32d(final_crc, word);
+		buf += sizeof(word);
+		buffer_size -= sizeof(word);
+	}
+#elif defined(CRC32_SLICE_BY_8)
+	uint32_t lo;
+	uint32_t hi;
+
+	if (buffer_size >= 64U) {
+		crc32_init_slice_tab();
+
+		while (buffer_size >= 8U) {
+			memcpy(&lo, buf, sizeof(lo));
+			memcpy(&hi, buf + 4, sizeof(hi));
+			lo ^= final_crc;
+			final_crc = tegrabl_crc32_slice_tab[7][lo & 0xFFU] ^
+						tegrabl_crc32_slice_tab[6][(lo >> 8) & 0xFFU] ^
+						tegrabl_crc32_slice_tab[5][(lo >> 16) & 0xFFU] ^
+						tegrabl_crc32_slice_tab[4][lo >> 24] ^
+						tegrabl_crc32_slice_tab[3][hi & 0xFFU] ^
+						tegrabl_crc32_slice_tab[2][(hi >> 8) & 0xFFU] ^
+						tegrabl_crc32_slice_tab[1][(hi >> 16) & 0xFFU] ^
+						tegrabl_crc32_slice_tab[0][hi >> 24];
+			buf += 8;
+			buffer_size -= 8U;
+		}
+	}
+#endif
 
 	while (buffer_size != 0U) {
 		final_crc = (tegrabl_crc32_tab[(final_crc ^ *buf) & 0xFFU] ^
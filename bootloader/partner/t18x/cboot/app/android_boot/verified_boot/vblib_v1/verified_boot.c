@@ -35,6 +35,9 @@
 #include <tegrabl_fuse.h>
 #include <libfdt.h>
 #include <nvboot_crypto_param.h>
+#if defined(CONFIG_ENABLE_BOOTIMG_STREAM_HASH)
+#include <tegrabl_partition_loader.h>
+#endif
 
 #define DIV_ROUND_UP(n, d) (((n) + (d) - 1) / (d))
 
@@ -44,9 +47,12 @@
 /* r = 2^4096, big endian, hard coded*/
 static uint8_t _r[513] = {0x01};
 
-static status_t hash_payload_authattr(uintptr_t payload, size_t payload_size,
-									  uintptr_t authaddr, size_t auth_size,
-									  uint8_t *output)
+/* Hashes payload and auth_attr joined in one buffer, for when the SE
+ * cannot stream */
+static status_t hash_payload_authattr_joined(uintptr_t payload,
+											 size_t payload_size,
+											 uintptr_t authaddr,
+											 size_t auth_size, uint8_t *output)
 {
 	struct se_sha_input_params sha_input;
 	struct se_sha_context sha_context;
@@ -54,9 +60,6 @@ static status_t hash_payload_authattr(uintptr_t payload, size_t payload_size,
 	uint8_t *buf_payload_auth = NULL;
 	size_t size;
 
-	if (!payload || !authaddr || !output)
-		return ERR_INVALID_ARGS;
-
 	size = payload_size + auth_size;
 	buf_payload_auth = malloc(size);
 	if (buf_payload_auth == NULL) {
@@ -68,10 +71,6 @@ static status_t hash_payload_authattr(uintptr_t payload, size_t payload_size,
 	memcpy((void *)(buf_payload_auth + payload_size), (const void *)authaddr,
 		   auth_size);
 
-	/* TODO:
-	 * Calculate the hash in one go when SE bug is fixed
-	 * Tracked in Bug 200199108
-	 * */
 	sha_context.input_size = (uint32_t)size;
 	sha_context.hash_algorithm = SE_SHAMODE_SHA256;
 	sha_input.block_addr = (uintptr_t)buf_payload_auth;
@@ -81,10 +80,57 @@ static status_t hash_payload_authattr(uintptr_t payload, size_t payload_size,
 
 	ret = tegrabl_se_sha_process_payload(&sha_input, &sha_context);
 
+	free(buf_payload_auth);
+
+	if (ret != TEGRABL_NO_ERROR)
+		return ERR_GENERIC;
+
+	return NO_ERROR;
+}
+
+static status_t hash_payload_authattr(uintptr_t payload, size_t payload_size,
+									  uintptr_t authaddr, size_t auth_size,
+									  uint8_t *output)
+{
+	struct se_sha_extent extents[2];
+	tegrabl_error_t ret = TEGRABL_NO_ERROR;
+#if defined(CONFIG_ENABLE_BOOTIMG_STREAM_HASH)
+	struct se_sha_stream *loaded;
+	struct se_sha_stream stream;
+#endif
+
+	if (!payload || !authaddr || !output)
+		return ERR_INVALID_ARGS;
+
+#if defined(CONFIG_ENABLE_BOOTIMG_STREAM_HASH)
+	/* Payload was hashed while loading, only auth_attr is left */
+	loaded = tegrabl_loader_get_kernel_sha_stream((void *)payload,
+												  payload_size);
+	if (loaded != NULL) {
+		stream = *loaded;
+		ret = tegrabl_se_sha_stream_update(&stream, authaddr,
+										   (uint32_t)auth_size, true);
+		if (ret == TEGRABL_NO_ERROR) {
+			memcpy(output, stream.digest, HASH_SZ);
+			return NO_ERROR;
+		}
+		pr_info("Failed to complete loader hash, rehashing payload\n");
+	}
+#endif
+
+	extents[0].addr = payload;
+	extents[0].size = (uint32_t)payload_size;
+	extents[1].addr = authaddr;
+	extents[1].size = (uint32_t)auth_size;
+
+	ret = tegrabl_se_sha_process_extents(extents, ARRAY_SIZE(extents),
+										 SE_SHAMODE_SHA256, output);
+	if (TEGRABL_ERROR_REASON(ret) == TEGRABL_ERR_NOT_SUPPORTED)
+		return hash_payload_authattr_joined(payload, payload_size, authaddr,
+											auth_size, output);
 	if (ret != TEGRABL_NO_ERROR)
 		return ERR_GENERIC;
 
-	free(buf_payload_auth);
 	return NO_ERROR;
 }
 
@@ -30,6 +30,7 @@
 #include <tegrabl_exit.h>
 #include <tegrabl_cache.h>
 #include <tegrabl_linuxboot_helper.h>
+#include <tegrabl_partition_loader.h>
 #include <libfdt.h>
 #include <libavb/libavb.h>
 
@@ -51,6 +52,45 @@ static inline AvbIOResult is_device_unlocked(AvbOps *ops, bool *is_unlocked)
 
 static void *boot_img_laddr;
 static void *kernel_dtb_laddr;
+
+#if defined(CONFIG_ENABLE_PRELOADED_PARTITIONS)
+/*
+ * Partition images already read by the loader are hashed in place, rather
+ * than read from storage again into a buffer of libavb.
+ */
+static AvbIOResult get_preloaded_partition(AvbOps *ops, const char *partition,
+										   size_t num_bytes,
+										   uint8_t **out_pointer,
+										   size_t *out_num_bytes_preloaded)
+{
+	const struct tegrabl_fastboot_partition_info *part_info = NULL;
+	const char *tegra_part_name = NULL;
+	const char *suffix = NULL;
+	uint64_t size = 0;
+	void *image;
+
+	TEGRABL_UNUSED(ops);
+
+	*out_pointer = NULL;
+	*out_num_bytes_preloaded = 0;
+
+	suffix = tegrabl_a_b_get_part_suffix(partition);
+	part_info = tegrabl_fastboot_get_partinfo(partition);
+	tegra_part_name = tegrabl_fastboot_get_tegra_part_name(suffix, part_info);
+
+	/* libavb reads the partition itself unless all of it is here */
+	image = tegrabl_loader_get_preloaded(tegra_part_name, &size);
+	if ((image == NULL) || (size < num_bytes))
+		return AVB_IO_RESULT_OK;
+
+	pr_debug("%s: %s in memory @ %p\n", __func__, tegra_part_name, image);
+	*out_pointer = image;
+	*out_num_bytes_preloaded = num_bytes;
+
+	return AVB_IO_RESULT_OK;
+}
+#endif
+
 static AvbIOResult read_from_partition(AvbOps *ops, const char *partition,
 									   int64_t offset, size_t num_bytes,
 									   void *buffer, size_t *out_num_read)
@@ -61,6 +101,10 @@ static AvbIOResult read_from_partition(AvbOps *ops, const char *partition,
 	const char *tegra_part_name = NULL;
 	const struct tegrabl_fastboot_partition_info *part_info = NULL;
 	const char *suffix = NULL;
+#if defined(CONFIG_ENABLE_PRELOADED_PARTITIONS)
+	uint64_t image_size = 0;
+	uint8_t *image;
+#endif
 
 	TEGRABL_UNUSED(ops);
 
@@ -68,6 +112,16 @@ static AvbIOResult read_from_partition(AvbOps *ops, const char *partition,
 	part_info = tegrabl_fastboot_get_partinfo(partition);
 	tegra_part_name = tegrabl_fastboot_get_tegra_part_name(suffix, part_info);
 
+#if defined(CONFIG_ENABLE_PRELOADED_PARTITIONS)
+	/* Anything within an image the loader has read comes from memory */
+	image = tegrabl_loader_get_preloaded(tegra_part_name, &image_size);
+	if ((image != NULL) && (offset >= 0) &&
+		((uint64_t)offset + num_bytes <= image_size)) {
+		memcpy(buffer, image + offset, num_bytes);
+		goto done;
+	}
+#endif
+
 	/* boot.img and kernel-dtb is already in memory, direct copy to improve
 	 * performance */
 	if (!strcmp(part_info->fastboot_part_name, "boot") && (offset == 0)) {
@@ -258,7 +312,11 @@ status_t verified_boot_get_boot_state(boot_state_t *bs,
 #endif
 
 	/* Use libavb API to verify the boot */
+	memset(&ops, 0, sizeof(ops));
 	ops.read_from_partition = read_from_partition;
+#if defined(CONFIG_ENABLE_PRELOADED_PARTITIONS)
+	ops.get_preloaded_partition = get_preloaded_partition;
+#endif
 	ops.read_is_device_unlocked = is_device_unlocked;
 	ops.hash_salt_image = hash_salt_image;
 	ops.validate_vbmeta_public_key = validate_vbmeta_public_key;
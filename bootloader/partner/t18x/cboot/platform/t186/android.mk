@@ -21,6 +21,10 @@ GLOBAL_DEFINES += \
 	CONFIG_OS_IS_ANDROID=1 \
 	CONFIG_ENABLE_NCT=1 \
 	CONFIG_ENABLE_VERIFIED_BOOT=1 \
+	CONFIG_ENABLE_BOOTIMG_STREAM_HASH=1 \
+	CONFIG_ENABLE_KERNEL_STREAM_DECOMPRESS=1 \
+	CONFIG_ENABLE_BOOTIMG_SCATTER_LOAD=1 \
+	CONFIG_ENABLE_PRELOADED_PARTITIONS=1 \
 	CONFIG_ENABLE_DISPLAY=1 \
 	CONFIG_ENABLE_DP=1 \
 	CONFIG_INITIALIZE_DISPLAY=1 \
@@ -32,3 +36,5 @@ GLOBAL_DEFINES += \
 	CONFIG_FORCE_FASTBOOT_BOOT=1 \
 	CONFIG_PROFILER_RECORD_LEVEL=PROFILER_RECORD_MINIMAL
 # CONFIG_INITIALIZE_DISPLAY: 0-DSI, 1-HDMI, 2-DP, 3-EDP
+# CONFIG_ENABLE_RAMDISK_DECOMPRESS=1 unpacks compressed ramdisks in bootloader
+# rather than leaving it to the kernel
@@ -15,6 +15,8 @@ MODULE_DEPS += \
 GLOBAL_DEFINES += \
 	CONFIG_OS_IS_L4T=1 \
 	CONFIG_ENABLE_SATA=1 \
+	CONFIG_ENABLE_SATA_NCQ=1 \
+	CONFIG_ENABLE_KERNEL_STREAM_DECOMPRESS=1 \
 	CONFIG_ENABLE_DP=1 \
 	CONFIG_ENABLE_DISPLAY=1 \
 	CONFIG_ENABLE_SECURE_BOOT=1 \
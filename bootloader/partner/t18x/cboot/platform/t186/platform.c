@@ -73,6 +73,10 @@
 #include <tegrabl_gpcdma.h>
 #include <tegrabl_storage.h>
 #include <ratchet_update.h>
+#if defined(CONFIG_ENABLE_CPU_WORKERS)
+#include <tegrabl_armv8a.h>
+#include <tegrabl_cpu_workers.h>
+#endif
 #if defined(CONFIG_ENABLE_XUSBH)
 #include <tegrabl_usbh.h>
 #include <fastboot.h>
@@ -344,8 +348,38 @@ static void platform_disable_clocks(void)
 #endif
 }
 
+#if defined(CONFIG_ENABLE_CPU_WORKERS)
+static void platform_init_cpu_workers(void)
+{
+	uint64_t mpidr[MAX_CPUS_PER_CLUSTER];
+	uint64_t self;
+	uint32_t count = 0;
+	uint32_t cpu;
+
+	/* Use the other CPUs of the boot cluster */
+	self = tegrabl_read_mpidr() & 0xFFFFFFULL;
+	for (cpu = 0; cpu < MAX_CPUS_PER_CLUSTER; cpu++) {
+		if ((self & 0xFFULL) == cpu)
+			continue;
+		mpidr[count++] = (self & ~0xFFULL) | cpu;
+	}
+
+	if (tegrabl_cpu_workers_start(mpidr, count) != TEGRABL_NO_ERROR)
+		pr_warn("Continuing without CPU workers\n");
+
+	tegrabl_profiler_record("CPU workers", 0, DETAILED);
+}
+#endif
+
 void platform_uninit(void)
 {
+#if defined(CONFIG_ENABLE_CPU_WORKERS)
+	/* Workers run with the MMU setup which is about to go away */
+	tegrabl_cpu_workers_stop();
+#endif
+
+	tegrabl_blockdev_export_kpi();
+
 #if defined(CONFIG_ENABLE_WDT)
 	/* disable cpu-wdt before kernel handoff */
 	tegrabl_wdt_disable(TEGRABL_WDT_LCCPLEX);
@@ -426,6 +460,10 @@ void platform_init(void)
 	if (err != TEGRABL_NO_ERROR)
 		goto fail;
 
+#if defined(CONFIG_ENABLE_CPU_WORKERS)
+	platform_init_cpu_workers();
+#endif
+
 	tegrabl_blockdev_init();
 
 	/* Get boot device */
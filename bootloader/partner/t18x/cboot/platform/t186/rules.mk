@@ -15,6 +15,9 @@ MODULE := $(LOCAL_DIR)
 ARCH := arm64
 ARM64_CPU := cortex-a57
 
+# Both Denver and A57 implement the ARMv8 CRC32 instructions
+CONFIG_ENABLE_HW_CRC32 := yes
+
 MODULE_DEPS += \
 	platform/tegra_shared \
 	lib/menu \
@@ -32,6 +35,7 @@ MODULE_DEPS += \
 	$(LOCAL_DIR)/../../../common/soc/$(TARGET)/misc \
 	$(LOCAL_DIR)/../../../common/drivers/soc/$(TARGET)/power \
 	$(LOCAL_DIR)/../../../common/lib/mce \
+	$(LOCAL_DIR)/../../../common/lib/cpu_workers \
 	$(LOCAL_DIR)/../../../common/lib/rollback_prevention \
 	$(LOCAL_DIR)/../../../common/lib/tegrabl_auth \
 	$(LOCAL_DIR)/../../../common/lib/tegrabl_se_keystore \
@@ -81,6 +85,8 @@ GLOBAL_DEFINES += \
 	CONFIG_ENABLE_PARTITION_MANAGER=1 \
 	CONFIG_ENABLE_EMMC=1 \
 	CONFIG_ENABLE_SDMMC_64_BIT_SUPPORT=1 \
+	CONFIG_ENABLE_SDMMC_ADMA2=1 \
+	CONFIG_ENABLE_BLOCKDEV_CACHE=1 \
 	CONFIG_ENABLE_QSPI=1 \
 	CONFIG_ENABLE_UFS=1 \
 	CONFIG_ENABLE_UFS_HS_MODE=1 \
@@ -107,6 +113,8 @@ GLOBAL_DEFINES += \
 	CONFIG_ENABLE_XUSBF_SS=1 \
 	CONFIG_BOOT_PROFILER=1 \
 	CONFIG_ENABLE_DRAM_ECC=1
+# CONFIG_ENABLE_CPU_WORKERS=1 brings up the other CPUs of the boot cluster to
+# decode multi-block compressed images in parallel
 
 # Move optional CONFIG items into sub-make files
 ifeq ($(NV_BUILD_SYSTEM_TYPE),l4t)
@@ -31,6 +31,10 @@
 
 #define SUBKEY_CACHE_SIZE 2
 #define SHA_INPUT_BLOCK_SZ (8 * 1024 * 1024)
+/* Outcome of se_sha_stream_self_test() of a SHA mode */
+#define SE_SHA_STREAM_UNTESTED 0U
+#define SE_SHA_STREAM_OK 1U
+#define SE_SHA_STREAM_BROKEN 2U
 #define TEGRABL_CRYPTO_SHA_MIN_BUF_SIZE 64
 #define SE_SHA_MAX_INPUT_SIZE	(ROUND_DOWN_POW2( \
 			SE0_SHA_OUT_ADDR_HI_0_SZ_FIELD, \
@@ -54,6 +58,34 @@ struct tegrabl_se_aes_subkey_cache {
 
 static struct tegrabl_se_aes_subkey_cache aes_subkeys[SUBKEY_CACHE_SIZE];
 
+/* SHA block which has been handed to the engine */
+struct se_sha_op {
+	uintptr_t block_addr;
+	uint32_t block_size;
+	uintptr_t hash_addr;
+	uint32_t hash_size;
+	uint32_t *hash_state;
+};
+
+/*
+ * Ring of submitted SHA jobs, processed in order. Only the job at head can
+ * have a block in flight, and SE0 mutex is held for as long as it does.
+ */
+static struct {
+	struct se_sha_job *jobs[SE_SHA_JOB_QUEUE_SIZE];
+	uint32_t head;
+	uint32_t count;
+	struct se_sha_op op;
+	uint32_t op_size;
+	bool in_flight;
+} se_jobs;
+
+/* Result of the stream self-test for each SHA mode, and its buffers */
+static uint8_t se_sha_stream_status[SE_MODE_PKT_SHAMODE_SHA512 + 1];
+static uint8_t se_sha_test_msg[(2 * SE_SHA_MAX_BLOCK_SIZE) + 8]
+	TEGRABL_ALIGN(64);
+static uint8_t se_sha_test_digest[SE_SHA_MAX_DIGEST_SIZE] TEGRABL_ALIGN(64);
+
 /* Reads SE0 register */
 static uint32_t tegrabl_get_se0_reg(uint32_t reg)
 {
@@ -66,8 +98,10 @@ static void tegrabl_set_se0_reg(uint32_t reg, uint32_t data)
 	NV_WRITE32(NV_ADDRESS_MAP_SE0_BASE + reg, data);
 }
 
+static void se_jobs_drain(void);
+
 /* Acquire SE0 h/w mutex */
-static void tegrabl_get_se0_mutex(void)
+static void se0_mutex_lock(void)
 {
 	uint32_t se_config_reg;
 	uint32_t status = SE0_MUTEX_REQUEST_RELEASE_0_RESET_VAL;
@@ -78,6 +112,13 @@ static void tegrabl_get_se0_mutex(void)
 	}
 }
 
+/* Acquire SE0 h/w mutex for direct use, once queued jobs are done */
+static void tegrabl_get_se0_mutex(void)
+{
+	se_jobs_drain();
+	se0_mutex_lock();
+}
+
 /* Release SE0 h/w mutex */
 static void tegrabl_release_se0_mutex(void)
 {
@@ -366,12 +407,65 @@ fail:
 	return err;
 }
 
-static tegrabl_error_t _tegrabl_se_sha_process_block(
+/* Returns digest size in bytes, or 0 for an unknown SHA mode */
+static uint32_t se_sha_digest_size(uint8_t hash_algorithm)
+{
+	switch (hash_algorithm) {
+	case SE_MODE_PKT_SHAMODE_SHA1:
+		return ARSE_SHA1_HASH_SIZE / 8;
+	case SE_MODE_PKT_SHAMODE_SHA224:
+		return ARSE_SHA224_HASH_SIZE / 8;
+	case SE_MODE_PKT_SHAMODE_SHA256:
+		return ARSE_SHA256_HASH_SIZE / 8;
+	case SE_MODE_PKT_SHAMODE_SHA384:
+		return ARSE_SHA384_HASH_SIZE / 8;
+	case SE_MODE_PKT_SHAMODE_SHA512:
+		return ARSE_SHA512_HASH_SIZE / 8;
+	default:
+		return 0;
+	}
+}
+
+/*
+ * Complete a block started by se_sha_block_start() once the engine is no
+ * longer busy. SE0 mutex is left to the caller to release.
+ */
+static void se_sha_block_finish(struct se_sha_op *op)
+{
+	uint32_t i;
+
+	if (op->hash_state != NULL) {
+		for (i = 0; i < SE_SHA_STATE_WORDS; i++)
+			op->hash_state[i] =
+				tegrabl_get_se0_reg(SE0_SHA_HASH_RESULT_0 + (i * 4));
+	}
+
+	/* Unmap DMA buffers */
+	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_SE,
+		0, (void *)op->block_addr, op->block_size, TEGRABL_DMA_TO_DEVICE);
+
+	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_SE,
+		0, (void *)op->hash_addr, op->hash_size,
+		TEGRABL_DMA_FROM_DEVICE);
+}
+
+/*
+ * Program the SHA engine for one block and start it. SE0 mutex must be held
+ * from here until se_sha_block_finish() is done with the block.
+ *
+ * hash_state, when not NULL, holds the intermediate hash of a streamed
+ * message: it is loaded into SE0_SHA_HASH_RESULT before a continued block
+ * is processed and refreshed from there once the block is done.
+ */
+static tegrabl_error_t se_sha_block_start(
 	struct se_sha_input_params *input_params,
-	struct se_sha_context *context)
+	struct se_sha_context *context,
+	uint32_t *hash_state,
+	struct se_sha_op *op)
 {
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
 
+	uint32_t i = 0;
 	uint32_t se_config_reg = 0;
 	uint32_t size_left = 0;
 	uint32_t hash_size = 0;
@@ -387,9 +481,8 @@ static tegrabl_error_t _tegrabl_se_sha_process_block(
 	uintptr_t block_addr = 0;
 	dma_addr_t dma_block_addr = 0;
 	dma_addr_t dma_hash_result = 0;
-	bool engine_busy = true;
 
-	if ((input_params == NULL) || (context == NULL))
+	if ((input_params == NULL) || (context == NULL) || (op == NULL))
 		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
 
 	size_left = input_params->size_left;
@@ -411,28 +504,15 @@ static tegrabl_error_t _tegrabl_se_sha_process_block(
 	}
 
 	/* Calculate output size */
-	switch (hash_algorithm) {
-	case SE_MODE_PKT_SHAMODE_SHA1:
-		hash_size = ARSE_SHA1_HASH_SIZE / 8;
-		break;
-	case SE_MODE_PKT_SHAMODE_SHA224:
-		hash_size = ARSE_SHA224_HASH_SIZE / 8;
-		break;
-	case SE_MODE_PKT_SHAMODE_SHA256:
-		hash_size = ARSE_SHA256_HASH_SIZE / 8;
-		break;
-	case SE_MODE_PKT_SHAMODE_SHA384:
-		hash_size = ARSE_SHA384_HASH_SIZE / 8;
-		break;
-	case SE_MODE_PKT_SHAMODE_SHA512:
-		hash_size = ARSE_SHA512_HASH_SIZE / 8;
-		break;
-	default:
-		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
-		goto fail;
-	}
+	hash_size = se_sha_digest_size(hash_algorithm);
+	if (hash_size == 0)
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
 
-	tegrabl_get_se0_mutex();
+	op->block_addr = block_addr;
+	op->block_size = block_size;
+	op->hash_addr = phash_result;
+	op->hash_size = hash_size;
+	op->hash_state = hash_state;
 
 	se_config_reg = NV_FLD_SET_DRF_NUM(
 		SE0, SHA_CONFIG, ENC_MODE, hash_algorithm, se_config_reg);
@@ -467,6 +547,11 @@ static tegrabl_error_t _tegrabl_se_sha_process_block(
 
 	tegrabl_set_se0_reg(SE0_SHA_TASK_CONFIG_0, se_config_reg);
 
+	if ((hash_state != NULL) && (context->input_size != size_left)) {
+		for (i = 0; i < SE_SHA_STATE_WORDS; i++)
+			tegrabl_set_se0_reg(SE0_SHA_HASH_RESULT_0 + (i * 4), hash_state[i]);
+	}
+
 	dma_block_addr = tegrabl_dma_map_buffer(TEGRABL_MODULE_SE,
 		0, (void *)block_addr, block_size, TEGRABL_DMA_TO_DEVICE);
 	/* Program input address and HI register. */
@@ -510,31 +595,54 @@ static tegrabl_error_t _tegrabl_se_sha_process_block(
 	else
 		err = tegrabl_start_se0_operation(ARSE_ENG_IDX_SHA, false);
 
+	if (err) {
+		op->hash_state = NULL;
+		se_sha_block_finish(op);
+	}
+
+	return err;
+}
+
+static tegrabl_error_t se_sha_process_block_state(
+	struct se_sha_input_params *input_params,
+	struct se_sha_context *context,
+	uint32_t *hash_state)
+{
+	struct se_sha_op op;
+	bool engine_busy = true;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	tegrabl_get_se0_mutex();
+
+	err = se_sha_block_start(input_params, context, hash_state, &op);
 	if (err)
 		goto fail;
 
 	/* Poll for BUSY */
 	while (engine_busy) {
 		err = tegrabl_is_se0_engine_busy(ARSE_ENG_IDX_SHA, &engine_busy);
-		if (err)
-			goto fail;
+		if (err) {
+			op.hash_state = NULL;
+			break;
+		}
 	}
 
-fail:
-	/* Unmap DMA buffers */
-	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_SE,
-		0, (void *)block_addr, block_size, TEGRABL_DMA_TO_DEVICE);
-
-	tegrabl_dma_unmap_buffer(TEGRABL_MODULE_SE,
-		0, (void *)(uintptr_t)phash_result, hash_size,
-		TEGRABL_DMA_FROM_DEVICE);
+	se_sha_block_finish(&op);
 
+fail:
 	tegrabl_release_se0_mutex();
 	if (err)
 		pr_debug("Error = %d in tegrabl_se_sha_process_block\n", err);
 	return err;
 }
 
+static tegrabl_error_t _tegrabl_se_sha_process_block(
+	struct se_sha_input_params *input_params,
+	struct se_sha_context *context)
+{
+	return se_sha_process_block_state(input_params, context, NULL);
+}
+
 tegrabl_error_t tegrabl_se_sha_process_block(
 	struct se_sha_input_params *input_params,
 	struct se_sha_context *context)
@@ -610,6 +718,384 @@ tegrabl_error_t tegrabl_se_sha_process_payload(
 	return ret;
 }
 
+static inline uint32_t se_sha_block_size(uint8_t hash_algorithm)
+{
+	if ((hash_algorithm == SE_MODE_PKT_SHAMODE_SHA384) ||
+		(hash_algorithm == SE_MODE_PKT_SHAMODE_SHA512))
+		return SE_SHA_MAX_BLOCK_SIZE;
+
+	return 64;
+}
+
+/*
+ * Streaming relies on the engine resuming from an intermediate hash which
+ * is written back into SE0_SHA_HASH_RESULT with HW_INIT_HASH disabled.
+ * Check once for each SHA mode that a message hashed in two pieces gives
+ * the one-shot digest.
+ */
+static tegrabl_error_t se_sha_stream_self_test(uint8_t hash_algorithm)
+{
+	struct se_sha_input_params input;
+	struct se_sha_context context;
+	struct se_sha_stream stream;
+	uint32_t size = sizeof(se_sha_test_msg);
+	uint32_t sha_block_size;
+	uint32_t i;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	for (i = 0; i < size; i++)
+		se_sha_test_msg[i] = (uint8_t)((i * 7U) + 1U);
+
+	context.hash_algorithm = hash_algorithm;
+	context.input_size = size;
+	input.block_addr = (uintptr_t)se_sha_test_msg;
+	input.block_size = size;
+	input.size_left = size;
+	input.hash_addr = (uintptr_t)se_sha_test_digest;
+
+	err = tegrabl_se_sha_process_block(&input, &context);
+	if (err != TEGRABL_NO_ERROR)
+		return err;
+
+	memset(&stream, 0, sizeof(stream));
+	stream.hash_algorithm = hash_algorithm;
+	sha_block_size = se_sha_block_size(hash_algorithm);
+
+	err = tegrabl_se_sha_stream_update(&stream, (uintptr_t)se_sha_test_msg,
+									   sha_block_size, false);
+	if (err != TEGRABL_NO_ERROR)
+		return err;
+
+	err = tegrabl_se_sha_stream_update(&stream,
+									   (uintptr_t)se_sha_test_msg +
+									   sha_block_size,
+									   size - sha_block_size, true);
+	if (err != TEGRABL_NO_ERROR)
+		return err;
+
+	if (memcmp(stream.digest, se_sha_test_digest,
+			   se_sha_digest_size(hash_algorithm)) != 0)
+		return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 1);
+
+	return TEGRABL_NO_ERROR;
+}
+
+tegrabl_error_t tegrabl_se_sha_stream_init(struct se_sha_stream *stream,
+	uint8_t hash_algorithm)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	if (stream == NULL)
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+
+	switch (hash_algorithm) {
+	case SE_MODE_PKT_SHAMODE_SHA1:
+	case SE_MODE_PKT_SHAMODE_SHA224:
+	case SE_MODE_PKT_SHAMODE_SHA256:
+	case SE_MODE_PKT_SHAMODE_SHA384:
+	case SE_MODE_PKT_SHAMODE_SHA512:
+		break;
+	default:
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+	}
+
+	if (se_sha_stream_status[hash_algorithm] == SE_SHA_STREAM_UNTESTED) {
+		err = se_sha_stream_self_test(hash_algorithm);
+		if (TEGRABL_ERROR_REASON(err) == TEGRABL_ERR_NOT_SUPPORTED) {
+			pr_warn("SE SHA mode %u cannot resume a hash, not streaming\n",
+					hash_algorithm);
+			se_sha_stream_status[hash_algorithm] = SE_SHA_STREAM_BROKEN;
+		} else if (err != TEGRABL_NO_ERROR) {
+			/* Not known either way, test again next time */
+			return err;
+		} else {
+			se_sha_stream_status[hash_algorithm] = SE_SHA_STREAM_OK;
+		}
+	}
+
+	if (se_sha_stream_status[hash_algorithm] != SE_SHA_STREAM_OK)
+		return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 0);
+
+	memset(stream, 0, sizeof(*stream));
+	stream->hash_algorithm = hash_algorithm;
+
+	return TEGRABL_NO_ERROR;
+}
+
+/* Start the next piece of the given SHA job on the engine */
+static tegrabl_error_t se_sha_job_start(struct se_sha_job *job)
+{
+	struct se_sha_stream *stream = job->stream;
+	struct se_sha_input_params input;
+	struct se_sha_context context;
+	uint32_t sha_block_size;
+	uint32_t size;
+	bool last_piece;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	sha_block_size = se_sha_block_size(stream->hash_algorithm);
+	size = MIN(job->size - job->done, SHA_INPUT_BLOCK_SZ);
+	last_piece = job->is_last && ((job->done + size) == job->size);
+
+	if ((stream->processed + size + sha_block_size) < stream->processed)
+		return TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 1);
+
+	context.hash_algorithm = stream->hash_algorithm;
+	input.hash_addr = (uintptr_t)stream->digest;
+	input.block_addr = job->addr + job->done;
+	input.block_size = size;
+	if (last_piece) {
+		context.input_size = stream->processed + size;
+		input.size_left = size;
+	} else {
+		/* Total length is not known yet; make the engine expect one
+		 * more block so that it does not pad and finalize the hash. */
+		context.input_size = stream->processed + size + sha_block_size;
+		input.size_left = size + sha_block_size;
+	}
+
+	se0_mutex_lock();
+	err = se_sha_block_start(&input, &context, stream->state, &se_jobs.op);
+	if (err != TEGRABL_NO_ERROR) {
+		tegrabl_release_se0_mutex();
+		return err;
+	}
+
+	se_jobs.op_size = size;
+	se_jobs.in_flight = true;
+
+	return TEGRABL_NO_ERROR;
+}
+
+/* Remove the job at head of the queue and report its outcome */
+static void se_sha_job_retire(tegrabl_error_t err)
+{
+	struct se_sha_job *job = se_jobs.jobs[se_jobs.head];
+
+	if (err != TEGRABL_NO_ERROR)
+		pr_debug("Error = %d in SHA job\n", err);
+
+	job->err = err;
+	job->pending = false;
+	se_jobs.jobs[se_jobs.head] = NULL;
+	se_jobs.head = (se_jobs.head + 1U) % SE_SHA_JOB_QUEUE_SIZE;
+	se_jobs.count--;
+}
+
+/* Move the queue forward as far as it goes without waiting for the engine */
+static void se_jobs_pump(void)
+{
+	struct se_sha_job *job;
+	bool engine_busy = false;
+	tegrabl_error_t err;
+
+	while (se_jobs.count != 0U) {
+		job = se_jobs.jobs[se_jobs.head];
+
+		if (se_jobs.in_flight) {
+			err = tegrabl_is_se0_engine_busy(ARSE_ENG_IDX_SHA, &engine_busy);
+			if ((err == TEGRABL_NO_ERROR) && engine_busy)
+				return;
+
+			/* Hash state is of no use if the engine could not be polled */
+			if (err != TEGRABL_NO_ERROR)
+				se_jobs.op.hash_state = NULL;
+			se_sha_block_finish(&se_jobs.op);
+			tegrabl_release_se0_mutex();
+			se_jobs.in_flight = false;
+
+			if (err != TEGRABL_NO_ERROR) {
+				se_sha_job_retire(err);
+				continue;
+			}
+
+			job->stream->processed += se_jobs.op_size;
+			job->done += se_jobs.op_size;
+			if (job->done == job->size) {
+				se_sha_job_retire(TEGRABL_NO_ERROR);
+				continue;
+			}
+		}
+
+		err = se_sha_job_start(job);
+		if (err != TEGRABL_NO_ERROR) {
+			se_sha_job_retire(err);
+			continue;
+		}
+		return;
+	}
+}
+
+/* Wait for all the queued jobs, so that the engine can be used directly */
+static void se_jobs_drain(void)
+{
+	while (se_jobs.count != 0U)
+		se_jobs_pump();
+}
+
+tegrabl_error_t tegrabl_se_sha_submit(struct se_sha_job *job,
+	struct se_sha_stream *stream, uintptr_t addr, uint32_t size, bool is_last)
+{
+	if ((job == NULL) || (stream == NULL) || (addr == 0) || (size == 0))
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+
+	if (!is_last && ((size % se_sha_block_size(stream->hash_algorithm)) != 0))
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+
+	if ((stream->processed + size) < stream->processed)
+		return TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 0);
+
+	job->stream = stream;
+	job->addr = addr;
+	job->size = size;
+	job->done = 0;
+	job->is_last = is_last;
+	job->err = TEGRABL_NO_ERROR;
+	job->pending = true;
+
+	while (se_jobs.count == SE_SHA_JOB_QUEUE_SIZE)
+		se_jobs_pump();
+
+	se_jobs.jobs[(se_jobs.head + se_jobs.count) % SE_SHA_JOB_QUEUE_SIZE] = job;
+	se_jobs.count++;
+
+	/* Get the engine going right away if it is idle */
+	se_jobs_pump();
+
+	return TEGRABL_NO_ERROR;
+}
+
+bool tegrabl_se_sha_job_poll(struct se_sha_job *job)
+{
+	se_jobs_pump();
+
+	return (job == NULL) || !job->pending;
+}
+
+tegrabl_error_t tegrabl_se_sha_job_wait(struct se_sha_job *job)
+{
+	if (job == NULL)
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+
+	while (!tegrabl_se_sha_job_poll(job))
+		;
+
+	return job->err;
+}
+
+tegrabl_error_t tegrabl_se_sha_stream_update(struct se_sha_stream *stream,
+	uintptr_t addr, uint32_t size, bool is_last)
+{
+	struct se_sha_job job;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	err = tegrabl_se_sha_submit(&job, stream, addr, size, is_last);
+	if (err == TEGRABL_NO_ERROR)
+		err = tegrabl_se_sha_job_wait(&job);
+
+	if (err != TEGRABL_NO_ERROR)
+		TEGRABL_SET_HIGHEST_MODULE(err);
+	return err;
+}
+
+tegrabl_error_t tegrabl_se_sha_process_extents(
+	const struct se_sha_extent *extents, uint32_t count,
+	uint8_t hash_algorithm, uint8_t *digest)
+{
+	/* Holds the bytes of a SHA block which straddles two extents */
+	uint8_t carry[SE_SHA_MAX_BLOCK_SIZE] TEGRABL_ALIGN(64);
+	struct se_sha_stream stream;
+	uint32_t carry_size = 0;
+	uint32_t sha_block_size;
+	uint32_t last = 0;
+	uint32_t whole;
+	uint32_t size;
+	uint32_t copy;
+	uint32_t i;
+	uintptr_t addr;
+	bool done = false;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+
+	if ((extents == NULL) || (count == 0) || (digest == NULL))
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+
+	err = tegrabl_se_sha_stream_init(&stream, hash_algorithm);
+	if (err != TEGRABL_NO_ERROR)
+		goto fail;
+
+	sha_block_size = se_sha_block_size(hash_algorithm);
+
+	/* Message is completed by the last extent which has any data */
+	for (i = 0; i < count; i++) {
+		if (extents[i].size != 0)
+			last = i + 1;
+	}
+	if (last-- == 0)
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+
+	for (i = 0; i <= last; i++) {
+		addr = extents[i].addr;
+		size = extents[i].size;
+		if (size == 0)
+			continue;
+
+		if (carry_size != 0) {
+			copy = MIN(sha_block_size - carry_size, size);
+			memcpy(carry + carry_size, (void *)addr, copy);
+			carry_size += copy;
+			addr += copy;
+			size -= copy;
+
+			/* A full block which ends the message is left for the end */
+			if ((carry_size == sha_block_size) &&
+				((size != 0) || (i != last))) {
+				err = tegrabl_se_sha_stream_update(&stream, (uintptr_t)carry,
+												   carry_size, false);
+				if (err != TEGRABL_NO_ERROR)
+					goto fail;
+				carry_size = 0;
+			}
+
+			if (size == 0)
+				continue;
+		}
+
+		if (i == last) {
+			err = tegrabl_se_sha_stream_update(&stream, addr, size, true);
+			if (err != TEGRABL_NO_ERROR)
+				goto fail;
+			done = true;
+			break;
+		}
+
+		whole = ROUND_DOWN_POW2(size, sha_block_size);
+		if (whole != 0) {
+			err = tegrabl_se_sha_stream_update(&stream, addr, whole, false);
+			if (err != TEGRABL_NO_ERROR)
+				goto fail;
+		}
+
+		carry_size = size - whole;
+		memcpy(carry, (void *)(addr + whole), carry_size);
+	}
+
+	if (!done) {
+		err = tegrabl_se_sha_stream_update(&stream, (uintptr_t)carry,
+										   carry_size, true);
+		if (err != TEGRABL_NO_ERROR)
+			goto fail;
+	}
+
+	memcpy(digest, stream.digest, se_sha_digest_size(hash_algorithm));
+
+fail:
+	if (err != TEGRABL_NO_ERROR) {
+		TEGRABL_SET_HIGHEST_MODULE(err);
+		pr_debug("Error = %d in tegrabl_se_sha_process_extents\n", err);
+	}
+	return err;
+}
+
 void tegrabl_se_sha_close(void)
 {
 	return;
@@ -1782,6 +2268,7 @@ tegrabl_error_t tegrabl_se_aes_process_block(
 	struct se_aes_context *context)
 {
 	uint8_t *buffer;
+	uint8_t *dst;
 	uint32_t size_to_process;
 	tegrabl_error_t err = TEGRABL_NO_ERROR;
 
@@ -1789,6 +2276,7 @@ tegrabl_error_t tegrabl_se_aes_process_block(
 		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
 
 	buffer = input_params->src;
+	dst = input_params->dst;
 	size_to_process = input_params->input_size;
 
 	/* Process the input in multiples of 16 MB, limited by
@@ -1799,6 +2287,7 @@ tegrabl_error_t tegrabl_se_aes_process_block(
 		size = (size_to_process > SE_AES_MAX_INPUT_SIZE) ?
 			SE_AES_MAX_INPUT_SIZE : size_to_process;
 		input_params->src = buffer;
+		input_params->dst = dst;
 		input_params->input_size = size;
 
 		err = _tegrabl_se_aes_process_block(input_params, context);
@@ -1809,6 +2298,9 @@ tegrabl_error_t tegrabl_se_aes_process_block(
 		input_params->size_left -= size;
 		size_to_process -= size;
 		buffer += size;
+		/* Output follows input, also when decrypting in place */
+		if (dst != NULL)
+			dst += size;
 	} while (size_to_process > 0);
 
 fail:
@@ -13,11 +13,17 @@
 #define TEGRABL_SE_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <tegrabl_compiler.h>
 #include <tegrabl_error.h>
 
 #define SE_AES_BLOCK_LENGTH	16
 #define SELECT_EXPONENT 0
 #define SELECT_MODULUS 1
+#define SE_SHA_MAX_DIGEST_SIZE 64
+#define SE_SHA_STATE_WORDS 16
+#define SE_SHA_MAX_BLOCK_SIZE 128
+#define SE_SHA_JOB_QUEUE_SIZE 4
 
 /*
  * @brief Defines AES operating modes
@@ -57,6 +63,41 @@ struct se_sha_context {
 	uint8_t hash_algorithm;
 };
 
+/*
+ * @brief State of a SHA operation whose input is fed in several pieces.
+ * The intermediate hash is saved after every piece, so other users of the
+ * SHA engine may run between two updates of the same stream.
+ */
+struct se_sha_stream {
+	uint8_t digest[SE_SHA_MAX_DIGEST_SIZE] TEGRABL_ALIGN(64);
+	uint32_t state[SE_SHA_STATE_WORDS];
+	uint32_t processed;
+	uint8_t hash_algorithm;
+};
+
+/*
+ * @brief SHA work queued on the engine by tegrabl_se_sha_submit(). It is
+ * owned by the SE driver, and neither it nor its input may be touched,
+ * until tegrabl_se_sha_job_poll() reports it done.
+ */
+struct se_sha_job {
+	struct se_sha_stream *stream;
+	uintptr_t addr;
+	uint32_t size;
+	uint32_t done;
+	bool is_last;
+	bool pending;
+	tegrabl_error_t err;
+};
+
+/*
+ * @brief One piece of a message which is scattered in memory
+ */
+struct se_sha_extent {
+	uintptr_t addr;
+	uint32_t size;
+};
+
 /*
  * @brief Context returned by AES init operation
  */
@@ -141,6 +182,87 @@ tegrabl_error_t tegrabl_se_sha_process_payload(
 	struct se_sha_input_params *input_params,
 	struct se_sha_context *context);
 
+/*
+ * @brief Start a new streaming SHA operation. The first call for a SHA mode
+ * checks that the engine resumes a hash correctly.
+ *
+ * @param stream stream state to be initialized
+ * @param hash_algorithm SHA mode to be used (SE_SHAMODE_*)
+ *
+ * @return TEGRABL_ERR_NOT_SUPPORTED if the engine cannot stream this mode,
+ * else error out if any
+ */
+tegrabl_error_t tegrabl_se_sha_stream_init(struct se_sha_stream *stream,
+	uint8_t hash_algorithm);
+
+/*
+ * @brief Feed the next piece of input to a streaming SHA operation.
+ * All pieces but the last one must be a multiple of the SHA block size.
+ * Once the last piece is processed the digest is in stream->digest.
+ *
+ * @param stream stream state set up by tegrabl_se_sha_stream_init
+ * @param addr address of the input piece
+ * @param size size of the input piece in bytes
+ * @param is_last true if this piece completes the message
+ *
+ * @return error out if any
+ */
+tegrabl_error_t tegrabl_se_sha_stream_update(struct se_sha_stream *stream,
+	uintptr_t addr, uint32_t size, bool is_last);
+
+/*
+ * @brief Queue the next piece of input of a streaming SHA operation and
+ * return without waiting for the engine. Jobs run in the order they are
+ * submitted, so several pieces of one stream may be queued back to back.
+ * Once a job fails its stream is of no use. Submitting to a full queue
+ * waits for its head job to be done.
+ *
+ * @param job job to be queued, must stay valid until it is done
+ * @param stream stream state set up by tegrabl_se_sha_stream_init
+ * @param addr address of the input piece
+ * @param size size of the input piece in bytes
+ * @param is_last true if this piece completes the message
+ *
+ * @return error out if the job could not be queued
+ */
+tegrabl_error_t tegrabl_se_sha_submit(struct se_sha_job *job,
+	struct se_sha_stream *stream, uintptr_t addr, uint32_t size, bool is_last);
+
+/*
+ * @brief Move queued SHA jobs forward without waiting for the engine
+ *
+ * @param job job to be checked, may be NULL
+ *
+ * @return true if job is done (or NULL)
+ */
+bool tegrabl_se_sha_job_poll(struct se_sha_job *job);
+
+/*
+ * @brief Wait for a queued SHA job to be done
+ *
+ * @param job job to be waited for
+ *
+ * @return outcome of the job
+ */
+tegrabl_error_t tegrabl_se_sha_job_wait(struct se_sha_job *job);
+
+/*
+ * @brief Hash a message made of several pieces in the given order, as if
+ * they were contiguous. Pieces can be of any size; parts of a SHA block
+ * which straddle two pieces are staged in a small buffer, so the pieces
+ * themselves are neither copied nor modified.
+ *
+ * @param extents ordered list of the pieces of the message
+ * @param count number of entries in extents
+ * @param hash_algorithm SHA mode to be used (SE_SHAMODE_*)
+ * @param digest output buffer for the digest
+ *
+ * @return error out if any
+ */
+tegrabl_error_t tegrabl_se_sha_process_extents(
+	const struct se_sha_extent *extents, uint32_t count,
+	uint8_t hash_algorithm, uint8_t *digest);
+
 /*
  * @brief dummy function
  */
@@ -258,6 +380,64 @@ static inline tegrabl_error_t tegrabl_se_sha_process_block(
 	return TEGRABL_NO_ERROR;
 }
 
+static inline tegrabl_error_t tegrabl_se_sha_stream_init(
+	struct se_sha_stream *stream, uint8_t hash_algorithm)
+{
+	TEGRABL_UNUSED(stream);
+	TEGRABL_UNUSED(hash_algorithm);
+
+	return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 0);
+}
+
+static inline tegrabl_error_t tegrabl_se_sha_stream_update(
+	struct se_sha_stream *stream, uintptr_t addr, uint32_t size, bool is_last)
+{
+	TEGRABL_UNUSED(stream);
+	TEGRABL_UNUSED(addr);
+	TEGRABL_UNUSED(size);
+	TEGRABL_UNUSED(is_last);
+
+	return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 0);
+}
+
+static inline tegrabl_error_t tegrabl_se_sha_submit(struct se_sha_job *job,
+	struct se_sha_stream *stream, uintptr_t addr, uint32_t size, bool is_last)
+{
+	TEGRABL_UNUSED(job);
+	TEGRABL_UNUSED(stream);
+	TEGRABL_UNUSED(addr);
+	TEGRABL_UNUSED(size);
+	TEGRABL_UNUSED(is_last);
+
+	return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 0);
+}
+
+static inline bool tegrabl_se_sha_job_poll(struct se_sha_job *job)
+{
+	TEGRABL_UNUSED(job);
+
+	return true;
+}
+
+static inline tegrabl_error_t tegrabl_se_sha_job_wait(struct se_sha_job *job)
+{
+	TEGRABL_UNUSED(job);
+
+	return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 0);
+}
+
+static inline tegrabl_error_t tegrabl_se_sha_process_extents(
+	const struct se_sha_extent *extents, uint32_t count,
+	uint8_t hash_algorithm, uint8_t *digest)
+{
+	TEGRABL_UNUSED(extents);
+	TEGRABL_UNUSED(count);
+	TEGRABL_UNUSED(hash_algorithm);
+	TEGRABL_UNUSED(digest);
+
+	return TEGRABL_ERROR(TEGRABL_ERR_NOT_SUPPORTED, 0);
+}
+
 static inline void tegrabl_se_sha_close(void)
 {
 }
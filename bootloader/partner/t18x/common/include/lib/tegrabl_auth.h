@@ -100,6 +100,9 @@ tegrabl_error_t tegrabl_auth_initiate(uint32_t bin_type,
  * @param buffer_size Size of the buffer.
  * @param check_header Check if header is present in buffer
  *
+ * If buffer is the safe destination location, i.e. block is loaded straight
+ * to its place, it is hashed/decrypted in place instead of being copied.
+ *
  * @return TEGRABL_NO_ERROR if successful else appropriate error.
  */
 tegrabl_error_t tegrabl_auth_process_block(struct tegrabl_auth_handle *auth,
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2018, NVIDIA Corporation.  All rights reserved.
+ *
+ * NVIDIA Corporation and its licensors retain all intellectual property
+ * and proprietary rights in and to this software and related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA Corporation is strictly prohibited.
+ */
+
+#ifndef INCLUDED_TEGRABL_CPU_WORKERS_H
+#define INCLUDED_TEGRABL_CPU_WORKERS_H
+
+#include <stdint.h>
+#include <tegrabl_error.h>
+
+/* Max number of CPUs which can be brought up as workers */
+#define TEGRABL_CPU_WORKERS_MAX 7
+
+/**
+ * @brief Work function run by tegrabl_cpu_workers_run() for each index.
+ *
+ * It may run on any CPU concurrently with the others, so it must only touch
+ * its own data. Heap, console, storage and other drivers are not safe to be
+ * used from it.
+ */
+typedef void (*tegrabl_cpu_work_t)(void *arg, uint32_t index);
+
+/**
+ * @brief Powers on the given CPUs through PSCI and parks them as workers
+ * waiting for tegrabl_cpu_workers_run(). They run with the translation
+ * setup of the calling CPU, so MMU must already be enabled. CPUs which fail
+ * to come up are skipped. Once any is up, it is also registered as block
+ * runner of the decompressor framework.
+ *
+ * @param mpidr MPIDRs of the CPUs to be used
+ * @param count Number of entries in mpidr
+ *
+ * @return TEGRABL_NO_ERROR if at least one worker is up.
+ */
+tegrabl_error_t tegrabl_cpu_workers_start(const uint64_t *mpidr,
+										  uint32_t count);
+
+/**
+ * @brief Runs fn(arg, index) for each index in [0, count) spread over the
+ * workers and the calling CPU, and returns once all are done. Without any
+ * worker, everything runs on the calling CPU. Must not be nested.
+ *
+ * @param fn Work function
+ * @param arg Argument passed to each call of fn
+ * @param count Number of indices
+ */
+void tegrabl_cpu_workers_run(tegrabl_cpu_work_t fn, void *arg, uint32_t count);
+
+/**
+ * @brief Returns number of workers which are up, not counting calling CPU.
+ */
+uint32_t tegrabl_cpu_workers_count(void);
+
+/**
+ * @brief Powers off all the workers through PSCI and waits for them to be
+ * off, so that it is safe to hand over the CPUs to the OS.
+ *
+ * @return TEGRABL_NO_ERROR if all workers are off.
+ */
+tegrabl_error_t tegrabl_cpu_workers_stop(void);
+
+#endif /* INCLUDED_TEGRABL_CPU_WORKERS_H */
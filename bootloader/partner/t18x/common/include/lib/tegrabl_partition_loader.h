@@ -11,6 +11,8 @@
 #ifndef INCLUDED_TEGRABL_PARTITION_LOADER_H
 #define INCLUDED_TEGRABL_PARTITION_LOADER_H
 
+#include <stdint.h>
+#include <stdbool.h>
 #include <tegrabl_error.h>
 
 /**
@@ -84,4 +86,106 @@ tegrabl_error_t tegrabl_load_binary(enum tegrabl_binary_type bin_type,
  */
 void tegrabl_loader_set_blob_address(void *blob);
 
+#if defined(CONFIG_ENABLE_BOOTIMG_STREAM_HASH)
+struct se_sha_stream;
+
+/**
+ * @brief Returns the SHA256 stream of the boot.img payload (header, kernel,
+ * ramdisk and second stage) which was hashed while the image was being read.
+ * The stream is left open so that the caller can append the authenticated
+ * attributes and finalize a copy of it.
+ *
+ * @param payload Address of the payload to be verified.
+ * @param payload_size Size of the payload to be verified.
+ *
+ * @return Stream state if it covers exactly the given payload, else NULL.
+ */
+struct se_sha_stream *tegrabl_loader_get_kernel_sha_stream(
+	const void *payload, uint64_t payload_size);
+#endif
+
+#if defined(CONFIG_ENABLE_KERNEL_STREAM_DECOMPRESS)
+/**
+ * @brief Requests the kernel of the next boot.img loaded from storage to be
+ * decompressed into buffer while rest of the image is still being read.
+ *
+ * @param buffer Where the decompressed kernel goes.
+ * @param size Size of buffer.
+ */
+void tegrabl_loader_set_kernel_decompress_buffer(void *buffer, uint32_t size);
+
+/**
+ * @brief Checks whether the kernel was completely decompressed while boot.img
+ * was being loaded. Either way the buffer is released, so this has to be
+ * called only once per load.
+ *
+ * @param kernel Address of the compressed kernel in boot.img.
+ * @param kernel_size Size of the compressed kernel.
+ * @param buffer Buffer which was passed to
+ * tegrabl_loader_set_kernel_decompress_buffer().
+ * @param decomp_size Size of decompressed kernel (output param)
+ *
+ * @return true if buffer holds the decompressed kernel, else false.
+ */
+bool tegrabl_loader_get_decompressed_kernel(const void *kernel,
+	uint32_t kernel_size, void *buffer, uint32_t *decomp_size);
+#endif
+
+#if defined(CONFIG_ENABLE_PRELOADED_PARTITIONS)
+/**
+ * @brief Looks up a partition which the loader has read to memory, so that
+ * it can be used in place instead of being read from storage again. The
+ * image is as read from storage, as long as its memory has not been
+ * reported modified or released with tegrabl_loader_drop_preloaded().
+ *
+ * @param partition_name Name of the partition, including slot suffix.
+ * @param size Size of the image in memory (output param)
+ *
+ * @return Address of the image, NULL if it is not in memory.
+ */
+void *tegrabl_loader_get_preloaded(const char *partition_name,
+	uint64_t *size);
+
+/**
+ * @brief Forgets the partition image which covers addr. To be called before
+ * the image is modified or its memory is released.
+ *
+ * @param addr Address within the image.
+ */
+void tegrabl_loader_drop_preloaded(const void *addr);
+#endif
+
+#if defined(CONFIG_ENABLE_BOOTIMG_SCATTER_LOAD)
+/* Sections of a boot image which were read to their requested destination */
+#define TEGRABL_BOOTIMG_SCATTER_KERNEL	(1U << 0)
+#define TEGRABL_BOOTIMG_SCATTER_RAMDISK	(1U << 1)
+
+/**
+ * @brief Requests the sections of the next boot.img or vendor_boot.img loaded
+ * from storage to be read straight to where they are booted from rather than
+ * into the image. Kernel is placed only if it is uncompressed. Placed sections
+ * are missing from the image, so this must not be used when the image is to
+ * be verified.
+ *
+ * @param kernel Destination of kernel, NULL to keep it in the image.
+ * @param kernel_max Size available at kernel.
+ * @param ramdisk Destination of ramdisk (vendor ramdisk for vendor_boot.img),
+ * NULL to keep it in the image.
+ * @param ramdisk_max Size available at ramdisk.
+ */
+void tegrabl_loader_set_bootimg_scatter(void *kernel, uint32_t kernel_max,
+	void *ramdisk, uint32_t ramdisk_max);
+
+/**
+ * @brief Returns which sections of the image were read to the destinations
+ * passed to tegrabl_loader_set_bootimg_scatter(). The request is released, so
+ * this has to be called only once per load.
+ *
+ * @param image Load address of the boot image.
+ *
+ * @return Mask of TEGRABL_BOOTIMG_SCATTER_* flags.
+ */
+uint32_t tegrabl_loader_get_bootimg_scatter(const void *image);
+#endif
+
 #endif /* INCLUDED_TEGRABL_PARTITION_LOADER_H */
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2018, NVIDIA Corporation.  All rights reserved.
+ *
+ * NVIDIA Corporation and its licensors retain all intellectual property
+ * and proprietary rights in and to this software and related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA Corporation is strictly prohibited.
+ */
+
+#ifndef INCLUDED_CPU_WORKERS_PRIV_H
+#define INCLUDED_CPU_WORKERS_PRIV_H
+
+/* Offsets of the fields of struct cpu_worker used by the entry code */
+#define CPU_WORKER_SCTLR	0x00
+#define CPU_WORKER_TCR		0x08
+#define CPU_WORKER_MAIR		0x10
+#define CPU_WORKER_TTBR0	0x18
+#define CPU_WORKER_VBAR		0x20
+#define CPU_WORKER_HCR		0x28
+#define CPU_WORKER_CPTR		0x30
+#define CPU_WORKER_SP		0x38
+
+#if !defined(_ASSEMBLY_)
+
+#include <stdint.h>
+
+/*
+ * Read by a worker CPU with MMU off on power-on, so it has to be cleaned
+ * to memory before the CPU is started.
+ */
+struct cpu_worker {
+	uint64_t sctlr;
+	uint64_t tcr;
+	uint64_t mair;
+	uint64_t ttbr0;
+	uint64_t vbar;
+	uint64_t hcr;
+	uint64_t cptr;
+	uint64_t sp;
+	uint64_t mpidr;
+	uint32_t state;
+};
+
+/* Where PSCI CPU_ON starts a worker, x0 points to its struct cpu_worker */
+void tegrabl_cpu_worker_entry(void);
+
+/* Worker loop, entered with MMU on and stack set up */
+void tegrabl_cpu_worker_main(struct cpu_worker *worker);
+
+#endif /* !defined(_ASSEMBLY_) */
+
+#endif /* INCLUDED_CPU_WORKERS_PRIV_H */
@@ -0,0 +1,26 @@
+#
+# Copyright (c) 2018, NVIDIA CORPORATION.  All rights reserved.
+#
+# NVIDIA CORPORATION and its licensors retain all intellectual property
+# and proprietary rights in and to this software and related documentation
+# and any modifications thereto.  Any use, reproduction, disclosure or
+# distribution of this software and related documentation without an express
+# license agreement from NVIDIA CORPORATION is strictly prohibited.
+#
+
+LOCAL_DIR := $(GET_LOCAL_DIR)
+
+MODULE := $(LOCAL_DIR)
+
+GLOBAL_INCLUDES += \
+	$(LOCAL_DIR)/../../../../common/include \
+	$(LOCAL_DIR)/../../../../common/include/lib \
+	$(LOCAL_DIR)/../../common/include/lib \
+
+MODULE_SRCS += \
+	$(LOCAL_DIR)/tegrabl_cpu_workers.c \
+	$(LOCAL_DIR)/cpu_workers_entry.S
+
+MODULE_ASMFLAGS += -D_ASSEMBLY_=1
+
+include make/module.mk
@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) 2018, NVIDIA Corporation.  All rights reserved.
+ *
+ * NVIDIA Corporation and its licensors retain all intellectual property
+ * and proprietary rights in and to this software and related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA Corporation is strictly prohibited.
+ */
+
+#define MODULE TEGRABL_ERR_NO_MODULE
+
+#include "build_config.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <tegrabl_error.h>
+#include <tegrabl_debug.h>
+#include <tegrabl_compiler.h>
+#include <tegrabl_cache.h>
+#include <tegrabl_timer.h>
+#include <tegrabl_psci.h>
+#include <tegrabl_decompress.h>
+#include <tegrabl_cpu_workers.h>
+#include "cpu_workers_priv.h"
+
+/* Stack of each worker */
+#define CPU_WORKER_STACK_SIZE (16 * 1024)
+
+/* Time a worker may take to come up or to power off */
+#define CPU_WORKER_TIMEOUT_US 100000
+
+#define CPU_WORKER_OFF		0U
+#define CPU_WORKER_STARTING	1U
+#define CPU_WORKER_READY	2U
+
+#define read_sys_reg(reg)												\
+	({																	\
+		uint64_t val;													\
+		__asm__ volatile ("mrs %0, " #reg : "=r"(val) : : "memory");	\
+		val;															\
+	})
+
+/* Entry code loads the fields by these offsets */
+typedef char cpu_worker_layout_check[
+	((offsetof(struct cpu_worker, sctlr) == CPU_WORKER_SCTLR) &&
+	 (offsetof(struct cpu_worker, tcr) == CPU_WORKER_TCR) &&
+	 (offsetof(struct cpu_worker, mair) == CPU_WORKER_MAIR) &&
+	 (offsetof(struct cpu_worker, ttbr0) == CPU_WORKER_TTBR0) &&
+	 (offsetof(struct cpu_worker, vbar) == CPU_WORKER_VBAR) &&
+	 (offsetof(struct cpu_worker, hcr) == CPU_WORKER_HCR) &&
+	 (offsetof(struct cpu_worker, cptr) == CPU_WORKER_CPTR) &&
+	 (offsetof(struct cpu_worker, sp) == CPU_WORKER_SP)) ? 1 : -1];
+
+static struct cpu_worker workers[TEGRABL_CPU_WORKERS_MAX] TEGRABL_ALIGN(64);
+static uint8_t worker_stacks[TEGRABL_CPU_WORKERS_MAX][CPU_WORKER_STACK_SIZE]
+	TEGRABL_ALIGN(16);
+static uint32_t num_workers;
+
+/*
+ * Work being handed out. Indices are claimed under lock, and a new batch is
+ * published only after all indices of the previous one are done.
+ */
+static struct {
+	uint32_t lock;
+	tegrabl_cpu_work_t fn;
+	void *arg;
+	uint32_t count;
+	uint32_t next;
+	uint32_t done;
+	uint32_t generation;
+	bool park;
+} batch;
+
+static inline void batch_lock(void)
+{
+	while (__atomic_exchange_n(&batch.lock, 1U, __ATOMIC_ACQUIRE) != 0U) {
+		while (__atomic_load_n(&batch.lock, __ATOMIC_RELAXED) != 0U)
+			;
+	}
+}
+
+static inline void batch_unlock(void)
+{
+	__atomic_store_n(&batch.lock, 0U, __ATOMIC_RELEASE);
+}
+
+static inline void cpu_workers_wake(void)
+{
+	__asm__ volatile ("dsb ish\n\tsev" : : : "memory");
+}
+
+static inline void cpu_workers_wait(void)
+{
+	__asm__ volatile ("wfe" : : : "memory");
+}
+
+/* Run indices of the current batch until none is left to be claimed */
+static void cpu_workers_run_batch(void)
+{
+	tegrabl_cpu_work_t fn;
+	void *arg;
+	uint32_t index;
+	bool claimed;
+
+	while (true) {
+		batch_lock();
+		claimed = batch.next < batch.count;
+		index = batch.next;
+		fn = batch.fn;
+		arg = batch.arg;
+		if (claimed)
+			batch.next++;
+		batch_unlock();
+
+		if (!claimed)
+			break;
+
+		fn(arg, index);
+		__atomic_fetch_add(&batch.done, 1U, __ATOMIC_RELEASE);
+		cpu_workers_wake();
+	}
+}
+
+void tegrabl_cpu_worker_main(struct cpu_worker *worker)
+{
+	uint32_t seen;
+	uint32_t generation;
+
+	seen = __atomic_load_n(&batch.generation, __ATOMIC_ACQUIRE);
+	__atomic_store_n(&worker->state, CPU_WORKER_READY, __ATOMIC_RELEASE);
+	cpu_workers_wake();
+
+	while (!__atomic_load_n(&batch.park, __ATOMIC_ACQUIRE)) {
+		generation = __atomic_load_n(&batch.generation, __ATOMIC_ACQUIRE);
+		if (generation == seen) {
+			cpu_workers_wait();
+			continue;
+		}
+		seen = generation;
+		cpu_workers_run_batch();
+	}
+
+	tegrabl_psci_cpu_off();
+}
+
+void tegrabl_cpu_workers_run(tegrabl_cpu_work_t fn, void *arg, uint32_t count)
+{
+	uint32_t i;
+
+	if ((num_workers == 0U) || (count < 2U)) {
+		for (i = 0; i < count; i++)
+			fn(arg, i);
+		return;
+	}
+
+	batch_lock();
+	batch.fn = fn;
+	batch.arg = arg;
+	batch.count = count;
+	batch.next = 0;
+	__atomic_store_n(&batch.done, 0U, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&batch.generation, 1U, __ATOMIC_RELEASE);
+	batch_unlock();
+	cpu_workers_wake();
+
+	cpu_workers_run_batch();
+
+	while (__atomic_load_n(&batch.done, __ATOMIC_ACQUIRE) != count)
+		cpu_workers_wait();
+}
+
+uint32_t tegrabl_cpu_workers_count(void)
+{
+	return num_workers;
+}
+
+static void cpu_workers_decode_block(void *arg, uint32_t index)
+{
+	struct decompress_block_job *job = (struct decompress_block_job *)arg;
+
+	job[index].result = job[index].decode(&job[index]);
+}
+
+static void cpu_workers_block_runner(struct decompress_block_job *jobs,
+									 uint32_t count)
+{
+	tegrabl_cpu_workers_run(cpu_workers_decode_block, jobs, count);
+}
+
+tegrabl_error_t tegrabl_cpu_workers_start(const uint64_t *mpidr,
+										  uint32_t count)
+{
+	struct cpu_worker *worker;
+	tegrabl_error_t err;
+	time_t start;
+	uint32_t i;
+
+	if (mpidr == NULL)
+		return TEGRABL_ERROR(TEGRABL_ERR_INVALID, 0);
+
+	if (num_workers != 0U)
+		return TEGRABL_NO_ERROR;
+
+	__atomic_store_n(&batch.park, false, __ATOMIC_RELEASE);
+
+	for (i = 0; (i < count) && (num_workers < TEGRABL_CPU_WORKERS_MAX); i++) {
+		worker = &workers[num_workers];
+#if ARM64_WITH_EL2
+		worker->sctlr = read_sys_reg(sctlr_el2);
+		worker->tcr = read_sys_reg(tcr_el2);
+		worker->mair = read_sys_reg(mair_el2);
+		worker->ttbr0 = read_sys_reg(ttbr0_el2);
+		worker->vbar = read_sys_reg(vbar_el2);
+		worker->hcr = read_sys_reg(hcr_el2);
+		worker->cptr = read_sys_reg(cptr_el2);
+#else
+		worker->sctlr = read_sys_reg(sctlr_el1);
+		worker->tcr = read_sys_reg(tcr_el1);
+		worker->mair = read_sys_reg(mair_el1);
+		worker->ttbr0 = read_sys_reg(ttbr0_el1);
+		worker->vbar = read_sys_reg(vbar_el1);
+		/* No hypervisor controls to take over at EL1 */
+		worker->hcr = 0;
+		worker->cptr = 0;
+#endif
+		worker->sp = (uintptr_t)&worker_stacks[num_workers][CPU_WORKER_STACK_SIZE];
+		worker->mpidr = mpidr[i];
+		worker->state = CPU_WORKER_STARTING;
+		/* CPU reads it before its MMU and caches are on */
+		tegrabl_arch_clean_dcache_range((uintptr_t)worker, sizeof(*worker));
+
+		err = tegrabl_psci_cpu_on(mpidr[i],
+								  (uintptr_t)tegrabl_cpu_worker_entry,
+								  (uintptr_t)worker);
+		if (err != TEGRABL_NO_ERROR) {
+			worker->state = CPU_WORKER_OFF;
+			continue;
+		}
+
+		/* CPU is on from now, so it has to be parked even if it is late */
+		num_workers++;
+
+		start = tegrabl_get_timestamp_us();
+		while (__atomic_load_n(&worker->state, __ATOMIC_ACQUIRE) !=
+			   CPU_WORKER_READY) {
+			if ((tegrabl_get_timestamp_us() - start) > CPU_WORKER_TIMEOUT_US) {
+				pr_warn("CPU 0x%lx did not come up as worker\n",
+						(unsigned long)mpidr[i]);
+				break;
+			}
+		}
+	}
+
+	if (num_workers == 0U)
+		return TEGRABL_ERROR(TEGRABL_ERR_NOT_FOUND, 0);
+
+	decompress_set_block_runner(cpu_workers_block_runner);
+	pr_info("%u CPU workers up\n", num_workers);
+
+	return TEGRABL_NO_ERROR;
+}
+
+tegrabl_error_t tegrabl_cpu_workers_stop(void)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	time_t start;
+	uint32_t i;
+
+	if (num_workers == 0U)
+		return TEGRABL_NO_ERROR;
+
+	if (decompress_get_block_runner() == cpu_workers_block_runner)
+		decompress_set_block_runner(NULL);
+
+	__atomic_store_n(&batch.park, true, __ATOMIC_RELEASE);
+	cpu_workers_wake();
+
+	for (i = 0; i < num_workers; i++) {
+		start = tegrabl_get_timestamp_us();
+		while (tegrabl_psci_affinity_info(workers[i].mpidr) !=
+			   TEGRABL_PSCI_AFFINITY_OFF) {
+			if ((tegrabl_get_timestamp_us() - start) > CPU_WORKER_TIMEOUT_US) {
+				pr_error("CPU 0x%lx did not power off\n",
+						 (unsigned long)workers[i].mpidr);
+				err = TEGRABL_ERROR(TEGRABL_ERR_TIMEOUT, 0);
+				break;
+			}
+		}
+		workers[i].state = CPU_WORKER_OFF;
+	}
+
+	num_workers = 0;
+
+	return err;
+}
@@ -27,10 +27,90 @@
 #include <tegrabl_a_b_boot_control.h>
 #include <tegrabl_bootimg.h>
 #include <tegrabl_auth.h>
+#if defined(CONFIG_ENABLE_BOOTIMG_STREAM_HASH) || \
+	defined(CONFIG_ENABLE_KERNEL_STREAM_DECOMPRESS)
+#include <tegrabl_blockdev.h>
+#define KERNEL_STREAM_READ
+#endif
+#if defined(CONFIG_ENABLE_BOOTIMG_STREAM_HASH)
+#include <tegrabl_se.h>
+#endif
+#if defined(CONFIG_ENABLE_KERNEL_STREAM_DECOMPRESS) || \
+	defined(CONFIG_ENABLE_BOOTIMG_SCATTER_LOAD)
+#include <tegrabl_decompress.h>
+#endif
 
 /* boot.img signature size for verify_boot */
 #define BOOT_IMG_SIG_SIZE (4 * 1024)
 
+#if defined(KERNEL_STREAM_READ)
+/* boot.img is read in chunks of this size, processing one while reading next */
+#define KERNEL_STREAM_CHUNK_SIZE (4 * 1024 * 1024)
+/* Amount of data processed between two polls of the pending read */
+#define KERNEL_STREAM_HASH_STEP (512 * 1024)
+
+struct kernel_stream_read {
+	tegrabl_aio_t *aio;
+	tegrabl_error_t err;
+};
+#endif
+
+#if defined(CONFIG_ENABLE_BOOTIMG_STREAM_HASH)
+
+/*
+ * SHA256 of the boot.img payload computed while it was being loaded. Each
+ * piece is hashed by SE in the background while the CPU moves on, so hashed
+ * counts what has been submitted.
+ */
+static struct {
+	struct se_sha_stream sha;
+	struct se_sha_job job;
+	uintptr_t addr;
+	uint64_t size;
+	uint64_t hashed;
+	bool valid;
+} kernel_sha_stream;
+#endif
+
+#if defined(CONFIG_ENABLE_KERNEL_STREAM_DECOMPRESS)
+/* Kernel of boot.img decompressed while the image was being loaded */
+static struct {
+	struct decompress_stream stream;
+	uint8_t *out_buffer;
+	uint32_t outbuf_size;
+	uintptr_t addr;
+	uint32_t size;
+	uint32_t fed;
+	bool started;
+	bool valid;
+} kernel_decomp_stream;
+#endif
+
+#if defined(CONFIG_ENABLE_PRELOADED_PARTITIONS)
+#define MAX_PRELOADED_PARTITIONS 8
+
+/* Images read to memory in full, so that they need not be read again */
+static struct {
+	char name[TEGRABL_GPT_MAX_PARTITION_NAME + 1];
+	uint8_t *addr;
+	uint64_t size;
+} preloaded[MAX_PRELOADED_PARTITIONS];
+static uint32_t preloaded_next;
+#endif
+
+#if defined(CONFIG_ENABLE_BOOTIMG_SCATTER_LOAD)
+/* Where the sections of the next boot image are read instead of the image */
+static struct {
+	uint8_t *kernel;
+	uint32_t kernel_max;
+	uint8_t *ramdisk;
+	uint32_t ramdisk_max;
+	uintptr_t image;
+	uint32_t placed;
+	bool requested;
+} bootimg_scatter;
+#endif
+
 // Set this to the default 4096 page size, override in linux_load if different
 uint32_t bootimg_page_size = 4096;
 
@@ -199,6 +279,554 @@ static tegrabl_error_t tegrabl_get_binary_info(
 	return err;
 }
 
+#if defined(CONFIG_ENABLE_BOOTIMG_STREAM_HASH)
+/* Wait for the piece being hashed in the background, if any */
+static void kernel_stream_hash_wait(void)
+{
+	tegrabl_error_t err;
+
+	err = tegrabl_se_sha_job_wait(&kernel_sha_stream.job);
+	if (err != TEGRABL_NO_ERROR) {
+		pr_warn("Kernel hash while loading failed (err 0x%08x)\n", err);
+		kernel_sha_stream.valid = false;
+	}
+	kernel_sha_stream.job.err = TEGRABL_NO_ERROR;
+}
+
+static void kernel_stream_start(void *load_address, uint64_t payload_size)
+{
+	tegrabl_error_t err;
+
+	kernel_stream_hash_wait();
+	kernel_sha_stream.valid = false;
+	kernel_sha_stream.addr = (uintptr_t)load_address;
+	kernel_sha_stream.size = payload_size;
+	kernel_sha_stream.hashed = 0;
+
+	err = tegrabl_se_sha_stream_init(&kernel_sha_stream.sha,
+									 SE_SHAMODE_SHA256);
+	if (err != TEGRABL_NO_ERROR) {
+		pr_warn("Cannot hash kernel while loading (err 0x%08x)\n", err);
+		return;
+	}
+	kernel_sha_stream.valid = true;
+}
+
+static void kernel_stream_hash(void *buf, uint64_t len)
+{
+	uint64_t size;
+	tegrabl_error_t err;
+
+	if (!kernel_sha_stream.valid)
+		return;
+
+	/* Data must be hashed in order, anything else voids the stream */
+	if ((uintptr_t)buf != (kernel_sha_stream.addr + kernel_sha_stream.hashed)) {
+		kernel_sha_stream.valid = false;
+		return;
+	}
+
+	size = MIN(len, kernel_sha_stream.size - kernel_sha_stream.hashed);
+	if (size == 0)
+		return;
+
+	/* Pieces of one stream are chained, one in flight at a time is enough */
+	kernel_stream_hash_wait();
+	if (!kernel_sha_stream.valid)
+		return;
+
+	err = tegrabl_se_sha_submit(&kernel_sha_stream.job,
+								&kernel_sha_stream.sha, (uintptr_t)buf,
+								(uint32_t)size, false);
+	if (err != TEGRABL_NO_ERROR) {
+		pr_warn("Kernel hash while loading failed (err 0x%08x)\n", err);
+		kernel_sha_stream.valid = false;
+		return;
+	}
+	kernel_sha_stream.hashed += size;
+}
+
+#else
+static inline void kernel_stream_hash(void *buf, uint64_t len)
+{
+	(void)buf;
+	(void)len;
+}
+
+static inline void kernel_stream_hash_wait(void)
+{
+}
+#endif
+
+#if defined(CONFIG_ENABLE_KERNEL_STREAM_DECOMPRESS)
+static void kernel_decomp_start(void *kernel, uint32_t kernel_size)
+{
+	kernel_decomp_stream.addr = (uintptr_t)kernel;
+	kernel_decomp_stream.size = kernel_size;
+	kernel_decomp_stream.fed = 0;
+	kernel_decomp_stream.started = false;
+	kernel_decomp_stream.valid = (kernel_decomp_stream.out_buffer != NULL) &&
+		(kernel_size != 0U);
+}
+
+static void kernel_decomp_stop(void)
+{
+	if (kernel_decomp_stream.started)
+		decompress_stream_end(&kernel_decomp_stream.stream);
+	kernel_decomp_stream.started = false;
+	kernel_decomp_stream.valid = false;
+}
+
+/*
+ * Decompress the part of kernel which has been read, i.e. lies below end.
+ * Any failure just drops the stream and leaves decompression to linuxboot.
+ */
+static void kernel_decomp_feed(const uint8_t *end)
+{
+	tegrabl_error_t err;
+	decompressor *decomp;
+	uintptr_t avail_end;
+	uintptr_t next;
+	uint32_t consumed = 0;
+
+	if (!kernel_decomp_stream.valid ||
+		(kernel_decomp_stream.started && kernel_decomp_stream.stream.done))
+		return;
+
+	avail_end = MIN((uintptr_t)end,
+					kernel_decomp_stream.addr + kernel_decomp_stream.size);
+	next = kernel_decomp_stream.addr + kernel_decomp_stream.fed;
+	if (avail_end <= next)
+		return;
+
+	if (!kernel_decomp_stream.started) {
+		if ((avail_end - kernel_decomp_stream.addr) < 2U)
+			return;
+
+		/* Nothing to do for uncompressed kernel */
+		decomp = decompress_method((uint8_t *)kernel_decomp_stream.addr, 2);
+		if (decomp == NULL) {
+			kernel_decomp_stream.valid = false;
+			return;
+		}
+
+		err = decompress_stream_init(&kernel_decomp_stream.stream, decomp,
+									 kernel_decomp_stream.size,
+									 kernel_decomp_stream.out_buffer,
+									 kernel_decomp_stream.outbuf_size);
+		if (err != TEGRABL_NO_ERROR) {
+			kernel_decomp_stream.valid = false;
+			return;
+		}
+		kernel_decomp_stream.started = true;
+		pr_info("Decompressing %s kernel while loading\n", decomp->name);
+	}
+
+	err = decompress_stream_feed(&kernel_decomp_stream.stream, (uint8_t *)next,
+								 (uint32_t)(avail_end - next), &consumed);
+	if (err != TEGRABL_NO_ERROR) {
+		pr_warn("Kernel decompress while loading failed (err 0x%08x)\n", err);
+		kernel_decomp_stop();
+		return;
+	}
+	kernel_decomp_stream.fed += consumed;
+
+	if (kernel_decomp_stream.stream.done)
+		decompress_stream_end(&kernel_decomp_stream.stream);
+}
+#else
+static inline void kernel_decomp_feed(const uint8_t *end)
+{
+	(void)end;
+}
+#endif
+
+#if defined(KERNEL_STREAM_READ)
+static void kernel_stream_poll(struct tegrabl_partition *partition,
+	struct kernel_stream_read *rd, bool wait)
+{
+	tegrabl_error_t err;
+
+	while (rd->aio != NULL) {
+		err = tegrabl_partition_getstatus(partition, rd->aio);
+		if (TEGRABL_ERROR_REASON(err) != TEGRABL_ERR_BUSY) {
+			rd->aio = NULL;
+			rd->err = err;
+		} else if (!wait) {
+			break;
+		}
+	}
+}
+
+/*
+ * Read size bytes following the boot.img header into buf. The block aligned
+ * bulk is read asynchronously in chunks and each chunk is hashed and its part
+ * of kernel decompressed while the next one is in flight; the unaligned tail,
+ * if any, is read synchronously.
+ */
+static tegrabl_error_t read_kernel_partition_stream(
+	struct tegrabl_partition *partition, uint8_t *buf, uint32_t size)
+{
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	struct kernel_stream_read rd = { NULL, TEGRABL_NO_ERROR };
+	uint32_t block_size_log2;
+	uint32_t bulk_size;
+	uint32_t chunk_size;
+	uint32_t next_size;
+	uint32_t pos = 0;
+	uint32_t step;
+	uint32_t i;
+
+	block_size_log2 = TEGRABL_BLOCKDEV_BLOCK_SIZE_LOG2(partition->block_device);
+
+	if ((ANDROID_HEADER_SIZE & ((1U << block_size_log2) - 1U)) != 0U)
+		bulk_size = 0;
+	else
+		bulk_size = (size >> block_size_log2) << block_size_log2;
+
+	chunk_size = MIN(bulk_size, KERNEL_STREAM_CHUNK_SIZE);
+	if (chunk_size != 0U) {
+		rd.aio = tegrabl_partition_async_read(partition, buf,
+				ANDROID_HEADER_SIZE >> block_size_log2,
+				chunk_size >> block_size_log2);
+		if (rd.aio == NULL) {
+			err = TEGRABL_ERROR(TEGRABL_ERR_READ_FAILED, 0);
+			goto fail;
+		}
+	}
+
+	while (pos < bulk_size) {
+		kernel_stream_poll(partition, &rd, true);
+		if (rd.err != TEGRABL_NO_ERROR) {
+			err = rd.err;
+			goto fail;
+		}
+
+		next_size = MIN(bulk_size - (pos + chunk_size),
+						KERNEL_STREAM_CHUNK_SIZE);
+		if (next_size != 0U) {
+			rd.aio = tegrabl_partition_async_read(partition,
+					buf + pos + chunk_size,
+					(ANDROID_HEADER_SIZE + pos + chunk_size) >> block_size_log2,
+					next_size >> block_size_log2);
+			if (rd.aio == NULL) {
+				err = TEGRABL_ERROR(TEGRABL_ERR_READ_FAILED, 1);
+				goto fail;
+			}
+		}
+
+		for (i = 0; i < chunk_size; i += step) {
+			step = MIN(chunk_size - i, KERNEL_STREAM_HASH_STEP);
+			kernel_stream_hash(buf + pos + i, step);
+			kernel_decomp_feed(buf + pos + i + step);
+			kernel_stream_poll(partition, &rd, false);
+		}
+
+		pos += chunk_size;
+		chunk_size = next_size;
+	}
+
+	err = tegrabl_partition_seek(partition, ANDROID_HEADER_SIZE + pos,
+								 TEGRABL_PARTITION_SEEK_SET);
+	if (err != TEGRABL_NO_ERROR)
+		goto fail;
+
+	if (pos < size) {
+		err = tegrabl_partition_read(partition, buf + pos, size - pos);
+		if (err != TEGRABL_NO_ERROR)
+			goto fail;
+		kernel_stream_hash(buf + pos, size - pos);
+		kernel_decomp_feed(buf + size);
+	}
+
+fail:
+	/* Never leave a read targeting the load buffer behind */
+	kernel_stream_poll(partition, &rd, true);
+	kernel_stream_hash_wait();
+	if (err != TEGRABL_NO_ERROR) {
+#if defined(CONFIG_ENABLE_BOOTIMG_STREAM_HASH)
+		kernel_sha_stream.valid = false;
+#endif
+		TEGRABL_SET_HIGHEST_MODULE(err);
+	}
+#if defined(CONFIG_ENABLE_KERNEL_STREAM_DECOMPRESS)
+	/* Incomplete stream is of no use */
+	if ((err != TEGRABL_NO_ERROR) || !kernel_decomp_stream.started ||
+		!kernel_decomp_stream.stream.done)
+		kernel_decomp_stop();
+#endif
+	return err;
+}
+#endif
+
+#if defined(CONFIG_ENABLE_BOOTIMG_STREAM_HASH)
+
+struct se_sha_stream *tegrabl_loader_get_kernel_sha_stream(
+	const void *payload, uint64_t payload_size)
+{
+	kernel_stream_hash_wait();
+
+	if (!kernel_sha_stream.valid ||
+		(kernel_sha_stream.addr != (uintptr_t)payload) ||
+		(kernel_sha_stream.size != payload_size) ||
+		(kernel_sha_stream.hashed != payload_size)) {
+		return NULL;
+	}
+
+	return &kernel_sha_stream.sha;
+}
+#endif
+
+#if defined(CONFIG_ENABLE_KERNEL_STREAM_DECOMPRESS)
+void tegrabl_loader_set_kernel_decompress_buffer(void *buffer, uint32_t size)
+{
+	kernel_decomp_stop();
+	kernel_decomp_stream.out_buffer = buffer;
+	kernel_decomp_stream.outbuf_size = size;
+}
+
+bool tegrabl_loader_get_decompressed_kernel(const void *kernel,
+	uint32_t kernel_size, void *buffer, uint32_t *decomp_size)
+{
+	bool is_done;
+
+	is_done = kernel_decomp_stream.valid &&
+		kernel_decomp_stream.stream.done &&
+		(kernel_decomp_stream.addr == (uintptr_t)kernel) &&
+		(kernel_decomp_stream.size == kernel_size) &&
+		(kernel_decomp_stream.out_buffer == buffer);
+	if (is_done)
+		*decomp_size = kernel_decomp_stream.stream.written_size;
+
+	/* Buffer is handed over, later loads have to request it again */
+	kernel_decomp_stop();
+	kernel_decomp_stream.out_buffer = NULL;
+
+	return is_done;
+}
+#endif
+
+#if defined(CONFIG_ENABLE_BOOTIMG_SCATTER_LOAD)
+void tegrabl_loader_set_bootimg_scatter(void *kernel, uint32_t kernel_max,
+	void *ramdisk, uint32_t ramdisk_max)
+{
+	bootimg_scatter.kernel = kernel;
+	bootimg_scatter.kernel_max = kernel_max;
+	bootimg_scatter.ramdisk = ramdisk;
+	bootimg_scatter.ramdisk_max = ramdisk_max;
+	bootimg_scatter.image = 0;
+	bootimg_scatter.placed = 0;
+	bootimg_scatter.requested = true;
+}
+
+uint32_t tegrabl_loader_get_bootimg_scatter(const void *image)
+{
+	uint32_t placed = 0;
+
+	if (bootimg_scatter.image == (uintptr_t)image)
+		placed = bootimg_scatter.placed;
+
+	/* Destinations are handed over, later loads have to request them again */
+	bootimg_scatter.requested = false;
+	bootimg_scatter.image = 0;
+	bootimg_scatter.placed = 0;
+
+	return placed;
+}
+
+/* Returns whether scatter was requested, the request covers one image only */
+static bool bootimg_scatter_start(void *load_address)
+{
+	bool requested = bootimg_scatter.requested;
+
+	bootimg_scatter.requested = false;
+	bootimg_scatter.image = (uintptr_t)load_address;
+	bootimg_scatter.placed = 0;
+
+	return requested;
+}
+
+static tegrabl_error_t read_partition_at(struct tegrabl_partition *partition,
+	uint64_t offset, void *buf, uint32_t size)
+{
+	tegrabl_error_t err;
+
+	if (size == 0U)
+		return TEGRABL_NO_ERROR;
+
+	err = tegrabl_partition_seek(partition, (int64_t)offset,
+								 TEGRABL_PARTITION_SEEK_SET);
+	if (err != TEGRABL_NO_ERROR)
+		return err;
+
+	return tegrabl_partition_read(partition, buf, size);
+}
+
+/*
+ * Read the sections following the boot.img header. An uncompressed kernel and
+ * the ramdisk go straight to their requested destinations, everything else,
+ * including a compressed kernel which is yet to be decompressed, is read to
+ * its offset in the image.
+ */
+static tegrabl_error_t read_kernel_partition_scatter(
+	struct tegrabl_partition *partition, uint8_t *load_address,
+	uint32_t page_size)
+{
+	tegrabl_bootimg_header *hdr = (tegrabl_bootimg_header *)load_address;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	uint32_t kernel_end;
+	uint32_t ramdisk_end;
+	uint32_t image_end;
+	bool place_kernel;
+
+#if defined(CONFIG_ENABLE_BOOTIMG_STREAM_HASH)
+	/* Image is not contiguous, so it cannot be hashed while loading */
+	kernel_sha_stream.valid = false;
+#endif
+
+	kernel_end = page_size + ALIGN(hdr->kernel_size, page_size);
+	ramdisk_end = kernel_end + ALIGN(hdr->ramdisk_size, page_size);
+	image_end = ramdisk_end;
+#if CONFIG_BOOTIMG_HEADER_VERSION < 3
+	image_end += ALIGN(hdr->second_size, page_size);
+#endif
+	image_end += ALIGN(BOOT_IMG_SIG_SIZE, page_size);
+
+	/* Peek the kernel magic, compressed kernel is decompressed from image */
+	place_kernel = (bootimg_scatter.kernel != NULL) &&
+		(hdr->kernel_size >= 2U) &&
+		(hdr->kernel_size <= bootimg_scatter.kernel_max);
+	if (place_kernel) {
+		err = read_partition_at(partition, page_size,
+								load_address + page_size, 2);
+		if (err != TEGRABL_NO_ERROR)
+			goto fail;
+		place_kernel = (decompress_method(load_address + page_size, 2) == NULL);
+	}
+
+	if (place_kernel) {
+		err = read_partition_at(partition, page_size, bootimg_scatter.kernel,
+								hdr->kernel_size);
+		if (err != TEGRABL_NO_ERROR)
+			goto fail;
+		bootimg_scatter.placed |= TEGRABL_BOOTIMG_SCATTER_KERNEL;
+	} else {
+#if defined(KERNEL_STREAM_READ)
+		err = read_kernel_partition_stream(partition,
+										   load_address + ANDROID_HEADER_SIZE,
+										   kernel_end - ANDROID_HEADER_SIZE);
+#else
+		err = read_partition_at(partition, ANDROID_HEADER_SIZE,
+								load_address + ANDROID_HEADER_SIZE,
+								kernel_end - ANDROID_HEADER_SIZE);
+#endif
+		if (err != TEGRABL_NO_ERROR)
+			goto fail;
+	}
+
+	if ((bootimg_scatter.ramdisk != NULL) &&
+		(hdr->ramdisk_size <= bootimg_scatter.ramdisk_max)) {
+		err = read_partition_at(partition, kernel_end, bootimg_scatter.ramdisk,
+								hdr->ramdisk_size);
+		if (err != TEGRABL_NO_ERROR)
+			goto fail;
+		bootimg_scatter.placed |= TEGRABL_BOOTIMG_SCATTER_RAMDISK;
+	} else {
+		err = read_partition_at(partition, kernel_end,
+								load_address + kernel_end,
+								ramdisk_end - kernel_end);
+		if (err != TEGRABL_NO_ERROR)
+			goto fail;
+	}
+
+	/* second stage and signature */
+	err = read_partition_at(partition, ramdisk_end, load_address + ramdisk_end,
+							image_end - ramdisk_end);
+
+fail:
+	if (err != TEGRABL_NO_ERROR)
+		bootimg_scatter.placed = 0;
+	return err;
+}
+
+#if CONFIG_BOOTIMG_HEADER_VERSION >= 3
+/*
+ * Read vendor_boot.img with its ramdisk at the requested destination. Only
+ * the header and the sections are read rather than the whole partition.
+ */
+static tegrabl_error_t read_vendor_boot_partition(
+	struct tegrabl_partition *partition, uint8_t *load_address,
+	uint64_t *partition_size)
+{
+	tegrabl_vendor_bootimg_header *vndhdr;
+	tegrabl_error_t err = TEGRABL_NO_ERROR;
+	uint32_t ramdisk_start;
+	uint32_t ramdisk_end;
+	uint32_t image_end;
+
+	if (!bootimg_scatter_start(load_address)) {
+		err = tegrabl_partition_read(partition, load_address,
+									 *partition_size);
+		goto fail;
+	}
+
+	err = tegrabl_partition_read(partition, load_address, VENDOR_HEADER_SIZE);
+	if (err != TEGRABL_NO_ERROR)
+		goto fail;
+	vndhdr = (tegrabl_vendor_bootimg_header *)load_address;
+
+	if (strncmp((char *)vndhdr->magic, VENDOR_BOOT_MAGIC,
+				VENDOR_BOOT_MAGIC_SIZE)) {
+		/* not a vendor_boot.img, read the rest partition */
+		err = tegrabl_partition_read(partition,
+									 load_address + VENDOR_HEADER_SIZE,
+									 *partition_size - VENDOR_HEADER_SIZE);
+		goto fail;
+	}
+
+	ramdisk_start = ROUND_UP_POW2(VENDOR_HEADER_SIZE, vndhdr->page_size);
+	ramdisk_end = ramdisk_start +
+		ALIGN(vndhdr->vendor_ramdisk_size, vndhdr->page_size);
+	image_end = ramdisk_end + ALIGN(vndhdr->dtb_size, vndhdr->page_size);
+	if (image_end > *partition_size) {
+		pr_error("vendor_boot.img (%uB) is larger than partition\n",
+				 image_end);
+		err = TEGRABL_ERROR(TEGRABL_ERR_INVALID, 1);
+		goto fail;
+	}
+
+	if ((bootimg_scatter.ramdisk != NULL) &&
+		(vndhdr->vendor_ramdisk_size <= bootimg_scatter.ramdisk_max)) {
+		err = read_partition_at(partition, ramdisk_start,
+								bootimg_scatter.ramdisk,
+								vndhdr->vendor_ramdisk_size);
+		if (err != TEGRABL_NO_ERROR)
+			goto fail;
+		bootimg_scatter.placed |= TEGRABL_BOOTIMG_SCATTER_RAMDISK;
+	} else {
+		err = read_partition_at(partition, ramdisk_start,
+								load_address + ramdisk_start,
+								ramdisk_end - ramdisk_start);
+		if (err != TEGRABL_NO_ERROR)
+			goto fail;
+	}
+
+	/* dtb */
+	err = read_partition_at(partition, ramdisk_end, load_address + ramdisk_end,
+							image_end - ramdisk_end);
+	if (err != TEGRABL_NO_ERROR)
+		goto fail;
+
+	*partition_size = image_end;
+
+fail:
+	if (err != TEGRABL_NO_ERROR)
+		bootimg_scatter.placed = 0;
+	return err;
+}
+#endif
+#endif
+
 static tegrabl_error_t read_kernel_partition(
 	struct tegrabl_partition *partition, void *load_address,
 	uint64_t *partition_size)
@@ -207,6 +835,9 @@ static tegrabl_error_t read_kernel_partition(
 	uint32_t remain_size;
 	uint32_t page_size;
 	tegrabl_bootimg_header *hdr;
+#if defined(CONFIG_ENABLE_BOOTIMG_SCATTER_LOAD)
+	bool scatter;
+#endif
 
 	/* read head pages equal to android kernel header size */
 	err = tegrabl_partition_read(partition, load_address, ANDROID_HEADER_SIZE);
@@ -224,6 +855,13 @@ static tegrabl_error_t read_kernel_partition(
 	page_size = hdr->page_size;
 #endif
 
+#if defined(CONFIG_ENABLE_BOOTIMG_SCATTER_LOAD)
+	/* Sections are placed only for boot.img with header in its own pages */
+	scatter = bootimg_scatter_start(load_address) &&
+		!strncmp((char *)hdr->magic, BOOT_MAGIC, BOOT_MAGIC_SIZE) &&
+		(page_size >= ANDROID_HEADER_SIZE);
+#endif
+
 	if (!strncmp((char *)hdr->magic, BOOT_MAGIC, BOOT_MAGIC_SIZE)) {
 		/* for android kernel, read remaining kernel size */
 		/* align kernel/ramdisk/secondimage/signature size with page size */
@@ -250,10 +888,48 @@ static tegrabl_error_t read_kernel_partition(
 		remain_size = *partition_size - ANDROID_HEADER_SIZE;
 	}
 
+#if defined(KERNEL_STREAM_READ)
+#if defined(CONFIG_ENABLE_BOOTIMG_STREAM_HASH)
+	kernel_sha_stream.valid = false;
+	if (!strncmp((char *)hdr->magic, BOOT_MAGIC, BOOT_MAGIC_SIZE)) {
+		/* payload covered by the boot.img signature: all but the signature */
+		kernel_stream_start(load_address, (uint64_t)remain_size +
+							ANDROID_HEADER_SIZE -
+							ALIGN(BOOT_IMG_SIG_SIZE, page_size));
+		kernel_stream_hash(load_address, ANDROID_HEADER_SIZE);
+	}
+#endif
+#if defined(CONFIG_ENABLE_KERNEL_STREAM_DECOMPRESS)
+	kernel_decomp_stream.valid = false;
+	if (!strncmp((char *)hdr->magic, BOOT_MAGIC, BOOT_MAGIC_SIZE)) {
+		kernel_decomp_start((uint8_t *)load_address + page_size,
+							hdr->kernel_size);
+		kernel_decomp_feed((uint8_t *)load_address + ANDROID_HEADER_SIZE);
+	}
+#endif
+
+#if defined(CONFIG_ENABLE_BOOTIMG_SCATTER_LOAD)
+	if (scatter)
+		err = read_kernel_partition_scatter(partition, load_address,
+											page_size);
+	else
+#endif
+	/* read the remaining pages */
+	err = read_kernel_partition_stream(partition,
+									   (uint8_t *)load_address +
+									   ANDROID_HEADER_SIZE, remain_size);
+#else
+#if defined(CONFIG_ENABLE_BOOTIMG_SCATTER_LOAD)
+	if (scatter)
+		err = read_kernel_partition_scatter(partition, load_address,
+											page_size);
+	else
+#endif
 	/* read the remaining pages */
 	err = tegrabl_partition_read(partition,
 								 (char *)load_address + ANDROID_HEADER_SIZE,
 								 remain_size);
+#endif
 	if (err != TEGRABL_NO_ERROR) {
 		pr_error("Error reading kernel partition remaining pages\n");
 		TEGRABL_SET_HIGHEST_MODULE(err);
@@ -264,6 +940,76 @@ static tegrabl_error_t read_kernel_partition(
 	return err;
 }
 
+#if defined(CONFIG_ENABLE_PRELOADED_PARTITIONS)
+/* Forget images which overlap the given memory range */
+static void preloaded_drop_range(const void *addr, uint64_t size)
+{
+	uintptr_t start = (uintptr_t)addr;
+	uintptr_t end = start + size;
+	uint32_t i;
+
+	for (i = 0; i < MAX_PRELOADED_PARTITIONS; i++) {
+		if ((preloaded[i].addr == NULL) ||
+			((uintptr_t)preloaded[i].addr >= end) ||
+			(((uintptr_t)preloaded[i].addr + preloaded[i].size) <= start)) {
+			continue;
+		}
+		preloaded[i].addr = NULL;
+		preloaded[i].size = 0;
+		preloaded[i].name[0] = '\0';
+	}
+}
+
+static void preloaded_add(const char *partition_name, void *addr,
+						  uint64_t size)
+{
+	uint32_t i;
+
+	/* Whatever was in memory being overwritten is gone */
+	preloaded_drop_range(addr, size);
+
+	for (i = 0; i < MAX_PRELOADED_PARTITIONS; i++) {
+		if (preloaded[i].addr == NULL)
+			break;
+	}
+	if (i == MAX_PRELOADED_PARTITIONS) {
+		i = preloaded_next;
+		preloaded_next = (preloaded_next + 1U) % MAX_PRELOADED_PARTITIONS;
+	}
+
+	strncpy(preloaded[i].name, partition_name, TEGRABL_GPT_MAX_PARTITION_NAME);
+	preloaded[i].name[TEGRABL_GPT_MAX_PARTITION_NAME] = '\0';
+	preloaded[i].addr = addr;
+	preloaded[i].size = size;
+}
+
+void tegrabl_loader_drop_preloaded(const void *addr)
+{
+	if (addr != NULL)
+		preloaded_drop_range(addr, 1);
+}
+
+void *tegrabl_loader_get_preloaded(const char *partition_name,
+	uint64_t *size)
+{
+	uint32_t i;
+
+	if (partition_name == NULL)
+		return NULL;
+
+	for (i = 0; i < MAX_PRELOADED_PARTITIONS; i++) {
+		if ((preloaded[i].addr != NULL) &&
+			!strcmp(preloaded[i].name, partition_name)) {
+			if (size != NULL)
+				*size = preloaded[i].size;
+			return preloaded[i].addr;
+		}
+	}
+
+	return NULL;
+}
+#endif
+
 #if defined(CONFIG_OS_IS_L4T)
 #if defined(IS_T186)
 static tegrabl_error_t tegrabl_auth_payload(enum tegrabl_binary_type bin_type,
@@ -381,18 +1127,39 @@ tegrabl_error_t tegrabl_load_binary_copy(
 	if (bin_type == TEGRABL_BINARY_KERNEL)
 		err = read_kernel_partition(&partition, binary.load_address,
 									&partition_size);
+#if defined(CONFIG_ENABLE_BOOTIMG_SCATTER_LOAD) && \
+	(CONFIG_BOOTIMG_HEADER_VERSION >= 3)
+	else if (bin_type == TEGRABL_BINARY_KERNEL_VENDOR)
+		err = read_vendor_boot_partition(&partition, binary.load_address,
+										 &partition_size);
+#endif
 	else
 		err = tegrabl_partition_read(&partition, binary.load_address,
 									 partition_size);
 
 	if (err != TEGRABL_NO_ERROR) {
 		pr_error("Error reading partition %s\n", binary.partition_name);
+#if defined(CONFIG_ENABLE_PRELOADED_PARTITIONS)
+		preloaded_drop_range(binary.load_address, partition_size);
+#endif
 		TEGRABL_SET_HIGHEST_MODULE(err);
 		goto done;
 	}
 	if (binary_length)
 		*binary_length = partition_size;
 
+#if defined(CONFIG_ENABLE_PRELOADED_PARTITIONS)
+#if defined(CONFIG_ENABLE_BOOTIMG_SCATTER_LOAD)
+	/* Image with sections placed elsewhere is not the partition content */
+	if ((bootimg_scatter.image == (uintptr_t)binary.load_address) &&
+		(bootimg_scatter.placed != 0U))
+		preloaded_drop_range(binary.load_address, partition_size);
+	else
+#endif
+		preloaded_add(binary.partition_name, binary.load_address,
+					  partition_size);
+#endif
+
 	/* Handle validation of the binaries */
 #if defined(CONFIG_OS_IS_L4T)
 #if defined(IS_T186)
@@ -547,6 +547,32 @@ fail:
 	return err;
 }
 
+/**
+ * @brief Checks that a block of given size fits in destination buffer
+ * from given address onwards.
+ *
+ * @param auth Handle having information about destination.
+ * @param addr Start of the block in destination
+ * @param size Size of the block
+ *
+ * @return TEGRABL_NO_ERROR if block is within destination else
+ * TEGRABL_ERR_OVERFLOW.
+ */
+static tegrabl_error_t tegrabl_auth_check_dest_range(
+		struct tegrabl_auth_handle *auth, void *addr, uint32_t size)
+{
+	uintptr_t start = (uintptr_t)auth->dest_location;
+	uintptr_t end = start + auth->dest_size;
+
+	if (((uintptr_t)addr < start) || ((uintptr_t)addr > end) ||
+		(size > (end - (uintptr_t)addr))) {
+		pr_debug("Block @%p of size %d is outside destination\n", addr, size);
+		return TEGRABL_ERROR(TEGRABL_ERR_OVERFLOW, 0);
+	}
+
+	return TEGRABL_NO_ERROR;
+}
+
 tegrabl_error_t tegrabl_auth_process_block(struct tegrabl_auth_handle *auth,
 		void *buffer, uint32_t buffer_size, bool check_header)
 {
@@ -557,6 +583,7 @@ tegrabl_error_t tegrabl_auth_process_block(struct tegrabl_auth_handle *auth,
 	bool found_header = false;
 	struct tegrabl_auth_header_info *header_info = NULL;
 	uint32_t num_headers = 0;
+	bool in_place = false;
 
 	pr_debug("Processing block of size %d @%p\n", buffer_size, buffer);
 	if ((auth == NULL) || (buffer == NULL) || (buffer_size == 0)) {
@@ -576,6 +603,14 @@ tegrabl_error_t tegrabl_auth_process_block(struct tegrabl_auth_handle *auth,
 		goto fail;
 	}
 
+	/* Block loaded straight to its place is hashed/decrypted there, so only
+	 * the range it occupies needs to be checked instead of copying it.
+	 */
+	in_place = (buffer == safe_dest_location);
+	err = tegrabl_auth_check_dest_range(auth, safe_dest_location, buffer_size);
+	if (err != TEGRABL_NO_ERROR)
+		goto fail;
+
 	if (check_header) {
 		pr_debug("Checking for header\n");
 
@@ -611,7 +646,8 @@ tegrabl_error_t tegrabl_auth_process_block(struct tegrabl_auth_handle *auth,
 
 			if (header_info->validation_size < FULL_BINARY_VERIFY_THRESHOLD &&
 				header_info->binary_size > (buffer_size - HEADER_SIZE)) {
-				memcpy(safe_dest_location, buffer, buffer_size);
+				if (!in_place)
+					memcpy(safe_dest_location, buffer, buffer_size);
 				auth->remaining_size = header_info->binary_size -
 					(buffer_size - HEADER_SIZE);
 				auth->short_binary = true;
@@ -644,11 +680,12 @@ tegrabl_error_t tegrabl_auth_process_block(struct tegrabl_auth_handle *auth,
 	}
 
 	if (found_header) {
+		/* Strip the header. Payload loaded in place overlaps it. */
 		if (safe_dest_location != buffer) {
 			if ((buffer_size != 0) &&
 				(header_info->mode != TEGRABL_SIGNINGTYPE_NVIDIA_RSA) &&
 				(header_info->mode != TEGRABL_SIGNINGTYPE_OEM_RSA_SBK)) {
-				memcpy(safe_dest_location, buffer, buffer_size);
+				memmove(safe_dest_location, buffer, buffer_size);
 			}
 		}
 		goto done;
@@ -657,9 +694,11 @@ tegrabl_error_t tegrabl_auth_process_block(struct tegrabl_auth_handle *auth,
 	pr_debug("Applying operations in header %d on buffer @%p of size %d\n",
 				cur_header + 1, buffer, buffer_size);
 
-	/* this is needed for validation of small binaries like eks */
-	/* todo : optimize and remove memcpy */
-	if (header_info->mode == TEGRABL_SIGNINGTYPE_OEM_RSA_SBK)
+	/* Small binaries like eks are validated from destination once all of
+	 * them is there, otherwise SE decrypts the block to destination.
+	 */
+	if ((header_info->mode == TEGRABL_SIGNINGTYPE_OEM_RSA_SBK) &&
+		auth->short_binary && !in_place)
 		memcpy(safe_dest_location, buffer, buffer_size);
 
 	if (!auth->short_binary) {
@@ -669,7 +708,7 @@ tegrabl_error_t tegrabl_auth_process_block(struct tegrabl_auth_handle *auth,
 			goto fail;
 	}
 
-	if (safe_dest_location != buffer && header_info->mode != TEGRABL_SIGNINGTYPE_OEM_RSA_SBK &&
+	if (!in_place && header_info->mode != TEGRABL_SIGNINGTYPE_OEM_RSA_SBK &&
 		header_info->mode != TEGRABL_SIGNINGTYPE_NVIDIA_RSA) {
 		pr_debug("Copying from %p to %p\n", buffer, safe_dest_location);
 		memcpy(safe_dest_location, buffer, buffer_size);